@@ -0,0 +1,89 @@
+package com.negi.stt
+
+import kotlinx.serialization.Serializable
+import java.io.File
+import java.io.RandomAccessFile
+
+/**
+ * Persistent state of a batch re-transcription of the recordings library.
+ *
+ * Written (atomically) after every finished recording; within a recording, progress is
+ * kept by its [com.negi.nativelib.LongFileJob] journal. A state file left behind by a
+ * killed process is picked up again on the next start.
+ */
+@Serializable
+data class BatchQueueState(
+    val model: String,
+    val language: String,
+    val translate: Boolean,
+    /** Recordings still to do, shortest first. */
+    val pending: List<String>,
+    val total: Int,
+    val done: Int = 0,
+    val failed: Int = 0,
+    /** Audio transcribed so far, and the time spent on it (throttling pauses excluded). */
+    val audioMs: Long = 0,
+    val wallMs: Long = 0
+) {
+    /** Throughput: hours of audio transcribed per hour of running. */
+    val audioHoursPerWallHour: Float
+        get() = if (wallMs > 0) audioMs.toFloat() / wallMs else 0f
+}
+
+/**
+ * Duration of a WAV recording from its "fmt " byte rate and "data" size; 0 if the header
+ * can't be read. Walks the chunks, so the JUNK/ds64 chunk [com.negi.nativelib.WavWriter]
+ * reserves ahead of "fmt " is skipped, and takes the size from ds64 once the file is RF64.
+ * A data size of 0 (a recording cut off before its first flush) falls back to the rest of
+ * the file. Cheap enough to order a whole library.
+ */
+fun wavDurationMs(file: File): Long = try {
+    RandomAccessFile(file, "r").use { raf ->
+        val length = raf.length()
+        if (length < 12) return 0L
+        val id = ByteArray(4)
+        raf.readFully(id)
+        val rf64 = String(id, Charsets.US_ASCII) == "RF64"
+        raf.seek(12)
+
+        var byteRate = 0L
+        var dataSize64 = -1L
+        var dataOffset = -1L
+        var dataSize = 0L
+        while (dataOffset < 0 && raf.filePointer + 8 <= length) {
+            raf.readFully(id)
+            val size = raf.readLeU32()
+            val body = raf.filePointer
+            when (String(id, Charsets.US_ASCII)) {
+                "ds64" -> if (size >= 16) {
+                    raf.seek(body + 8)  // past riffSize64
+                    dataSize64 = raf.readLeU32() or (raf.readLeU32() shl 32)
+                }
+                "fmt " -> if (size >= 16) {
+                    raf.seek(body + 8)
+                    byteRate = raf.readLeU32()
+                }
+                "data" -> {
+                    dataOffset = body
+                    dataSize = if (rf64 && size == 0xFFFFFFFFL) dataSize64 else size
+                }
+            }
+            raf.seek(body + size + (size and 1))
+        }
+
+        val available = length - dataOffset
+        val bytes = if (dataSize <= 0L || dataSize > available) available else dataSize
+        if (byteRate <= 0L || dataOffset < 0) 0L else bytes * 1000 / byteRate
+    }
+} catch (e: Exception) {
+    0L
+}
+
+private fun RandomAccessFile.readLeU32(): Long {
+    val b = ByteArray(4)
+    readFully(b)
+    return (b[0].toLong() and 0xff) or
+        ((b[1].toLong() and 0xff) shl 8) or
+        ((b[2].toLong() and 0xff) shl 16) or
+        ((b[3].toLong() and 0xff) shl 24)
+}
@@ -118,6 +118,23 @@ fun MainScreen(
                     .fillMaxWidth()
             )
 
+            // Model load in the background (the current model keeps serving meanwhile)
+            if (viewModel.isModelLoading) {
+                Row(
+                    verticalAlignment = Alignment.CenterVertically,
+                    horizontalArrangement = Arrangement.spacedBy(8.dp)
+                ) {
+                    Text("Loading ${viewModel.selectedModel}", fontSize = 12.sp)
+                    LinearProgressIndicator(
+                        progress = { viewModel.modelLoadProgress },
+                        modifier = Modifier.weight(1f)
+                    )
+                    TextButton(onClick = { viewModel.cancelModelLoad() }) {
+                        Text("Cancel")
+                    }
+                }
+            }
+
             // Primary action button (Record / Stop)
             StyledButton(
                 text = if (isRecording) "Stop" else "Record",
@@ -148,7 +165,7 @@ fun MainScreen(
 /* ------------------ Config Button & Dialog ------------------ */
 
 /**
- * Config button that opens a dialog to change language/model/translate toggle.
+ * Config button that opens a dialog to change language/model/translate/hands-free toggles.
  *
  * Note: UI strings are English. Model list and language list are example defaults.
  */
@@ -168,7 +185,12 @@ fun ConfigButtonWithDialog(viewModel: MainScreenViewModel) {
                 Column(verticalArrangement = Arrangement.spacedBy(8.dp)) {
                     // Language selection
                     Text("Select language")
-                    val languages = listOf("en" to "English", "ja" to "Japanese", "sw" to "Swahili")
+                    val languages = listOf(
+                        "auto" to "Auto-detect",
+                        "en" to "English",
+                        "ja" to "Japanese",
+                        "sw" to "Swahili"
+                    )
                     DropdownSelector(
                         currentValue = viewModel.selectedLanguage,
                         options = languages,
@@ -203,6 +225,56 @@ fun ConfigButtonWithDialog(viewModel: MainScreenViewModel) {
                         )
                         Text("Translate to English")
                     }
+
+                    // Original + English from one encoder pass
+                    Row(verticalAlignment = Alignment.CenterVertically) {
+                        Checkbox(
+                            checked = viewModel.bilingual,
+                            onCheckedChange = { viewModel.updateBilingual(it) }
+                        )
+                        Text("Show original and English")
+                    }
+
+                    // Hands-free dictation (endpoint detection ends each utterance)
+                    Row(verticalAlignment = Alignment.CenterVertically) {
+                        Checkbox(
+                            checked = viewModel.handsFree,
+                            onCheckedChange = { viewModel.updateHandsFree(it) }
+                        )
+                        Text("Hands-free dictation")
+                    }
+
+                    // Carry the previous recordings' text into the next decode
+                    Row(verticalAlignment = Alignment.CenterVertically) {
+                        Checkbox(
+                            checked = viewModel.carryContext,
+                            onCheckedChange = { viewModel.updateCarryContext(it) }
+                        )
+                        Text("Carry context between recordings")
+                    }
+
+                    // Re-transcribe the whole library in the background (e.g. after a model switch)
+                    Spacer(Modifier.height(8.dp))
+                    if (viewModel.isBatchRunning) {
+                        OutlinedButton(onClick = { viewModel.stopRetranscribeAll() }) {
+                            Text("Stop re-transcribing")
+                        }
+                    } else {
+                        OutlinedButton(
+                            onClick = { viewModel.retranscribeAll() },
+                            enabled = viewModel.myRecords.isNotEmpty()
+                        ) {
+                            Text("Re-transcribe all recordings")
+                        }
+                    }
+                    viewModel.batchState?.let { batch ->
+                        Text(
+                            text = "${batch.done + batch.failed}/${batch.total} done" +
+                                (if (batch.failed > 0) " (${batch.failed} failed)" else "") +
+                                ", ${"%.1f".format(batch.audioHoursPerWallHour)} audio-h per wall-h",
+                            fontSize = 12.sp
+                        )
+                    }
                 }
             },
             confirmButton = {
@@ -3,11 +3,17 @@
 package com.negi.stt
 
 import android.Manifest
+import android.app.ActivityManager
 import android.app.Application
+import android.content.ComponentCallbacks2
+import android.content.res.Configuration
 import android.content.pm.PackageManager
 import android.icu.text.SimpleDateFormat
 import android.media.MediaPlayer
+import android.os.BatteryManager
 import android.os.Build
+import android.os.PowerManager
+import android.os.SystemClock
 import android.util.Log
 import androidx.annotation.RequiresPermission
 import androidx.compose.runtime.getValue
@@ -19,10 +25,24 @@ import androidx.core.net.toUri
 import androidx.lifecycle.ViewModel
 import androidx.lifecycle.ViewModelProvider
 import androidx.lifecycle.viewModelScope
+import com.negi.nativelib.EndpointConfig
+import com.negi.nativelib.LanguageGuess
+import com.negi.nativelib.LongFileJob
+import com.negi.nativelib.ModelManager
+import com.negi.nativelib.TranscriptionSession
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.Deferred
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.async
+import kotlinx.coroutines.cancelAndJoin
+import kotlinx.coroutines.channels.Channel
 import kotlinx.coroutines.delay
 import kotlinx.coroutines.flow.collectLatest
 import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
 import kotlinx.coroutines.withContext
 import kotlinx.serialization.KSerializer
 import kotlinx.serialization.builtins.ListSerializer
@@ -46,8 +66,18 @@ private const val LOG_TAG = "MainScreenViewModel"
  * Responsibilities:
  *  - keep UI-observable state for recording/transcription controls
  *  - manage persistent list of recordings (atomic write + fsync)
- *  - hold and release native resources (Whisper context, MediaPlayer)
+ *  - hold and release native resources (Whisper contexts, MediaPlayer); recently used
+ *    models stay loaded, so switching back to one is instant
  *  - provide safe start/stop recording flows
+ *  - hands-free dictation: the recorder's endpointer ends each utterance, which is
+ *    transcribed while the next one is already being recorded
+ *  - "auto" language: identified on the first seconds while still recording, so the
+ *    final decode runs with a fixed language
+ *  - context carryover: each new recording is decoded with the tail of the previous
+ *    results as prompt (same model, language and task)
+ *  - bilingual output: original text plus an English translation from one encoder pass
+ *  - batch re-transcription of the whole library in the background, shortest recording
+ *    first, resumed after a restart
  *
  * Note: This file expects types like MyRecord, Recorder and com.negi.nativelib.WhisperContext
  * to be available elsewhere in the project.
@@ -64,6 +94,10 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
     var isModelLoading by mutableStateOf(false)
         private set
 
+    /** Fraction of the model being loaded read so far (while [isModelLoading]). */
+    var modelLoadProgress by mutableStateOf(0f)
+        private set
+
     var isConfigDialogOpen by mutableStateOf(false)
         private set
 
@@ -79,15 +113,51 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
     var translateToEnglish by mutableStateOf(false)
         private set
 
+    var handsFree by mutableStateOf(false)
+        private set
+
+    var carryContext by mutableStateOf(false)
+        private set
+
+    var bilingual by mutableStateOf(false)
+        private set
+
     var hasAllRequiredPermissions by mutableStateOf(false)
         private set
 
+    /** The current or last batch re-transcription, null if there is none. */
+    var batchState by mutableStateOf<BatchQueueState?>(null)
+        private set
+
+    var isBatchRunning by mutableStateOf(false)
+        private set
+
     // ----- file & resource locations -----
     private val modelsPath = File(application.filesDir, "models")
     private val recordingsPath = File(application.filesDir, "recordings")
+    private val batchJournalPath = File(application.filesDir, "retranscribe")
+    private val batchStateFile = File(application.filesDir, "retranscribe_queue.json")
 
     // ----- native & playback handles -----
+    // Recently used models stay resident up to a quarter of the device's RAM; a new one
+    // is warmed up before it is swapped in.
+    private val modelManager = ModelManager(budgetBytes = modelBudgetBytes(application), warmUp = true)
     private var whisperContext: com.negi.nativelib.WhisperContext? = null
+    private var loadedModel: String? = null  // the model of whisperContext
+
+    // Under memory pressure only the current model stays resident.
+    private val trimCallbacks = object : ComponentCallbacks2 {
+        override fun onTrimMemory(level: Int) {
+            if (level >= ComponentCallbacks2.TRIM_MEMORY_BACKGROUND) {
+                viewModelScope.launch { modelManager.trimTo(0L) }
+            }
+        }
+
+        override fun onConfigurationChanged(newConfig: Configuration) = Unit
+
+        @Deprecated("Deprecated in Java")
+        override fun onLowMemory() = Unit
+    }
     private var mediaPlayer: MediaPlayer? = null
     private var currentRecordedFile: File? = null
 
@@ -97,6 +167,37 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
         viewModelScope.launch { isRecording = false }
     }
 
+    // Serializes start/stop between the record button and the endpoint watcher.
+    private val recordMutex = Mutex()
+    private var endpointJob: Job? = null
+    private var recordingHandsFree = false
+    private var recordingGeneration = 0
+
+    // Early language identification of the recording in progress ("auto" only), and the
+    // last confident result, reused for the following hands-free utterances.
+    private var languageJob: Deferred<LanguageGuess?>? = null
+    private var cachedLanguage: LanguageGuess? = null
+
+    // Decoder context carried between recordings while [carryContext] is on; reset whenever
+    // the language or task changes, recreated with the model.
+    private var contextSession: TranscriptionSession? = null
+    private var contextSessionKey: String? = null
+
+    // Finished utterances, transcribed one at a time (capture of the next may overlap).
+    private class PendingTranscription(
+        val captured: CapturedAudio,
+        val index: Int,
+        val playback: Boolean,
+        val language: Deferred<LanguageGuess?>?
+    )
+    private val pendingTranscriptions = Channel<PendingTranscription>(Channel.UNLIMITED)
+
+    // Model switch in progress (load, then swap), cancelled by a newer one.
+    private var modelSwitchJob: Job? = null
+
+    // Batch re-transcription of the library (see runBatch).
+    private var batchJob: Job? = null
+
     // Reusable JSON formatter for persistence
     private val jsonFormatter = Json {
         ignoreUnknownKeys = true
@@ -108,6 +209,8 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
     private val saveCounter = AtomicInteger(0)
 
     init {
+        application.registerComponentCallbacks(trimCallbacks)
+
         // Create dirs, load records, attempt to load default model, update permissions
         viewModelScope.launch {
             withContext(Dispatchers.IO) { setupDirectories() }
@@ -115,6 +218,14 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
             loadModel(selectedModel)
             updatePermissionsStatus()
             canTranscribe = true
+            resumeBatch()
+        }
+
+        viewModelScope.launch {
+            for (pending in pendingTranscriptions) {
+                val guess = pending.language?.await()
+                transcribeCaptured(pending.captured, pending.index, pending.playback, guess)
+            }
         }
 
         // Persist myRecords on change (skip the initial emission)
@@ -168,17 +279,50 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
 
     fun updateSelectedLanguage(lang: String) {
         selectedLanguage = lang
+        cachedLanguage = null
     }
 
+    /**
+     * Switch models; the current one keeps transcribing until the new one is loaded. A
+     * newer selection cancels a load still in progress. Switching drops an unfinished
+     * batch re-transcription (it was for the old model).
+     */
     fun updateSelectedModel(model: String) {
         selectedModel = model
-        viewModelScope.launch { loadModel(model) }
+        cachedLanguage = null
+        val previous = modelSwitchJob
+        modelSwitchJob = viewModelScope.launch {
+            previous?.cancelAndJoin()
+            discardBatch()
+            loadModel(model)
+        }
+    }
+
+    /** Stop a model load in progress; the current model stays. */
+    fun cancelModelLoad() {
+        modelSwitchJob?.cancel()
+        loadedModel?.let { selectedModel = it }
     }
 
     fun updateTranslate(toEnglish: Boolean) {
         translateToEnglish = toEnglish
     }
 
+    /** Hands-free takes effect from the next recording started. */
+    fun updateHandsFree(enabled: Boolean) {
+        handsFree = enabled
+    }
+
+    /** Original text plus English translation; replaces "Translate to English" while on. */
+    fun updateBilingual(enabled: Boolean) {
+        bilingual = enabled
+    }
+
+    fun updateCarryContext(enabled: Boolean) {
+        carryContext = enabled
+        if (!enabled) viewModelScope.launch { releaseContextSession() }
+    }
+
     // ----------------------
     // Record list management
     // ----------------------
@@ -204,6 +348,8 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
 
     /**
      * Toggle recording state. If recording is stopped, add record and start transcription.
+     * In hands-free mode each utterance is handed off by itself at its end while the
+     * microphone keeps running for the next one; tapping stop ends the dictation.
      * Caller must ensure RECORD_AUDIO permission is granted when calling this method.
      */
     @RequiresPermission(Manifest.permission.RECORD_AUDIO)
@@ -212,36 +358,16 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
         viewModelScope.launch {
             try {
                 if (isRecording) {
-                    // Stop recording path
-                    val file = currentRecordedFile
-                    if (file != null) {
-                        withContext(Dispatchers.IO) {
-                            recorder.stopRecording()
-                        }
-                        isRecording = false
-                        addNewRecordingLog(file.name, file.absolutePath)
-                        onUpdateIndex(myRecords.lastIndex)
-                        // small delay to ensure file flush before transcription
-                        delay(200)
-                        transcribeAudio(file)
-                    } else {
-                        Log.w(LOG_TAG, "No currentRecordedFile when stopping!")
-                        isRecording = false
-                    }
+                    endpointJob?.cancel()
+                    endpointJob = null
+                    finishRecording(onUpdateIndex)
                 } else {
-                    // Start recording path
                     if (!hasAllRequiredPermissions) {
                         Log.w(LOG_TAG, "Required permissions not granted; aborting start")
                         return@launch
                     }
                     stopPlayback()
-                    val file = createNewAudioFile()
-                    currentRecordedFile = file
-                    withContext(Dispatchers.IO) {
-                        recorder.startRecording(file)
-                    }
-                    isRecording = true
-                    Log.d(LOG_TAG, "Recording started: ${file.absolutePath}")
+                    beginRecording(onUpdateIndex)
                 }
             } catch (e: Exception) {
                 Log.e(LOG_TAG, "Recording error", e)
@@ -250,6 +376,142 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
         }
     }
 
+    @RequiresPermission(Manifest.permission.RECORD_AUDIO)
+    private suspend fun beginRecording(onUpdateIndex: (Int) -> Unit) {
+        recordMutex.withLock {
+            if (isRecording) return
+            val file = createNewAudioFile()
+            currentRecordedFile = file
+            val endpoint = if (handsFree) HANDS_FREE_ENDPOINT else null
+            withContext(Dispatchers.IO) {
+                recorder.startRecording(file, endpoint)
+            }
+            isRecording = true
+            recordingHandsFree = endpoint != null
+            val generation = ++recordingGeneration
+            languageJob = if (selectedLanguage == "auto") startLanguageId(generation) else null
+            Log.d(LOG_TAG, "Recording started: ${file.absolutePath} (handsFree=${endpoint != null})")
+
+            if (endpoint != null) watchEndpoint(onUpdateIndex)
+        }
+    }
+
+    @RequiresPermission(Manifest.permission.RECORD_AUDIO)
+    private fun watchEndpoint(onUpdateIndex: (Int) -> Unit) {
+        endpointJob = viewModelScope.launch {
+            if (recorder.awaitEndpoint()) onEndpoint(onUpdateIndex)
+        }
+    }
+
+    // End of utterance: hand it off right away and, while still hands-free, go on into the
+    // next record on the same capture so that nothing said meanwhile is lost.
+    @RequiresPermission(Manifest.permission.RECORD_AUDIO)
+    private suspend fun onEndpoint(onUpdateIndex: (Int) -> Unit) {
+        endpointJob = null
+        try {
+            if (handsFree && hasAllRequiredPermissions && splitRecording(onUpdateIndex)) return
+            finishRecording(onUpdateIndex)
+            if (handsFree && hasAllRequiredPermissions) beginRecording(onUpdateIndex)
+        } catch (e: Exception) {
+            Log.e(LOG_TAG, "Hands-free recording error", e)
+            isRecording = false
+        }
+    }
+
+    // False if the recorder couldn't split; the recording then goes on unchanged.
+    @RequiresPermission(Manifest.permission.RECORD_AUDIO)
+    private suspend fun splitRecording(onUpdateIndex: (Int) -> Unit): Boolean {
+        recordMutex.withLock {
+            if (!isRecording) return true
+            val file = currentRecordedFile ?: return false
+            val next = createNewAudioFile()
+            val captured = withContext(Dispatchers.IO) {
+                recorder.splitRecording(next)
+            } ?: return false
+            handOffRecording(file, captured, onUpdateIndex)
+            currentRecordedFile = next
+            val generation = ++recordingGeneration
+            languageJob = if (selectedLanguage == "auto") startLanguageId(generation) else null
+            Log.d(LOG_TAG, "Recording continues: ${next.absolutePath}")
+            watchEndpoint(onUpdateIndex)
+            return true
+        }
+    }
+
+    private suspend fun finishRecording(onUpdateIndex: (Int) -> Unit) {
+        recordMutex.withLock {
+            if (!isRecording) return
+            val file = currentRecordedFile
+            if (file == null) {
+                Log.w(LOG_TAG, "No currentRecordedFile when stopping!")
+                isRecording = false
+                return
+            }
+            val captured = withContext(Dispatchers.IO) {
+                recorder.stopRecording()
+            }
+            isRecording = false
+            handOffRecording(file, captured, onUpdateIndex)
+        }
+    }
+
+    // Locked by recordMutex.
+    private suspend fun handOffRecording(file: File, captured: CapturedAudio?, onUpdateIndex: (Int) -> Unit) {
+        addNewRecordingLog(file.name, file.absolutePath)
+        val index = myRecords.lastIndex
+        onUpdateIndex(index)
+        // Transcribe straight from the native capture buffer; the record index is
+        // fixed now because hands-free may add the next record before this finishes.
+        val language = languageJob
+        languageJob = null
+        if (captured != null) {
+            // No playback in hands-free mode: the microphone is live again.
+            pendingTranscriptions.send(
+                PendingTranscription(captured, index, playback = !recordingHandsFree, language)
+            )
+        } else {
+            language?.cancel()
+            Log.w(LOG_TAG, "Recorder returned no captured audio")
+        }
+    }
+
+    /**
+     * Identify the language on the first [LANGUAGE_ID_MS] of recording [generation] while it
+     * is still running. Utterances shorter than that yield null and the final decode detects
+     * the language itself. Hands-free utterances reuse the last confident result.
+     */
+    private fun startLanguageId(generation: Int): Deferred<LanguageGuess?> {
+        val cached = cachedLanguage
+        if (cached != null && recordingHandsFree) return CompletableDeferred(cached)
+
+        return viewModelScope.async {
+            val ctx = whisperContext ?: return@async null
+            while (generation == recordingGeneration && isRecording &&
+                recorder.capturedMs() < LANGUAGE_ID_MS
+            ) {
+                delay(LANGUAGE_ID_POLL_MS)
+            }
+            if (generation != recordingGeneration || !isRecording) return@async null
+
+            val snapshot = recorder.snapshotAudio(LANGUAGE_ID_MS) ?: return@async null
+            try {
+                // A new recording may have started while the snapshot was taken.
+                if (generation != recordingGeneration) return@async null
+                val start = System.currentTimeMillis()
+                val guesses = ctx.detectLanguage(snapshot, LANGUAGE_ID_MS)
+                Log.i(LOG_TAG, "Language id: $guesses in ${System.currentTimeMillis() - start} ms")
+                guesses.firstOrNull()?.also {
+                    if (it.probability >= LANGUAGE_CACHE_MIN_PROB) cachedLanguage = it
+                }
+            } catch (e: Exception) {
+                Log.w(LOG_TAG, "Language id failed", e)
+                null
+            } finally {
+                snapshot.close()
+            }
+        }
+    }
+
     // ----------------------
     // Playback helpers
     // ----------------------
@@ -270,24 +532,37 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
     // ----------------------
 
     /**
-     * Load a native whisper model from the app assets. This is a suspend method.
+     * Make [model] (from the app assets) the current one. A model still resident from
+     * earlier is switched to at once; otherwise it is loaded and warmed up in the background
+     * while the current model keeps serving, and swapped in when ready. Cancelling the caller
+     * cancels the load and leaves the current model in place. This is a suspend method.
      */
     private suspend fun loadModel(model: String) {
         isModelLoading = true
-        canTranscribe = false
+        modelLoadProgress = 0f
         try {
-            releaseWhisperContext()
-            releaseMediaPlayer()
-            whisperContext = withContext(Dispatchers.IO) {
-                com.negi.nativelib.WhisperContext.createContextFromAsset(
-                    application.assets, "models/$model"
-                )
+            val next = modelManager.fromAsset(application.assets, "models/$model") {
+                modelLoadProgress = it
+            }
+            Log.i(LOG_TAG, "loadModel: $model ready in ${modelManager.stats().lastAcquireMs} ms")
+            next.warmUpReport?.let {
+                Log.i(LOG_TAG, "loadModel: first request ${it.coldMs.toInt()} ms cold -> ${it.warmMs.toInt()} ms warm")
+            }
+            if (next !== whisperContext) {
+                // What belongs to the old model goes with it; then swap in one step.
+                stopBatch()
+                releaseContextSession()
+                whisperContext = next
+                loadedModel = model
+                modelManager.trimTo(modelManager.budgetBytes)
             }
+        } catch (e: CancellationException) {
+            Log.i(LOG_TAG, "loadModel: $model cancelled")
+            throw e
         } catch (e: Exception) {
             Log.e(LOG_TAG, "Failed to load model: $model", e)
         } finally {
             isModelLoading = false
-            canTranscribe = true
         }
     }
 
@@ -295,22 +570,112 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
      * Transcribe audio file using the loaded whisper context.
      * If index != -1, the result will be appended to the corresponding record's logs.
      */
-    private suspend fun transcribeAudio(file: File, index: Int = -1) {
+    private suspend fun transcribeAudio(
+        file: File,
+        index: Int = -1,
+        lang: String = selectedLanguage,
+        languageLabel: String = lang,
+        session: TranscriptionSession? = null
+    ) {
+        runTranscription(index, languageLabel, session) { ctx ->
+            val data = readAudioSamples(file)
+            ctx.transcribeData(data, lang, translateToEnglish, session = session)
+        }
+    }
+
+    /**
+     * Transcribe a just-finished recording from its native PCM buffer (no disk round trip).
+     * Recordings that outgrew the in-memory handoff fall back to the finished WAV file.
+     */
+    private suspend fun transcribeCaptured(
+        captured: CapturedAudio,
+        index: Int,
+        playback: Boolean,
+        language: LanguageGuess? = null
+    ) {
+        // A language identified while recording replaces "auto": no detection in the decode.
+        val lang = language?.code ?: selectedLanguage
+        val languageLabel = if (language != null) {
+            "$selectedLanguage → ${language.code} (${"%.2f".format(language.probability)})"
+        } else {
+            selectedLanguage
+        }
+        val session = sessionFor(lang)
+        val pcm = captured.pcm
+        if (pcm == null) {
+            transcribeAudio(captured.wavFile, index, lang, languageLabel, session)
+            return
+        }
+        try {
+            if (playback && captured.wavOk) {
+                stopPlayback()
+                startPlayback(captured.wavFile)
+            }
+            runTranscription(index, languageLabel, session) { ctx ->
+                if (bilingual) {
+                    val dual = ctx.transcribeDual(pcm, lang, session = session)
+                    buildString {
+                        appendLine(dual.primary)
+                        append("🔤 English   : ${dual.secondary ?: "(translation failed)"}")
+                    }
+                } else {
+                    ctx.transcribePcm(pcm, lang, translateToEnglish, session = session)
+                }
+            }
+        } finally {
+            pcm.close()
+        }
+    }
+
+    /**
+     * The context session for a new recording decoded in [lang], or null when carryover is
+     * off. Carried tokens are dropped when the language or task differs from the last run.
+     */
+    private suspend fun sessionFor(lang: String): TranscriptionSession? {
+        if (!carryContext) return null
+        val ctx = whisperContext ?: return null
+        val session = contextSession ?: try {
+            ctx.createSession(maxPromptTokens = CONTEXT_PROMPT_TOKENS).also { contextSession = it }
+        } catch (e: Exception) {
+            Log.w(LOG_TAG, "Couldn't create context session", e)
+            return null
+        }
+        val key = "$lang/${translateToEnglish && !bilingual}"
+        if (contextSessionKey != null && contextSessionKey != key) session.reset()
+        contextSessionKey = key
+        return session
+    }
+
+    /**
+     * Shared transcription flow: guards [canTranscribe], times [block] and appends the
+     * formatted result to the record at [index] (-1 = last record).
+     */
+    private suspend fun runTranscription(
+        index: Int,
+        languageLabel: String = selectedLanguage,
+        session: TranscriptionSession? = null,
+        block: suspend (com.negi.nativelib.WhisperContext) -> String
+    ) {
         if (!canTranscribe) return
         canTranscribe = false
         try {
-            val data = readAudioSamples(file)
             val start = System.currentTimeMillis()
-            val result = whisperContext?.transcribeData(data, selectedLanguage, translateToEnglish)
+            val loopsBefore = com.negi.nativelib.WhisperContext.loopGuardStats.total
+            val result = whisperContext?.let { block(it) }
+            val loops = com.negi.nativelib.WhisperContext.loopGuardStats.total - loopsBefore
             val elapsedMs = System.currentTimeMillis() - start
             val seconds = elapsedMs / 1000
             val milliseconds = elapsedMs % 1000
             val resultText = buildString {
                 appendLine("✅ Done.")
                 appendLine("🕒 Finished in ${seconds}.${"%03d".format(milliseconds)}s")
-                appendLine("🎯 Model     : $selectedModel")
-                appendLine("🌐 Language  : $selectedLanguage")
-                if (translateToEnglish) appendLine("🌐 Translate To Eng")
+                appendLine("🎯 Model     : ${loadedModel ?: selectedModel}")
+                appendLine("🌐 Language  : $languageLabel")
+                if (translateToEnglish && !bilingual) appendLine("🌐 Translate To Eng")
+                session?.lastPrefill?.let {
+                    appendLine("🔗 Context   : ${it.promptTokens} tokens, prefill ${"%.1f".format(it.prefillMs)} ms")
+                }
+                if (loops > 0) appendLine("🔁 Loops cut : $loops")
                 appendLine("📝 Converted Text Result")
                 appendLine(result ?: "")
             }
@@ -359,6 +724,183 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
         }
     }
 
+    // ----------------------
+    // Batch re-transcription
+    // ----------------------
+
+    /**
+     * Re-transcribe every recording in the background with the current model, language and
+     * task, shortest first; results are appended to the records one by one. Replaces an
+     * unfinished batch.
+     */
+    fun retranscribeAll() = viewModelScope.launch {
+        discardBatch()
+        val paths = myRecords.map { it.absolutePath }
+        val ordered = withContext(Dispatchers.IO) {
+            paths.map { File(it) }
+                .filter { it.exists() }
+                .sortedBy { wavDurationMs(it) }
+                .map { it.absolutePath }
+        }
+        if (ordered.isEmpty()) return@launch
+        val state = BatchQueueState(
+            model = selectedModel,
+            language = selectedLanguage,
+            translate = translateToEnglish,
+            pending = ordered,
+            total = ordered.size
+        )
+        saveBatchState(state)
+        startBatch(state)
+    }
+
+    /** Stop the batch re-transcription and forget it (results so far stay in the records). */
+    fun stopRetranscribeAll() = viewModelScope.launch { discardBatch() }
+
+    // Continue a batch left unfinished by the last process, on the model it was started with.
+    private suspend fun resumeBatch() {
+        val state = withContext(Dispatchers.IO) { loadBatchState() } ?: return
+        if (state.pending.isEmpty()) return
+        if (state.model != selectedModel) {
+            selectedModel = state.model
+            loadModel(state.model)
+        }
+        Log.i(LOG_TAG, "resumeBatch: ${state.pending.size}/${state.total} recordings left")
+        startBatch(state)
+    }
+
+    private fun startBatch(state: BatchQueueState) {
+        batchState = state
+        batchJob = viewModelScope.launch { runBatch(state) }
+    }
+
+    // Cancel the running batch; its state file and journals are kept for a resume.
+    private suspend fun stopBatch() {
+        batchJob?.cancelAndJoin()
+        batchJob = null
+    }
+
+    private suspend fun discardBatch() {
+        stopBatch()
+        batchState = null
+        withContext(Dispatchers.IO) {
+            batchStateFile.delete()
+            batchJournalPath.listFiles()?.forEach { it.delete() }
+        }
+    }
+
+    /**
+     * Work through [initial]'s recordings. Each one is a [LongFileJob] run at batch priority:
+     * streamed from the WAV file (no full decode, no playback), paused by recordings, and
+     * checkpointed to a journal after every 30 s window. The queue state is saved after each
+     * recording, so a killed process continues in the middle of the recording it was on.
+     */
+    private suspend fun runBatch(initial: BatchQueueState) {
+        var state = initial
+        isBatchRunning = true
+        try {
+            while (state.pending.isNotEmpty()) {
+                awaitBatchHeadroom()
+                val ctx = whisperContext ?: break
+                val path = state.pending.first()
+                val file = File(path)
+                val journal = File(batchJournalPath, "${file.name}.${state.model}.journal")
+                val start = SystemClock.elapsedRealtime()
+                var text: String? = null
+                val status = withContext(Dispatchers.IO) {
+                    val job = try {
+                        LongFileJob(file, journal)
+                    } catch (e: IllegalArgumentException) {
+                        Log.w(LOG_TAG, "runBatch: can't open $path", e)
+                        null
+                    }
+                    job?.use {
+                        ctx.runLongJob(it, state.language, state.translate).also { status ->
+                            if (status == LongFileJob.Status.DONE) {
+                                text = it.segments().joinToString("") { seg -> seg.text }.trim()
+                            }
+                        }
+                    } ?: LongFileJob.Status.FAILED
+                }
+                // Only stopped from outside (the context going away): keep the journal.
+                if (status == LongFileJob.Status.CANCELLED) break
+                val elapsedMs = SystemClock.elapsedRealtime() - start
+
+                addResultLogFor(path, buildString {
+                    if (text != null) {
+                        appendLine("🔁 Batch re-transcription")
+                        appendLine("🎯 Model     : ${state.model}")
+                        appendLine("🌐 Language  : ${state.language}")
+                        if (state.translate) appendLine("🌐 Translate To Eng")
+                        appendLine("📝 Converted Text Result")
+                        append(text)
+                    } else {
+                        append("⚠️ Batch re-transcription failed")
+                    }
+                })
+                withContext(Dispatchers.IO) { journal.delete() }
+
+                state = state.copy(
+                    pending = state.pending.drop(1),
+                    done = state.done + if (text != null) 1 else 0,
+                    failed = state.failed + if (text != null) 0 else 1,
+                    audioMs = state.audioMs + if (text != null) wavDurationMs(file) else 0L,
+                    wallMs = state.wallMs + elapsedMs
+                )
+                saveBatchState(state)
+                batchState = state
+                delay(BATCH_ITEM_GAP_MS)
+            }
+            if (state.pending.isEmpty()) {
+                Log.i(
+                    LOG_TAG,
+                    "runBatch: ${state.done}/${state.total} done, ${state.failed} failed, " +
+                        "${"%.2f".format(state.audioHoursPerWallHour)} audio-h per wall-h"
+                )
+                withContext(Dispatchers.IO) { batchStateFile.delete() }
+            }
+        } catch (e: CancellationException) {
+            throw e
+        } catch (e: Exception) {
+            Log.e(LOG_TAG, "runBatch failed", e)
+        } finally {
+            isBatchRunning = false
+        }
+    }
+
+    // Throttling: hold the batch while the device is hot, in power saving, or low on
+    // battery and unplugged.
+    private suspend fun awaitBatchHeadroom() {
+        val power = application.getSystemService(PowerManager::class.java)
+        val battery = application.getSystemService(BatteryManager::class.java)
+        while (true) {
+            val hot = power != null &&
+                (power.currentThermalStatus >= PowerManager.THERMAL_STATUS_MODERATE || power.isPowerSaveMode)
+            val low = battery != null && !battery.isCharging &&
+                battery.getIntProperty(BatteryManager.BATTERY_PROPERTY_CAPACITY) < BATCH_MIN_BATTERY_PERCENT
+            if (!hot && !low) return
+            delay(BATCH_THROTTLE_POLL_MS)
+        }
+    }
+
+    private suspend fun saveBatchState(state: BatchQueueState) = withContext(Dispatchers.IO) {
+        val bytes = jsonFormatter.encodeToString(BatchQueueState.serializer(), state)
+            .toByteArray(Charsets.UTF_8)
+        if (!writeAtomic(batchStateFile, bytes)) Log.e(LOG_TAG, "saveBatchState: writeAtomic failed")
+    }
+
+    private fun loadBatchState(): BatchQueueState? = try {
+        if (batchStateFile.exists()) {
+            jsonFormatter.decodeFromString(BatchQueueState.serializer(), batchStateFile.readText())
+        } else {
+            null
+        }
+    } catch (e: Exception) {
+        Log.w(LOG_TAG, "loadBatchState: unreadable, dropped", e)
+        batchStateFile.delete()
+        null
+    }
+
     /**
      * Start playback of [file] on the main thread.
      */
@@ -376,15 +918,26 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
     }
 
     /**
-     * Release native whisper context on IO dispatcher.
+     * Release every resident whisper context on IO dispatcher.
      */
     private suspend fun releaseWhisperContext() = withContext(Dispatchers.IO) {
         runCatching {
-            whisperContext?.release()
             whisperContext = null
+            modelManager.releaseAll()
         }
     }
 
+    /**
+     * Close the context session (before its whisper context goes away). Blocks on IO until
+     * a run that is using it has finished.
+     */
+    private suspend fun releaseContextSession() {
+        val session = contextSession ?: return
+        contextSession = null
+        contextSessionKey = null
+        withContext(Dispatchers.IO) { runCatching { session.close() } }
+    }
+
     /**
      * Release media player on main dispatcher.
      */
@@ -433,6 +986,12 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
         }
     }
 
+    /** [addResultLog] for the record of the recording at [path], if it is still listed. */
+    private fun addResultLogFor(path: String, text: String) {
+        val index = myRecords.indexOfFirst { it.absolutePath == path }
+        if (index >= 0) addResultLog(text, index)
+    }
+
     /**
      * Create new audio file name in recordings directory.
      */
@@ -444,6 +1003,7 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
     private fun setupDirectories() {
         modelsPath.mkdirs()
         recordingsPath.mkdirs()
+        batchJournalPath.mkdirs()
     }
 
     // ----------------------
@@ -663,16 +1223,28 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
 
     override fun onCleared() {
         super.onCleared()
+        application.unregisterComponentCallbacks(trimCallbacks)
+        endpointJob?.cancel()
+        languageJob?.cancel()
+        batchJob?.cancel()
+        pendingTranscriptions.close()
+        while (true) {
+            val pending = pendingTranscriptions.tryReceive().getOrNull() ?: break
+            pending.captured.pcm?.close()
+        }
         viewModelScope.launch {
             if (isRecording) {
                 try {
-                    withContext(Dispatchers.IO) { recorder.stopRecording() }
+                    withContext(Dispatchers.IO) {
+                        recorder.stopRecording()?.pcm?.close()
+                    }
                 } catch (t: Throwable) {
                     Log.w(LOG_TAG, "Failed to stop recorder on clear", t)
                 }
                 isRecording = false
             }
             runCatching { recorder.close() }
+            releaseContextSession()
             releaseWhisperContext()
             releaseMediaPlayer()
         }
@@ -683,6 +1255,34 @@ class MainScreenViewModel(private val application: Application) : ViewModel() {
     // ----------------------
 
     companion object {
+        // Hands-free endpointing; utterances are capped at one 30 s whisper window.
+        private val HANDS_FREE_ENDPOINT = EndpointConfig(
+            trailingSilenceMs = 700,
+            minSpeechMs = 300,
+            maxUtteranceMs = 30_000
+        )
+
+        // Early language identification window and the confidence needed to reuse it.
+        private const val LANGUAGE_ID_MS = 2500
+        private const val LANGUAGE_ID_POLL_MS = 100L
+        private const val LANGUAGE_CACHE_MIN_PROB = 0.8f
+
+        // Prompt tokens carried between recordings: enough for names and domain terms,
+        // short enough to keep the decoder prefill small.
+        private const val CONTEXT_PROMPT_TOKENS = 64
+
+        // Batch re-transcription throttling: a breather between recordings, and the
+        // battery level below which it waits for a charger.
+        private const val BATCH_ITEM_GAP_MS = 2_000L
+        private const val BATCH_THROTTLE_POLL_MS = 30_000L
+        private const val BATCH_MIN_BATTERY_PERCENT = 30
+
+        private fun modelBudgetBytes(application: Application): Long {
+            val info = ActivityManager.MemoryInfo()
+            application.getSystemService(ActivityManager::class.java)?.getMemoryInfo(info)
+            return info.totalMem / 4
+        }
+
         /**
          * Factory for creating MainScreenViewModel with Application parameter.
          */
@@ -9,31 +9,67 @@ import android.media.MediaRecorder
 import android.util.Log
 import androidx.annotation.RequiresPermission
 import androidx.core.content.ContextCompat
+import com.negi.nativelib.EndpointConfig
+import com.negi.nativelib.Endpointer
+import com.negi.nativelib.NativeCapture
+import com.negi.nativelib.PcmBuffer
+import com.negi.nativelib.WavWriter
 import kotlinx.coroutines.*
 import kotlinx.coroutines.asCoroutineDispatcher
 import kotlinx.coroutines.sync.Mutex
 import kotlinx.coroutines.sync.withLock
-import java.io.*
+import java.io.File
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
 import java.util.concurrent.Executors
 import java.util.concurrent.atomic.AtomicBoolean
 import kotlinx.coroutines.ExecutorCoroutineDispatcher
 import kotlinx.coroutines.runBlocking
 
 /**
- * PCM recording -> WAV writer utility.
+ * Result of a finished recording.
+ *
+ * [pcm] holds the captured samples in native memory and can be passed straight to
+ * WhisperContext.transcribePcm; it is null when the recording outgrew the in-memory
+ * handoff limit, in which case [wavFile] is the source to transcribe. [wavFile] is
+ * complete (header patched) when this object is returned; [wavOk] is false if writing
+ * it failed. The owner must close [pcm] when done.
+ */
+class CapturedAudio(
+    val pcm: PcmBuffer?,
+    val wavFile: File,
+    val wavOk: Boolean
+)
+
+/**
+ * PCM recording utility with zero-copy handoff to transcription.
  *
  * Usage:
  *  - call startRecording(outputFile) to begin recording (suspending)
- *  - call stopRecording() to stop and produce the wav file (suspending)
+ *  - call stopRecording() to stop; it returns a [CapturedAudio] as soon as the
+ *    capture loop has drained (suspending)
  *
  * Behavior notes:
+ *  - By default capture runs natively ([NativeCapture]: AAudio callback -> lock-free ring ->
+ *    native drain thread), so no audio passes through the JVM. AudioRecord below is the
+ *    fallback when AAudio cannot be opened, or when [useNativeCapture] is false.
  *  - AudioRecord is kept as a class-level reference so stopRecording() can call stop() to
  *    unblock a blocking read().
- *  - PCM is written to a temp file in cacheDir, then converted to WAV on stop.
- *  - WAV header size is checked to avoid 32-bit overflow.
+ *  - AudioRecord reads into a direct ByteBuffer that is appended to a native [PcmBuffer];
+ *    no temp file and no JVM-side sample conversion.
+ *  - The same buffer is streamed into the final WAV by [WavWriter] while recording;
+ *    stop only patches the header (RF64 past 4 GB, so there is no size limit).
+ *  - With an [EndpointConfig], end of speech is detected on the capture stream itself
+ *    (native endpointer on either path); [awaitEndpoint] resumes as soon as it fires so
+ *    the caller can transcribe without a manual tap. [splitRecording] then hands over the
+ *    utterance and keeps the microphone running into the next file, so nothing is lost
+ *    between utterances.
+ *  - The in-memory handoff is capped at [MAX_HANDOFF_MS]; longer recordings are still
+ *    written in full but must be transcribed from the WAV.
  */
 class Recorder(
     private val context: Context,
+    private val useNativeCapture: Boolean = true,
     private val onError: (Exception) -> Unit
 ) {
     private val handler = CoroutineExceptionHandler { _, throwable ->
@@ -51,10 +87,26 @@ class Recorder(
 
     // Shared state: access guarded by mutex to avoid races.
     private val stateMutex = Mutex()
-    private var tempPcmFile: File? = null
+    private var pcmBuffer: PcmBuffer? = null
+    private var nativeCapture: NativeCapture? = null
+    private var endpointWatcher: Job? = null
+
+    // Completed with true when the endpoint fires, false when the recording ends without one.
+    @Volatile
+    private var endpointSignal: CompletableDeferred<Boolean>? = null
+    private val handoffOverflow = AtomicBoolean(false)
+    private val wavFailed = AtomicBoolean(false)
     private var targetWavFile: File? = null
     private var currentConfig: ValidConfig? = null
 
+    // Native path: samples consumed before the last split (capturedMs counts from there).
+    private var splitOffset = 0L
+
+    // AudioRecord path: a split waiting for the capture loop, which owns the writer and buffer.
+    private class SplitRequest(val nextFile: File, val result: CompletableDeferred<CapturedAudio?>)
+    @Volatile
+    private var splitRequest: SplitRequest? = null
+
     // Keep audioRecord at class level so stopRecording() can call stop/release.
     @Volatile
     private var audioRecord: AudioRecord? = null
@@ -63,6 +115,7 @@ class Recorder(
      * Release internal resources. Call when this object is no longer needed.
      */
     fun close() {
+        recordingFlag.set(false)
         try {
             runBlocking {
                 // Ensure AudioRecord stopped and job cancelled on the single-threaded dispatcher.
@@ -76,10 +129,19 @@ class Recorder(
                         try { it.release() } catch (_: Throwable) {}
                         audioRecord = null
                     }
+                    nativeCapture?.let {
+                        // Stop first so the endpoint watcher wakes up before the session is freed.
+                        try { it.stop().pcm?.close() } catch (_: Throwable) {}
+                        endpointWatcher?.cancelAndJoin()
+                        endpointWatcher = null
+                        try { it.close() } catch (_: Throwable) {}
+                        nativeCapture = null
+                    }
                 }
                 job?.cancelAndJoin()
                 job = null
             }
+            cleanupTemp()
         } catch (t: Throwable) {
             // ignore
         } finally {
@@ -91,12 +153,73 @@ class Recorder(
     /** Returns true if currently recording. */
     fun isRecording(): Boolean = recordingFlag.get()
 
+    /** Milliseconds captured so far in the current recording (0 when idle). */
+    suspend fun capturedMs(): Long = stateMutex.withLock {
+        nativeCapture?.let { (it.stats.consumed - splitOffset) * 1000 / it.sampleRate }
+            ?: pcmBuffer?.durationMs
+            ?: 0L
+    }
+
+    /**
+     * Copy of the first [maxMs] of the recording in progress (e.g. for early language
+     * identification), or null if nothing is being captured. The caller owns the copy.
+     */
+    suspend fun snapshotAudio(maxMs: Int): PcmBuffer? = stateMutex.withLock {
+        nativeCapture?.snapshot(maxMs) ?: pcmBuffer?.copy(maxMs.toLong())
+    }
+
+    /**
+     * Suspend until the endpoint of the current recording is detected (true), or the
+     * recording ends without one (false). Only meaningful when recording was started with
+     * an [EndpointConfig].
+     */
+    suspend fun awaitEndpoint(): Boolean = endpointSignal?.await() ?: false
+
+    /**
+     * End the current recording here and go straight on into [nextFile] without stopping the
+     * microphone, e.g. at an endpoint in hands-free mode, so nothing said in between is lost.
+     * Returns the finished part as [stopRecording] does, or null if the recording could not
+     * be split (it then goes on unchanged). The endpoint is re-armed: call [awaitEndpoint]
+     * again for the next utterance.
+     */
+    suspend fun splitRecording(nextFile: File): CapturedAudio? = withContext(Dispatchers.IO) {
+        if (!recordingFlag.get()) return@withContext null
+        val native = stateMutex.withLock { nativeCapture }
+        if (native != null) splitNative(native, nextFile) else splitAudioRecord(nextFile)
+    }
+
+    // Under the state lock, so that no snapshot reads the buffer being handed off.
+    private suspend fun splitNative(native: NativeCapture, nextFile: File): CapturedAudio? =
+        stateMutex.withLock {
+            val wav = targetWavFile ?: return null
+            val captured = native.split(nextFile) ?: return null
+            targetWavFile = nextFile
+            splitOffset = native.stats.consumed
+            if (endpointSignal != null) endpointSignal = CompletableDeferred()
+            Log.i(TAG, "Recording split (native): ${wav.name} -> ${nextFile.name}, ok=${captured.wavOk}")
+            CapturedAudio(captured.pcm, wav, captured.wavOk)
+        }
+
+    // The capture loop cuts after its current read; null if it ends first.
+    private suspend fun splitAudioRecord(nextFile: File): CapturedAudio? {
+        val loop = job ?: return null
+        val request = SplitRequest(nextFile, CompletableDeferred())
+        splitRequest = request
+        loop.invokeOnCompletion { request.result.complete(null) }
+        return request.result.await()
+    }
+
     /**
-     * Start recording to a WAV target file. PCM is written to a temp file until stopRecording().
+     * Start recording to a WAV target file. PCM is kept in native memory until stopRecording().
      * This is a suspending function and does initialization on IO dispatcher.
+     *
+     * @param endpoint enables end-of-utterance detection (see [awaitEndpoint]), or null
      */
     @RequiresPermission(Manifest.permission.RECORD_AUDIO)
-    suspend fun startRecording(outputFile: File) = withContext(Dispatchers.IO) {
+    suspend fun startRecording(
+        outputFile: File,
+        endpoint: EndpointConfig? = null
+    ) = withContext(Dispatchers.IO) {
         if (recordingFlag.get()) {
             Log.w(TAG, "startRecording() ignored — already recording")
             return@withContext
@@ -114,6 +237,39 @@ class Recorder(
                 throw IllegalStateException("RECORD_AUDIO permission not granted")
             }
 
+            val signal = if (endpoint != null) CompletableDeferred<Boolean>() else null
+            endpointSignal = signal
+
+            // Preferred path: native AAudio capture streaming into PcmBuffer + WAV.
+            if (useNativeCapture) {
+                val native = NativeCapture.start(NATIVE_SAMPLE_RATE, outputFile, MAX_HANDOFF_MS, endpoint)
+                if (native != null) {
+                    stateMutex.withLock {
+                        nativeCapture = native
+                        targetWavFile = outputFile
+                        splitOffset = 0L
+                    }
+                    recordingFlag.set(true)
+                    if (signal != null) {
+                        // Blocks in native code; stop() wakes it, so stopping never waits on a timeout.
+                        // After an endpoint it idles until a split re-arms it with a new signal.
+                        endpointWatcher = scope.launch(Dispatchers.IO) {
+                            while (isActive && recordingFlag.get()) {
+                                val current = endpointSignal ?: break
+                                if (current.isCompleted) {
+                                    delay(ENDPOINT_POLL_MS.toLong())
+                                } else if (native.awaitEndpoint(ENDPOINT_POLL_MS)) {
+                                    current.complete(true)
+                                }
+                            }
+                        }
+                    }
+                    Log.i(TAG, "Recording started (native): rate=${native.sampleRate}, endpoint=$endpoint")
+                    return@withContext
+                }
+                Log.w(TAG, "Native capture unavailable; falling back to AudioRecord")
+            }
+
             // Find a working AudioRecord configuration.
             val config = findValidAudioConfig()
                 ?: throw IllegalStateException("No valid AudioRecord config found")
@@ -124,9 +280,12 @@ class Recorder(
                 targetWavFile = outputFile
             }
 
-            // Create a temporary PCM file in cache directory.
-            val tmp = File.createTempFile("rec_", ".pcm", context.cacheDir)
-            stateMutex.withLock { tempPcmFile = tmp }
+            // Native store the capture loop appends to (handoff to transcription).
+            val firstPcm = PcmBuffer(config.sampleRate)
+            stateMutex.withLock { pcmBuffer = firstPcm }
+            handoffOverflow.set(false)
+            wavFailed.set(false)
+            val maxHandoffSamples = config.sampleRate.toLong() * MAX_HANDOFF_MS / 1000
 
             // Build and store AudioRecord instance for cross-method control.
             val ar = buildAudioRecord(config)
@@ -136,57 +295,110 @@ class Recorder(
             }
             stateMutex.withLock { audioRecord = ar }
 
+            splitRequest = null
             recordingFlag.set(true)
 
             // Launch the recording loop on the dedicated dispatcher.
             job = scope.launch {
-                FileOutputStream(tmp).use { fos ->
-                    try {
-                        ar.startRecording()
-                        Log.i(TAG, "Recording started: rate=${config.sampleRate}, buf=${config.bufferSize}")
-
-                        // Prepare buffers for batch write (short -> little-endian bytes).
-                        val shortBuf = ShortArray(config.bufferSize / 2)
-                        val byteBuf = ByteArray(shortBuf.size * 2)
-
-                        while (isActive && recordingFlag.get()) {
-                            // read returns number of samples (shorts)
-                            val read = ar.read(shortBuf, 0, shortBuf.size)
-                            if (read > 0) {
-                                // Convert shorts to little-endian bytes in batch.
-                                var bi = 0
-                                for (i in 0 until read) {
-                                    val s = shortBuf[i].toInt()
-                                    byteBuf[bi++] = (s and 0xFF).toByte()
-                                    byteBuf[bi++] = ((s shr 8) and 0xFF).toByte()
+                var wav: WavWriter? = null
+                var wavFile = outputFile
+                var pcm = firstPcm
+                val endpointer = endpoint?.let { Endpointer(it, config.sampleRate) }
+                try {
+                    var writer = WavWriter(outputFile, config.sampleRate).also { wav = it }
+                    ar.startRecording()
+                    Log.i(TAG, "Recording started: rate=${config.sampleRate}, buf=${config.bufferSize}")
+
+                    // AudioRecord fills this direct buffer in place; native code appends it as-is.
+                    val chunk = ByteBuffer.allocateDirect(config.bufferSize).order(ByteOrder.LITTLE_ENDIAN)
+
+                    while (isActive && recordingFlag.get()) {
+                        // read returns number of bytes
+                        val read = ar.read(chunk, config.bufferSize)
+                        if (read > 0) {
+                            writer.write(chunk, read)
+                            if (endpointer?.feed(chunk, read) == true) {
+                                Log.i(TAG, "Endpoint detected")
+                                endpointSignal?.complete(true)
+                            }
+                            if (!handoffOverflow.get()) {
+                                if (pcm.sampleCount + read / 2 > maxHandoffSamples || !pcm.append(chunk, read)) {
+                                    Log.w(TAG, "In-memory handoff limit reached; transcription will read the WAV")
+                                    handoffOverflow.set(true)
                                 }
-                                fos.write(byteBuf, 0, read * 2)
-                            } else if (read == AudioRecord.ERROR_INVALID_OPERATION || read == AudioRecord.ERROR_BAD_VALUE) {
-                                throw RuntimeException("AudioRecord.read error code: $read")
-                            } else {
-                                // If read == 0, continue loop.
                             }
+                        } else if (read == AudioRecord.ERROR_INVALID_OPERATION || read == AudioRecord.ERROR_BAD_VALUE) {
+                            throw RuntimeException("AudioRecord.read error code: $read")
+                        } else {
+                            // If read == 0, continue loop.
                         }
 
-                        // Try to stop the AudioRecord gracefully.
-                        try {
-                            if (ar.recordingState == AudioRecord.RECORDSTATE_RECORDING) {
-                                ar.stop()
-                            }
+                        // Cut between two reads: the next read already goes to the new file.
+                        val request = splitRequest ?: continue
+                        splitRequest = null
+                        val nextWriter = try {
+                            WavWriter(request.nextFile, config.sampleRate)
+                        } catch (t: Throwable) {
+                            Log.e(TAG, "Split failed; recording continues", t)
+                            request.result.complete(null)
+                            continue
+                        }
+                        val nextPcm = PcmBuffer(config.sampleRate)
+                        stateMutex.withLock {
+                            pcmBuffer = nextPcm
+                            targetWavFile = request.nextFile
+                        }
+                        val wavOk = try {
+                            writer.close()
+                            !wavFailed.get()
                         } catch (t: Throwable) {
-                            Log.w(TAG, "Failed to stop AudioRecord gracefully", t)
+                            Log.e(TAG, "Failed to finalize WAV", t)
+                            false
+                        }
+                        val handoff = if (handoffOverflow.get()) { pcm.close(); null } else pcm
+                        request.result.complete(CapturedAudio(handoff, wavFile, wavOk))
+
+                        writer = nextWriter.also { wav = it }
+                        wavFile = request.nextFile
+                        pcm = nextPcm
+                        handoffOverflow.set(false)
+                        wavFailed.set(false)
+                        endpointer?.rearm()
+                        if (endpointSignal != null) endpointSignal = CompletableDeferred()
+                        Log.i(TAG, "Recording split -> ${request.nextFile.name}")
+                    }
+
+                    // Try to stop the AudioRecord gracefully.
+                    try {
+                        if (ar.recordingState == AudioRecord.RECORDSTATE_RECORDING) {
+                            ar.stop()
                         }
                     } catch (t: Throwable) {
-                        Log.e(TAG, "Error in recording loop", t)
-                        notifyError(t as? Exception ?: RuntimeException(t))
-                    } finally {
-                        try { ar.release() } catch (_: Throwable) {}
-                        stateMutex.withLock { audioRecord = null }
+                        Log.w(TAG, "Failed to stop AudioRecord gracefully", t)
                     }
+                } catch (t: Throwable) {
+                    Log.e(TAG, "Error in recording loop", t)
+                    notifyError(t as? Exception ?: RuntimeException(t))
+                } finally {
+                    // Patch the final header sizes (RIFF, or RF64 past 4 GB).
+                    try {
+                        wav?.close()
+                    } catch (t: Throwable) {
+                        Log.e(TAG, "Failed to finalize WAV", t)
+                        wavFailed.set(true)
+                    }
+                    if (wav == null) wavFailed.set(true)
+                    endpointer?.close()
+                    splitRequest?.result?.complete(null)
+                    splitRequest = null
+                    endpointSignal?.complete(false)
+                    try { ar.release() } catch (_: Throwable) {}
+                    stateMutex.withLock { audioRecord = null }
                 }
             }
         } catch (e: Exception) {
             notifyError(e)
+            endpointSignal?.complete(false)
             cleanupTemp()
             recordingFlag.set(false)
             stateMutex.withLock {
@@ -196,17 +408,30 @@ class Recorder(
     }
 
     /**
-     * Stop recording and write the WAV file from the temp PCM file.
-     * This is a suspending function and runs on IO dispatcher.
+     * Stop recording and hand the captured audio to the caller.
+     *
+     * Returns as soon as the capture loop has drained and the WAV header is patched.
+     * Returns null if nothing was recording or the capture failed.
      */
-    suspend fun stopRecording() = withContext(Dispatchers.IO) {
+    suspend fun stopRecording(): CapturedAudio? = withContext(Dispatchers.IO) {
         if (!recordingFlag.get()) {
             Log.w(TAG, "stopRecording() ignored — not recording")
-            return@withContext
+            return@withContext null
         }
 
         recordingFlag.set(false)
         try {
+            val native: NativeCapture?
+            val nativeWav: File?
+            stateMutex.withLock {
+                native = nativeCapture
+                nativeWav = targetWavFile
+                nativeCapture = null
+            }
+            if (native != null) {
+                return@withContext finishNative(native, checkNotNull(nativeWav) { "No target WAV file" })
+            }
+
             // Call stop() to unblock a possible blocking read().
             stateMutex.withLock {
                 audioRecord?.let {
@@ -222,25 +447,34 @@ class Recorder(
             job?.cancelAndJoin()
             job = null
 
-            // Snapshot state under mutex.
-            val pcm: File?
+            // Take ownership of the captured state under mutex.
+            val pcm: PcmBuffer?
             val wav: File?
-            val cfg: ValidConfig?
             stateMutex.withLock {
-                pcm = tempPcmFile
+                pcm = pcmBuffer
                 wav = targetWavFile
-                cfg = currentConfig
+                pcmBuffer = null
             }
 
-            if (pcm == null || wav == null || cfg == null) {
-                throw IllegalStateException("Incomplete state — cannot write WAV")
+            if (pcm == null || wav == null) {
+                pcm?.close()
+                throw IllegalStateException("Incomplete state — no captured audio")
             }
 
-            writeWavFromPcm(pcm, wav, cfg.sampleRate, 1, 16)
-            Log.i(TAG, "WAV written: ${wav.absolutePath}")
+            val wavOk = !wavFailed.get()
+            Log.i(TAG, "Capture finished: ${pcm.sampleCount} samples (${pcm.durationMs} ms), wav=${wav.length()} bytes ok=$wavOk")
+            if (handoffOverflow.get()) {
+                pcm.close()
+                CapturedAudio(null, wav, wavOk)
+            } else {
+                CapturedAudio(pcm, wav, wavOk)
+            }
         } catch (e: Exception) {
             notifyError(e)
+            null
         } finally {
+            endpointSignal?.complete(false)
+            endpointSignal = null
             cleanupTemp()
             // Ensure audioRecord released.
             stateMutex.withLock {
@@ -252,17 +486,37 @@ class Recorder(
         }
     }
 
+    // Stop the native session; the WAV is finalized and the buffer drained when this returns.
+    private suspend fun finishNative(native: NativeCapture, wav: File): CapturedAudio {
+        try {
+            val captured = native.stop()
+            // stop() woke the endpoint watcher; it must be gone before the session is freed.
+            endpointWatcher?.cancelAndJoin()
+            endpointWatcher = null
+            val stats = native.stats
+            Log.i(TAG, "Capture finished (native): ${stats.consumed} samples at ${native.sampleRate} Hz, " +
+                    "ring peak=${stats.ringPeak}, wav=${wav.length()} bytes ok=${captured.wavOk}")
+            if (stats.dropped > 0) Log.w(TAG, "Native capture dropped ${stats.dropped} samples")
+            if (captured.pcm == null) Log.w(TAG, "In-memory handoff limit reached; transcription will read the WAV")
+            return CapturedAudio(captured.pcm, wav, captured.wavOk)
+        } finally {
+            native.close()
+        }
+    }
+
     // Dispatch an error to main thread.
     private fun notifyError(e: Exception) {
         CoroutineScope(Dispatchers.Main).launch { onError(e) }
     }
 
-    // Cleanup temp state under mutex.
+    // Cleanup capture state under mutex. A buffer still owned here was never handed off.
     private fun cleanupTemp() {
         runBlocking {
             stateMutex.withLock {
-                try { tempPcmFile?.delete() } catch (_: Throwable) {}
-                tempPcmFile = null
+                try { pcmBuffer?.close() } catch (_: Throwable) {}
+                pcmBuffer = null
+                try { nativeCapture?.close() } catch (_: Throwable) {}
+                nativeCapture = null
                 targetWavFile = null
                 currentConfig = null
             }
@@ -326,67 +580,17 @@ class Recorder(
             .build()
     }
 
-    // ====== PCM -> WAV ======
-    private fun writeWavFromPcm(
-        pcmFile: File,
-        wavFile: File,
-        sampleRate: Int,
-        numChannels: Int,
-        bitsPerSample: Int
-    ) {
-        // Check PCM size doesn't overflow 32-bit WAV header fields.
-        val pcmSizeLong = pcmFile.length()
-        if (pcmSizeLong > Int.MAX_VALUE) {
-            throw IllegalStateException("PCM too large to write WAV header (size=${pcmSizeLong}). WAV RIFF uses 32-bit chunk sizes. Use RF64 or chunked strategy for files >2GB.")
-        }
-        val pcmSize = pcmSizeLong.toInt()
-        val byteRate = sampleRate * numChannels * bitsPerSample / 8
-        val totalDataLen = 36 + pcmSize
-
-        FileOutputStream(wavFile).use { out ->
-            DataOutputStream(out).use { dos ->
-                // Write ASCII headers explicitly.
-                dos.write("RIFF".toByteArray(Charsets.US_ASCII))
-                dos.writeIntLE(totalDataLen)
-                dos.write("WAVE".toByteArray(Charsets.US_ASCII))
-                dos.write("fmt ".toByteArray(Charsets.US_ASCII))
-                dos.writeIntLE(16)                    // Subchunk1Size = 16
-                dos.writeShortLE(1.toShort())         // AudioFormat = 1 (PCM)
-                dos.writeShortLE(numChannels.toShort())
-                dos.writeIntLE(sampleRate)
-                dos.writeIntLE(byteRate)
-                dos.writeShortLE((numChannels * bitsPerSample / 8).toShort()) // BlockAlign
-                dos.writeShortLE(bitsPerSample.toShort())                     // BitsPerSample
-                dos.write("data".toByteArray(Charsets.US_ASCII))
-                dos.writeIntLE(pcmSize)
-
-                FileInputStream(pcmFile).use { fis ->
-                    val buffer = ByteArray(4096)
-                    var read: Int
-                    while (fis.read(buffer).also { read = it } != -1) {
-                        dos.write(buffer, 0, read)
-                    }
-                }
-            }
-        }
-    }
+    companion object {
+        private const val TAG = "Recorder"
 
-    // Little-endian write helpers.
-    private fun DataOutputStream.writeIntLE(value: Int) {
-        write(value and 0xFF)
-        write((value shr 8) and 0xFF)
-        write((value shr 16) and 0xFF)
-        write((value shr 24) and 0xFF)
-    }
+        // Endpoint wait slice; the watcher re-checks the recording flag between slices.
+        private const val ENDPOINT_POLL_MS = 500
 
-    private fun DataOutputStream.writeShortLE(value: Short) {
-        val v = value.toInt()
-        write(v and 0xFF)
-        write((v shr 8) and 0xFF)
-    }
+        // Requested native capture rate; the device may deliver another one (resampled at stop).
+        private const val NATIVE_SAMPLE_RATE = 16000
 
-    companion object {
-        private const val TAG = "Recorder"
+        // Longest recording kept in memory for direct handoff (~55 MB at 16 kHz).
+        private const val MAX_HANDOFF_MS = 30L * 60 * 1000
     }
 }
 
@@ -14,12 +14,17 @@ import java.nio.ByteOrder
  *  - The function reads the entire file into memory; for very large files consider streaming.
  *  - The function validates RIFF/WAVE header and looks for "fmt " and "data" chunks.
  *  - Only PCM (audioFormat == 1) and bitsPerSample == 16 are accepted.
+ *  - RF64 headers (written by WavWriter past 4 GB) are recognized, but such files
+ *    are too large to decode in memory and are rejected with a clear error.
  *
  * @param file input WAV file
  * @return normalized float array (mono / averaged stereo)
  * @throws IllegalArgumentException for unsupported or malformed WAV files
  */
 fun decodeWaveFile(file: File): FloatArray {
+    if (file.length() > Int.MAX_VALUE) {
+        throw IllegalArgumentException("WAV too large to decode in memory (${file.length()} bytes)")
+    }
     val bytes = file.readBytes()
     if (bytes.size < 44) throw IllegalArgumentException("File too small to be a valid WAV")
 
@@ -28,7 +33,9 @@ fun decodeWaveFile(file: File): FloatArray {
     // RIFF header validation
     val riff = ByteArray(4)
     buffer.get(riff)
-    if (String(riff, Charsets.US_ASCII) != "RIFF") throw IllegalArgumentException("Invalid RIFF header")
+    val riffId = String(riff, Charsets.US_ASCII)
+    if (riffId == "RF64") throw IllegalArgumentException("RF64 WAV too large to decode in memory")
+    if (riffId != "RIFF") throw IllegalArgumentException("Invalid RIFF header")
 
     // skip chunk size
     buffer.int
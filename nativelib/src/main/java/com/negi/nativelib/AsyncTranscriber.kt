@@ -0,0 +1,99 @@
+package com.negi.nativelib
+
+import kotlinx.coroutines.CancellableContinuation
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.suspendCancellableCoroutine
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.atomic.AtomicLong
+import java.util.concurrent.locks.ReentrantReadWriteLock
+import kotlin.concurrent.read
+import kotlin.concurrent.write
+import kotlin.coroutines.resume
+import kotlin.coroutines.resumeWithException
+
+/**
+ * AsyncTranscriber
+ *
+ * Transcriptions that park no thread while they run. [transcribe] queues the audio on native
+ * worker threads (one whisper state each) and suspends; a single native thread, shared by
+ * every transcriber in the process, delivers the completions and resumes the callers. Any
+ * number of transcriptions can be in flight with only [workers] threads busy.
+ *
+ * Jobs run on their own states, beside the context's request queue.
+ * Cancelling the caller drops a queued job and aborts a running one.
+ *
+ * Create with [WhisperContext.createAsyncTranscriber]; the context closes it on release.
+ */
+class AsyncTranscriber internal constructor(
+    private var ptr: Long,
+    val workers: Int
+) : AutoCloseable {
+
+    // Native calls hold the read lock; close takes the write lock.
+    private val lock = ReentrantReadWriteLock()
+
+    // Tags of this transcriber's jobs whose callers are still suspended.
+    private val inFlight = ConcurrentHashMap.newKeySet<Long>()
+
+    init {
+        require(ptr != 0L) { "Couldn't create async transcriber" }
+    }
+
+    /**
+     * Transcribe [buffer] (copied when queued, so it may be closed once this suspends) into
+     * segments with times. Returns null if the run failed.
+     */
+    suspend fun transcribe(buffer: PcmBuffer, lang: String, translate: Boolean = false): List<TranscriptSegment>? {
+        val tag = nextTag.incrementAndGet()
+        try {
+            suspendCancellableCoroutine<Unit> { cont ->
+                pending[tag] = cont
+                inFlight += tag
+                val queued = lock.read {
+                    ptr != 0L && WhisperLib.asyncSubmit(ptr, tag, lang, translate, buffer.nativePtr)
+                }
+                if (!queued) {
+                    pending.remove(tag)
+                    inFlight -= tag
+                    cont.resumeWithException(IllegalStateException("Couldn't queue transcription"))
+                }
+            }
+        } catch (e: CancellationException) {
+            pending.remove(tag)
+            inFlight -= tag
+            // Drops the job if queued, aborts it if running, frees it if done.
+            lock.read { if (ptr != 0L) WhisperLib.asyncCancel(ptr, tag) }
+            throw e
+        }
+        inFlight -= tag
+        val times = arrayOfNulls<LongArray>(1)
+        val texts = lock.read { if (ptr != 0L) WhisperLib.asyncTake(ptr, tag, times) else null } ?: return null
+        val t = times[0] ?: return null
+        return texts.mapIndexed { i, text ->
+            TranscriptSegment(t[2 * i] * 10, t[2 * i + 1] * 10, text, confidence = Float.NaN)
+        }
+    }
+
+    override fun close() {
+        lock.write {
+            val p = ptr
+            if (p == 0L) return
+            ptr = 0L
+            WhisperLib.asyncRunnerFree(p)  // posts no completions for the jobs it drops
+        }
+        inFlight.forEach { tag ->
+            pending.remove(tag)?.resumeWithException(IllegalStateException("AsyncTranscriber closed"))
+        }
+        inFlight.clear()
+    }
+
+    internal companion object {
+        private val nextTag = AtomicLong()
+        private val pending = ConcurrentHashMap<Long, CancellableContinuation<Unit>>()
+
+        // Called from the native completion thread.
+        fun complete(tag: Long) {
+            pending.remove(tag)?.resume(Unit)
+        }
+    }
+}
@@ -0,0 +1,111 @@
+package com.negi.nativelib
+
+/**
+ * CommandSet
+ *
+ * A fixed set of voice commands compiled into a token trie of one model. Recognition with
+ * [WhisperContext.recognizeCommand] decodes only along the trie (no timestamps, a shrunk
+ * encoder context), so it costs a small fraction of a dictation run and always yields one
+ * of the commands, with a score that tells whether it was really said.
+ *
+ * Each rule is a phrase with an optional small grammar:
+ *  - `(a|b|c)` one of the alternatives,
+ *  - `[a]` optional,
+ * nested freely, e.g. `turn (on|off) [the] (light|fan)`. Rules are expanded once, here.
+ *
+ * Create with [WhisperContext.createCommandSet]. Holds no whisper state, but refers to the
+ * context that created it and is closed with it.
+ */
+class CommandSet internal constructor(
+    private var ptr: Long,
+    internal val owner: WhisperContext,
+    /** The rules as given. */
+    val rules: List<String>,
+    /** Every phrase the rules expand to; [CommandMatch.phrase] is one of these. */
+    val phrases: List<String>,
+    private val ruleOf: IntArray
+) : AutoCloseable {
+
+    init {
+        require(ptr != 0L) { "Couldn't compile the command set" }
+    }
+
+    internal val nativePtr: Long
+        get() = ptr.also { check(it != 0L) { "CommandSet already closed" } }
+
+    internal fun match(phraseIndex: Int, score: Float): CommandMatch? =
+        if (phraseIndex in phrases.indices) {
+            CommandMatch(ruleOf[phraseIndex], phrases[phraseIndex], score)
+        } else {
+            null
+        }
+
+    @Synchronized
+    override fun close() {
+        val p = ptr
+        if (p != 0L) {
+            ptr = 0L
+            WhisperLib.commandSetFree(p)
+        }
+    }
+
+    companion object {
+        /** Expand one rule into its phrases (words separated by single spaces). */
+        fun expand(rule: String): List<String> {
+            val parser = GrammarParser(rule)
+            val out = parser.sequence().map { it.trim().replace(WHITESPACE, " ") }
+            require(parser.atEnd()) { "Unbalanced grammar at ${parser.pos}: $rule" }
+            return out.filter { it.isNotEmpty() }.distinct()
+        }
+
+        private val WHITESPACE = Regex("\\s+")
+    }
+
+    // sequence := (text | '(' alternatives ')' | '[' alternatives ']')*
+    // alternatives := sequence ('|' sequence)*
+    private class GrammarParser(private val s: String) {
+        var pos = 0
+
+        fun atEnd() = pos == s.length
+
+        fun sequence(): List<String> {
+            var acc = listOf("")
+            while (pos < s.length) {
+                val c = s[pos]
+                val part: List<String> = when (c) {
+                    '(', '[' -> {
+                        pos++
+                        val alts = alternatives()
+                        val close = if (c == '(') ')' else ']'
+                        require(pos < s.length && s[pos] == close) { "Expected '$close' at $pos: $s" }
+                        pos++
+                        if (c == '[') alts + "" else alts
+                    }
+                    ')', ']', '|' -> return acc
+                    else -> {
+                        val start = pos
+                        while (pos < s.length && s[pos] !in "()[]|") pos++
+                        listOf(s.substring(start, pos))
+                    }
+                }
+                acc = acc.flatMap { a -> part.map { a + it } }
+                require(acc.size <= MAX_PHRASES) { "Grammar expands to more than $MAX_PHRASES phrases: $s" }
+            }
+            return acc
+        }
+
+        private fun alternatives(): List<String> {
+            val out = sequence().toMutableList()
+            while (pos < s.length && s[pos] == '|') {
+                pos++
+                out += sequence()
+            }
+            return out
+        }
+    }
+}
+
+/** Result of [WhisperContext.recognizeCommand]: the rule index, the phrase and its score (0..1). */
+data class CommandMatch(val rule: Int, val phrase: String, val score: Float)
+
+private const val MAX_PHRASES = 1024
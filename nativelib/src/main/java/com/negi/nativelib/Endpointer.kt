@@ -0,0 +1,62 @@
+package com.negi.nativelib
+
+import java.nio.ByteBuffer
+
+/**
+ * End-of-utterance detection settings.
+ *
+ * An endpoint fires once at least [minSpeechMs] of speech has been heard and is followed by
+ * [trailingSilenceMs] of silence, or [maxUtteranceMs] after speech started (0 = no limit).
+ */
+data class EndpointConfig(
+    val trailingSilenceMs: Int = 800,
+    val minSpeechMs: Int = 300,
+    val maxUtteranceMs: Int = 0
+) {
+    init {
+        require(trailingSilenceMs > 0) { "trailingSilenceMs must be positive" }
+        require(minSpeechMs >= 0 && maxUtteranceMs >= 0) { "durations must not be negative" }
+    }
+}
+
+/**
+ * Endpointer
+ *
+ * The native endpointer for capture paths that do not run natively (the AudioRecord
+ * fallback). [NativeCapture] runs the same detector on its drain thread instead.
+ * Not thread-safe: feed from the capture loop only.
+ */
+class Endpointer(config: EndpointConfig, sampleRate: Int) : AutoCloseable {
+
+    private var ptr: Long = WhisperLib.endpointerCreate(
+        sampleRate, config.trailingSilenceMs, config.minSpeechMs, config.maxUtteranceMs
+    )
+
+    init {
+        require(ptr != 0L) { "Couldn't create endpointer (rate=$sampleRate)" }
+    }
+
+    /**
+     * Feed [bytes] bytes of 16-bit mono PCM from a direct [buffer].
+     * Returns true exactly once, when the endpoint is reached.
+     */
+    fun feed(buffer: ByteBuffer, bytes: Int): Boolean {
+        require(buffer.isDirect) { "Endpointer.feed needs a direct ByteBuffer" }
+        check(ptr != 0L) { "Endpointer already closed" }
+        return WhisperLib.endpointerFeed(ptr, buffer, bytes)
+    }
+
+    /** Start on the next utterance of the same stream; the learned noise floor is kept. */
+    fun rearm() {
+        check(ptr != 0L) { "Endpointer already closed" }
+        WhisperLib.endpointerRearm(ptr)
+    }
+
+    override fun close() {
+        val p = ptr
+        if (p != 0L) {
+            ptr = 0L
+            WhisperLib.endpointerFree(p)
+        }
+    }
+}
@@ -4,9 +4,12 @@ import android.content.res.AssetManager
 import android.os.Build
 import android.util.Log
 import kotlinx.coroutines.*
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.flow
 import java.io.File
 import java.io.InputStream
-import java.util.concurrent.Executors
+import java.nio.ByteBuffer
+import java.util.concurrent.atomic.AtomicBoolean
 
 private const val LOG_TAG = "Whisper"
 
@@ -19,7 +22,7 @@ private const val LOG_TAG = "Whisper"
  * the device ABI and /proc/cpuinfo features (e.g. vfpv4, fp16). All JNI
  * declarations live here as @JvmStatic externals.
  */
-private object WhisperLib {
+internal object WhisperLib {
     init {
         // Log primary ABI for diagnostics.
         val abi = Build.SUPPORTED_ABIS.firstOrNull() ?: "unknown"
@@ -53,24 +56,280 @@ private object WhisperLib {
     @JvmStatic external fun initContext(modelPath: String): Long
     @JvmStatic external fun freeContext(contextPtr: Long)
 
+    // Observable loads (model_load.h); 0 on failure or cancel
+    @JvmStatic external fun modelLoadCreate(): Long
+    @JvmStatic external fun modelLoadFree(loadPtr: Long)
+    @JvmStatic external fun modelLoadCancel(loadPtr: Long)
+    @JvmStatic external fun modelLoadProgress(loadPtr: Long): LongArray?
+    @JvmStatic external fun initContextFromAssetObserved(assetManager: AssetManager, assetPath: String, loadPtr: Long): Long
+    @JvmStatic external fun initContextObserved(modelPath: String, loadPtr: Long): Long
+
+    // Huge pages / mlock for new mappings (hugepages.h); memApply: [bytes, huge, locked, regions, thp]
+    @JvmStatic external fun memSnapshotTake(): Long
+    @JvmStatic external fun memSnapshotFree(snapshotPtr: Long)
+    @JvmStatic external fun memApply(snapshotPtr: Long, contextPtr: Long, huge: Boolean, lock: Boolean): LongArray?
+
+    // [cold ms, warm ms, total ms, passes] or null (warmup.h)
+    @JvmStatic external fun warmUp(contextPtr: Long, numThreads: Int, clipMs: IntArray?): FloatArray?
+
     @JvmStatic external fun fullTranscribe(
         contextPtr: Long,
+        sessionPtr: Long,
         lang: String,
         numThreads: Int,
         translate: Boolean,
-        audioData: FloatArray
+        audioData: FloatArray,
+        deadlineMs: Long
     )
 
+    @JvmStatic external fun fullTranscribePcm(
+        contextPtr: Long,
+        sessionPtr: Long,
+        lang: String,
+        numThreads: Int,
+        translate: Boolean,
+        pcmPtr: Long,
+        deadlineMs: Long
+    )
+
+    @JvmStatic external fun fullTranscribeRange(
+        contextPtr: Long,
+        lang: String,
+        numThreads: Int,
+        translate: Boolean,
+        pcmPtr: Long,
+        startMs: Long,
+        endMs: Long,
+        prompt: String?
+    ): String?
+
+    @JvmStatic external fun fullTranscribeDual(
+        contextPtr: Long,
+        sessionPtr: Long,
+        lang: String,
+        numThreads: Int,
+        translate: Boolean,
+        secondLang: String?,
+        pcmPtr: Long
+    ): String?
+
+    // Extra whisper states for batch work (see WhisperContext.transcribeMany)
+    @JvmStatic external fun statePoolCreate(contextPtr: Long, nStates: Int): Long
+    @JvmStatic external fun statePoolFree(poolPtr: Long)
+
+    @JvmStatic external fun fullTranscribeMany(
+        poolPtr: Long,
+        lang: String,
+        numThreads: Int,
+        translate: Boolean,
+        pcmPtrs: LongArray
+    ): Array<String?>?
+
+    // Async transcription (see AsyncTranscriber)
+    @JvmStatic external fun asyncRunnerCreate(contextPtr: Long, nWorkers: Int, threadsPerJob: Int): Long
+    @JvmStatic external fun asyncRunnerFree(runnerPtr: Long)
+    @JvmStatic external fun asyncSubmit(runnerPtr: Long, tag: Long, lang: String, translate: Boolean, pcmPtr: Long): Boolean
+    @JvmStatic external fun asyncTake(runnerPtr: Long, tag: Long, timesOut: Array<LongArray?>): Array<String>?
+    @JvmStatic external fun asyncCancel(runnerPtr: Long, tag: Long)
+
+    /** Called by the native completion thread when async job [tag] has ended. */
+    @JvmStatic
+    fun onAsyncComplete(tag: Long) = AsyncTranscriber.complete(tag)
+
+    // Preemption of batch work (see RequestQueue)
+    @JvmStatic external fun preemptTokenCreate(): Long
+    @JvmStatic external fun preemptTokenFree(tokenPtr: Long)
+    @JvmStatic external fun preemptRequest(tokenPtr: Long)
+    @JvmStatic external fun preemptReset(tokenPtr: Long)
+    @JvmStatic external fun fullTranscribeResumable(
+        contextPtr: Long,
+        tokenPtr: Long,
+        lang: String,
+        numThreads: Int,
+        translate: Boolean,
+        pcmPtr: Long,
+        offsetMs: Long
+    ): Long
+
+    // Long-file jobs (see LongFileJob)
+    @JvmStatic external fun jobCreate(wavPath: String, journalPath: String): Long
+    @JvmStatic external fun jobFree(jobPtr: Long)
+    @JvmStatic external fun jobRun(
+        contextPtr: Long,
+        jobPtr: Long,
+        preemptPtr: Long,
+        lang: String,
+        numThreads: Int,
+        translate: Boolean,
+        restorePrompt: Boolean
+    ): Int
+    @JvmStatic external fun jobCancel(jobPtr: Long)
+    @JvmStatic external fun jobProgress(jobPtr: Long): LongArray
+
+    // Command mode (see CommandSet)
+    @JvmStatic external fun commandSetCreate(contextPtr: Long, phrases: Array<String>): Long
+    @JvmStatic external fun commandSetFree(commandPtr: Long)
+    @JvmStatic external fun commandRecognize(
+        commandPtr: Long,
+        lang: String?,
+        numThreads: Int,
+        pcmPtr: Long,
+        scoreOut: FloatArray
+    ): Int
+
+    // Context carryover (see TranscriptionSession)
+    @JvmStatic external fun sessionCreate(contextPtr: Long, initialPrompt: String?, maxPromptTokens: Int): Long
+    @JvmStatic external fun sessionReset(sessionPtr: Long)
+    @JvmStatic external fun sessionStats(sessionPtr: Long): FloatArray
+    @JvmStatic external fun sessionFree(sessionPtr: Long)
+
+    @JvmStatic external fun detectLanguage(
+        contextPtr: Long,
+        pcmPtr: Long,
+        maxMs: Int,
+        numThreads: Int,
+        probsOut: FloatArray
+    ): Array<String>?
+
     @JvmStatic external fun getTextSegmentCount(contextPtr: Long): Int
     @JvmStatic external fun getTextSegment(contextPtr: Long, index: Int): String
     @JvmStatic external fun getTextSegmentT0(contextPtr: Long, index: Int): Long
     @JvmStatic external fun getTextSegmentT1(contextPtr: Long, index: Int): Long
+    @JvmStatic external fun getTextSegmentConfidence(contextPtr: Long, index: Int): Float
+
+    // Native PCM buffer (see PcmBuffer)
+    @JvmStatic external fun pcmBufferCreate(sampleRate: Int): Long
+    @JvmStatic external fun pcmBufferAppend(pcmPtr: Long, buffer: ByteBuffer, bytes: Int): Boolean
+    @JvmStatic external fun pcmBufferCopy(pcmPtr: Long, maxSamples: Long): Long
+    @JvmStatic external fun pcmBufferSampleCount(pcmPtr: Long): Long
+    @JvmStatic external fun pcmBufferFree(pcmPtr: Long)
+    @JvmStatic external fun pcmBufferFromWav(path: String, startMs: Long, endMs: Long, infoOut: LongArray): Long
+
+    // Native capture (see NativeCapture)
+    @JvmStatic external fun captureStart(
+        sampleRate: Int,
+        ringMs: Int,
+        wavPath: String?,
+        maxHandoffMs: Long,
+        trailingSilenceMs: Int,
+        minSpeechMs: Int,
+        maxUtteranceMs: Int
+    ): Long
+    @JvmStatic external fun captureAwaitEndpoint(capturePtr: Long, timeoutMs: Int): Boolean
+    @JvmStatic external fun captureSampleRate(capturePtr: Long): Int
+    @JvmStatic external fun captureSnapshot(capturePtr: Long, maxMs: Int): Long
+    @JvmStatic external fun captureStats(capturePtr: Long): LongArray
+    @JvmStatic external fun captureStop(capturePtr: Long): LongArray?
+    @JvmStatic external fun captureSplit(capturePtr: Long, wavPath: String?): LongArray?
+    @JvmStatic external fun captureFree(capturePtr: Long)
+
+    // Endpointer (see Endpointer)
+    @JvmStatic external fun endpointerCreate(sampleRate: Int, trailingSilenceMs: Int, minSpeechMs: Int, maxUtteranceMs: Int): Long
+    @JvmStatic external fun endpointerFeed(endpointerPtr: Long, buffer: ByteBuffer, bytes: Int): Boolean
+    @JvmStatic external fun endpointerRearm(endpointerPtr: Long)
+    @JvmStatic external fun endpointerFree(endpointerPtr: Long)
+
+    // Streaming WAV writer (see WavWriter)
+    @JvmStatic external fun wavWriterOpen(path: String, sampleRate: Int): Long
+    @JvmStatic external fun wavWriterWrite(writerPtr: Long, buffer: ByteBuffer, bytes: Int): Boolean
+    @JvmStatic external fun wavWriterDataBytes(writerPtr: Long): Long
+    @JvmStatic external fun wavWriterClose(writerPtr: Long): Boolean
+
+    @JvmStatic external fun loopGuardStats(): IntArray
+    @JvmStatic external fun getDeadlineReport(contextPtr: Long): FloatArray?
 
     @JvmStatic external fun getSystemInfo(): String
     @JvmStatic external fun benchMemcpy(nthread: Int): String
     @JvmStatic external fun benchGgmlMulMat(nthread: Int): String
 }
 
+/** One language-identification candidate (ISO code such as "en", "ja"). */
+data class LanguageGuess(val code: String, val probability: Float)
+
+/** Result of [WhisperContext.transcribeDual]; [secondary] is null if that pass failed. */
+data class DualTranscript(val primary: String, val secondary: String?)
+
+/**
+ * One segment of a transcript. [confidence] is the mean probability of its text tokens;
+ * [refined] is true once a [WhisperContext.transcribeCascade] refiner re-decoded it.
+ */
+data class TranscriptSegment(
+    val startMs: Long,
+    val endMs: Long,
+    val text: String,
+    val confidence: Float,
+    val refined: Boolean = false
+)
+
+/**
+ * Decoder repetition loops cut short since the library was loaded: an n-gram repeated back
+ * to back, segments whose timestamps stopped advancing, or too few distinct tokens.
+ */
+data class LoopGuardStats(val repeats: Int, val stalls: Int, val lowVariety: Int) {
+    val total: Int
+        get() = repeats + stalls + lowVariety
+}
+
+/**
+ * What the last run with a deadline did: the plan it ran with ([audioCtx] 0 = the model's
+ * full context, [maxTokens] 0 = uncapped) and whether time ran out, in which case the
+ * transcript holds only the segments finished in time.
+ */
+data class DeadlineReport(
+    val budgetMs: Float,
+    val elapsedMs: Float,
+    val audioCtx: Int,
+    val maxTokens: Int,
+    val truncated: Boolean
+)
+
+/**
+ * A warm-up of a new context: [coldMs] is what the first request would have taken (the
+ * first pass), [warmMs] the same pass once warm.
+ */
+data class WarmUpReport(
+    val coldMs: Float,
+    val warmMs: Float,
+    val totalMs: Float,
+    val passes: Int
+)
+
+/**
+ * How a context's memory is backed (Linux / Android): [hugePages] advises its weights and
+ * compute buffers MADV_HUGEPAGE and collapses them into huge pages right away where the
+ * kernel can, [lock] mlocks them (bounded by RLIMIT_MEMLOCK) until the context is released.
+ * The memory is found as the native mappings that appeared during the load, so loads with
+ * options run one at a time. See hugepages.h.
+ */
+data class MemoryOptions(
+    val hugePages: Boolean = false,
+    val lock: Boolean = false
+)
+
+/**
+ * What [MemoryOptions] obtained: of the [bytes] newly mapped during the load, [hugeBytes] sit
+ * in huge pages and [lockedBytes] are locked. These can include large native allocations
+ * other threads made meanwhile (a transcription's PCM copy, say), not only the context's.
+ * [thpAvailable] is false when the system has transparent huge pages off (most Android
+ * kernels), in which case none are obtained.
+ */
+data class MemoryReport(
+    val bytes: Long,
+    val hugeBytes: Long,
+    val lockedBytes: Long,
+    val regions: Int,
+    val thpAvailable: Boolean
+)
+
+/** Progress of [WhisperContext.transcribeCascade]. */
+sealed interface CascadeUpdate {
+    /** First pass of the fast model; every segment as decoded there. */
+    data class Draft(val segments: List<TranscriptSegment>) : CascadeUpdate
+
+    /** Segment [index] of the draft after re-decoding on the refiner. */
+    data class Refined(val index: Int, val segment: TranscriptSegment) : CascadeUpdate
+}
+
 /**
  * WhisperContext
  *
@@ -78,19 +337,34 @@ private object WhisperLib {
  *
  * Key points:
  *  - Whisper.cpp is generally NOT thread-safe for concurrent inference, so we
- *    run all native calls on a dedicated single-threaded executor.
+ *    run all native calls on one dedicated thread, fed by a [RequestQueue]:
+ *    interactive requests first, then batch work, then benchmarks.
  *  - Callers must release the native resources by calling [release] or by using
  *    Kotlin's use/try-with-resources via [close].
  */
 class WhisperContext private constructor(
-    private var ptr: Long
+    private var ptr: Long,
+    requestLimits: Map<RequestPriority, Int>
 ) : AutoCloseable {
 
-    // Dedicated single-threaded dispatcher for all native calls.
-    private val executor = Executors.newSingleThreadExecutor()
-    private val dispatcher = executor.asCoroutineDispatcher()
+    // Dedicated thread for all native calls; plain withContext(scope.coroutineContext)
+    // runs at interactive priority, see onQueue for the other classes.
+    private val queue = RequestQueue("whisper-context", requestLimits)
+    private val dispatcher = queue.dispatcher(RequestPriority.INTERACTIVE)
     private val scope: CoroutineScope = CoroutineScope(dispatcher + SupervisorJob())
 
+    // Signalled by the queue to stop the running batch request (preempt.h); one batch
+    // request runs at a time. Freed on release.
+    private val preemptToken: Long = WhisperLib.preemptTokenCreate()
+
+    // Whisper states for batch work, created on first use (only touched on the queue thread).
+    private var statePool: Long = 0L
+    private var statePoolSize = 0
+
+    // Native objects tied to this context (command sets, async runners); closed before the context
+    // is freed. Guarded by itself.
+    private val dependents = mutableListOf<AutoCloseable>()
+
     /**
      * Transcribe PCM float data via native whisper.
      *
@@ -98,6 +372,11 @@ class WhisperContext private constructor(
      * @param lang language code (e.g. "en", "ja", "sw")
      * @param translate whether to run translation
      * @param printTimestamp if true, include [T0 - T1] timestamps for each segment in the returned text
+     * @param session carries the previous results' context into this run (null = start cold)
+     * @param deadlineMs > 0 fits the run into this many milliseconds: temperature fallback is
+     *   off, the plan is degraded (smaller audio context, capped tokens) when the measured cost
+     *   says it will not fit, and windows out of time are cut, so the text may be partial (see
+     *   [lastDeadline])
      *
      * Note: This function dispatches the native calls to the dedicated single-threaded dispatcher
      * to avoid concurrent access to the native context.
@@ -106,7 +385,9 @@ class WhisperContext private constructor(
         data: FloatArray,
         lang: String,
         translate: Boolean,
-        printTimestamp: Boolean = true
+        printTimestamp: Boolean = true,
+        session: TranscriptionSession? = null,
+        deadlineMs: Long = 0L
     ): String = withContext(scope.coroutineContext) {
         require(ptr != 0L) { "WhisperContext already released" }
 
@@ -115,9 +396,471 @@ class WhisperContext private constructor(
         Log.d(LOG_TAG, "Whisper inference: threads=$numThreads, lang=$lang, translate=$translate")
 
         // Call native fullTranscribe (this will populate internal native buffers / segments).
-        WhisperLib.fullTranscribe(ptr, lang, numThreads, translate, data)
+        withSession(session) { sessionPtr ->
+            WhisperLib.fullTranscribe(ptr, sessionPtr, lang, numThreads, translate, data, deadlineMs)
+        }
+        collectText(printTimestamp)
+    }
+
+    /**
+     * Transcribe audio captured into a native [PcmBuffer] without copying it through the JVM.
+     *
+     * The buffer is converted to 16 kHz float on the native side (resampling if it was
+     * captured at another rate). The buffer stays owned by the caller. See [transcribeData]
+     * for [session] and [deadlineMs].
+     */
+    suspend fun transcribePcm(
+        buffer: PcmBuffer,
+        lang: String,
+        translate: Boolean,
+        printTimestamp: Boolean = true,
+        session: TranscriptionSession? = null,
+        deadlineMs: Long = 0L
+    ): String = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext already released" }
+
+        val numThreads = WhisperCpuConfig.preferredThreadCount
+        Log.d(LOG_TAG, "Whisper inference (pcm): samples=${buffer.sampleCount}, threads=$numThreads, lang=$lang")
+
+        withSession(session) { sessionPtr ->
+            WhisperLib.fullTranscribePcm(
+                ptr, sessionPtr, lang, numThreads, translate, buffer.nativePtr, deadlineMs
+            )
+        }
+        collectText(printTimestamp)
+    }
+
+    /** What the [MemoryOptions] given at creation obtained; null if none were given. */
+    var memoryReport: MemoryReport? = null
+        private set
+
+    /** The last warm-up of this context ([warmUp], or at creation), null if none succeeded. */
+    @Volatile var warmUpReport: WarmUpReport? = null
+        private set
+
+    /**
+     * Bring the context to steady-state latency: tiny transcriptions of silence for the
+     * encoder buckets of [clipMs] (null = 2 s, 10 s and a full 30 s window) with the
+     * configured thread count. They build the graphs and prefault the weights, which the
+     * first real request would otherwise pay for (see warmup.h). Returns null if a pass
+     * failed.
+     */
+    suspend fun warmUp(clipMs: IntArray? = null): WarmUpReport? = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext already released" }
+        warmUpNow(clipMs)
+    }
+
+    // Caller owns the native thread (the queue, or a factory before anyone else has it).
+    private fun warmUpNow(clipMs: IntArray?): WarmUpReport? =
+        WhisperLib.warmUp(ptr, WhisperCpuConfig.preferredThreadCount, clipMs)?.let {
+            WarmUpReport(it[0], it[1], it[2], it[3].toInt())
+        }?.also { warmUpReport = it }
+
+    /** Report of the last run with a deadline on this context, or null if there was none. */
+    suspend fun lastDeadline(): DeadlineReport? = withContext(scope.coroutineContext) {
+        if (ptr == 0L) return@withContext null
+        WhisperLib.getDeadlineReport(ptr)?.let {
+            DeadlineReport(it[0], it[1], it[2].toInt(), it[3].toInt(), it[4] != 0f)
+        }
+    }
+
+    /**
+     * Transcribe [buffer] and decode the same encoder output a second time: an English
+     * translation when [secondLang] is null, otherwise a transcription in [secondLang].
+     *
+     * For audio up to one 30 s window the encoder runs once and the second pass costs only
+     * decoder time. Longer audio falls back to two full runs. The second text has no
+     * timestamps. Only the primary pass uses [session].
+     */
+    suspend fun transcribeDual(
+        buffer: PcmBuffer,
+        lang: String,
+        secondLang: String? = null,
+        translate: Boolean = false,
+        printTimestamp: Boolean = true,
+        session: TranscriptionSession? = null
+    ): DualTranscript = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext already released" }
+
+        val numThreads = WhisperCpuConfig.preferredThreadCount
+        Log.d(LOG_TAG, "Whisper dual inference: samples=${buffer.sampleCount}, lang=$lang, second=${secondLang ?: "translate"}")
+
+        var secondary: String? = null
+        withSession(session) { sessionPtr ->
+            secondary = WhisperLib.fullTranscribeDual(
+                ptr, sessionPtr, lang, numThreads, translate, secondLang, buffer.nativePtr
+            )
+        }
+        DualTranscript(collectText(printTimestamp), secondary)
+    }
+
+    /**
+     * Transcribe [buffer] and return its segments with times and [TranscriptSegment.confidence].
+     */
+    suspend fun transcribeSegments(
+        buffer: PcmBuffer,
+        lang: String,
+        translate: Boolean
+    ): List<TranscriptSegment> = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext already released" }
 
-        // Read out text segments and optionally include timestamps.
+        val numThreads = WhisperCpuConfig.preferredThreadCount
+        WhisperLib.fullTranscribePcm(ptr, 0L, lang, numThreads, translate, buffer.nativePtr, 0L)
+        collectSegments()
+    }
+
+    /**
+     * [transcribeSegments] as background work ([RequestPriority.BATCH]): it runs when no
+     * interactive request is queued, and one that arrives meanwhile stops it at the next 30 s
+     * window; it continues from there (without the text before as context) once the
+     * interactive request is done. Returns null if a run failed.
+     */
+    suspend fun transcribeInBackground(
+        buffer: PcmBuffer,
+        lang: String,
+        translate: Boolean
+    ): List<TranscriptSegment>? = queue.admit(RequestPriority.BATCH) {
+        val segments = mutableListOf<TranscriptSegment>()
+        var offsetMs = 0L
+        while (offsetMs >= 0L) {
+            offsetMs = onQueue(RequestPriority.BATCH) {
+                require(ptr != 0L) { "WhisperContext already released" }
+                // Skipped: nothing ran, so the context holds no segments of this buffer.
+                val next = preemptibleRun {
+                    WhisperLib.fullTranscribeResumable(
+                        ptr, preemptToken, lang, WhisperCpuConfig.preferredThreadCount, translate,
+                        buffer.nativePtr, offsetMs
+                    )
+                } ?: return@onQueue offsetMs
+                if (next != RESUMABLE_FAILED) segments += collectSegments()
+                next
+            }
+            if (offsetMs == RESUMABLE_FAILED) return@admit null
+        }
+        segments
+    }
+
+    // Queue thread only. Run a batch step unless interactive work is already waiting (then
+    // return null at once without running it, to be queued again behind that work).
+    // preempted, if given, is set when the step was skipped or stopped by the queue.
+    private inline fun <T : Any> preemptibleRun(
+        preempted: AtomicBoolean? = null,
+        crossinline run: () -> T
+    ): T? {
+        // Reset before the check: a request from here on stops the run.
+        WhisperLib.preemptReset(preemptToken)
+        if (queue.hasWaitingAbove(RequestPriority.BATCH)) {
+            preempted?.set(true)
+            return null
+        }
+        return queue.preemptible({
+            preempted?.set(true)
+            WhisperLib.preemptRequest(preemptToken)
+        }) { run() }
+    }
+
+    /** Queue activity: preemptions and the worst wait of an interactive request. */
+    val requestStats: RequestQueue.Stats
+        get() = queue.stats
+
+    // Run block on the native thread at priority.
+    private suspend fun <T> onQueue(priority: RequestPriority, block: suspend CoroutineScope.() -> T): T =
+        withContext(scope.coroutineContext + queue.dispatcher(priority), block)
+
+    /**
+     * Transcribe only [startMs, endMs) of [buffer] as one segment without timestamps.
+     * [prompt] is the text that precedes the range, if known. Returns null on failure.
+     */
+    suspend fun transcribeRange(
+        buffer: PcmBuffer,
+        startMs: Long,
+        endMs: Long,
+        lang: String,
+        translate: Boolean,
+        prompt: String? = null
+    ): String? = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext already released" }
+        require(startMs in 0 until endMs) { "Invalid range $startMs..$endMs" }
+
+        WhisperLib.fullTranscribeRange(
+            ptr, lang, WhisperCpuConfig.preferredThreadCount, translate, buffer.nativePtr, startMs, endMs, prompt
+        )?.trim()
+    }
+
+    /**
+     * Transcribe only [startMs, endMs) of the WAV recording at [path], e.g. minute 42-44 of
+     * a long session. The span is read straight from the file (nothing before it is
+     * decoded) and segment times are absolute positions in the recording. Returns null if
+     * the file can't be read as 16-bit PCM WAV or the span lies past its end.
+     */
+    suspend fun transcribeRange(
+        path: String,
+        startMs: Long,
+        endMs: Long,
+        lang: String,
+        translate: Boolean
+    ): List<TranscriptSegment>? {
+        require(startMs in 0 until endMs) { "Invalid range $startMs..$endMs" }
+        val (buffer, offsetMs) = withContext(Dispatchers.IO) {
+            PcmBuffer.fromWav(path, startMs, endMs)
+        } ?: return null
+        return buffer.use {
+            transcribeSegments(it, lang, translate).map { seg ->
+                seg.copy(startMs = seg.startMs + offsetMs, endMs = seg.endMs + offsetMs)
+            }
+        }
+    }
+
+    /**
+     * Run [job] on this model until its file is done, starting from the journal's last
+     * checkpoint if there is one (see [LongFileJob]). Cancelling the calling coroutine stops
+     * the job at the next window with everything before it kept; run it again to resume.
+     * Read the result with [LongFileJob.segments].
+     *
+     * The job is batch work ([RequestPriority.BATCH]): an interactive request pauses it at
+     * the next window, and it resumes from its journal once that request is done.
+     */
+    suspend fun runLongJob(
+        job: LongFileJob,
+        lang: String,
+        translate: Boolean = false,
+        restorePrompt: Boolean = true
+    ): LongFileJob.Status = queue.admit(RequestPriority.BATCH) {
+        var status: Int
+        do {
+            require(ptr != 0L) { "WhisperContext already released" }
+            val preempted = AtomicBoolean(false)
+            val run = scope.async(queue.dispatcher(RequestPriority.BATCH)) {
+                preemptibleRun(preempted) {
+                    job.withNative { jobPtr ->
+                        WhisperLib.jobRun(
+                            ptr, jobPtr, preemptToken, lang, WhisperCpuConfig.preferredThreadCount, translate,
+                            restorePrompt
+                        )
+                    }
+                } ?: 0
+            }
+            status = try {
+                run.await()
+            } catch (e: CancellationException) {
+                job.cancel()
+                throw e
+            }
+        } while (status == 0 && preempted.get())
+        when {
+            status > 0 -> LongFileJob.Status.DONE
+            status == 0 -> LongFileJob.Status.CANCELLED
+            else -> LongFileJob.Status.FAILED
+        }
+    }
+
+    /**
+     * Two-tier cascade: this (fast) model transcribes [buffer] and the result is emitted at
+     * once as [CascadeUpdate.Draft]. Then every segment whose confidence is below
+     * [minConfidence] is re-decoded on [refiner] (a larger resident model) over the same
+     * time span, with the preceding text as prompt, and emitted as [CascadeUpdate.Refined]
+     * as soon as it is done. Confident segments never reach the refiner.
+     *
+     * The refiner runs on its own queue thread, so this context is free for the next request
+     * while refinement continues. [buffer] must stay open until the flow completes.
+     */
+    fun transcribeCascade(
+        buffer: PcmBuffer,
+        lang: String,
+        translate: Boolean,
+        refiner: WhisperContext,
+        minConfidence: Float = DEFAULT_CASCADE_MIN_CONFIDENCE
+    ): Flow<CascadeUpdate> = flow {
+        require(refiner !== this@WhisperContext) { "The refiner must be a separate context" }
+        val draft = transcribeSegments(buffer, lang, translate)
+        emit(CascadeUpdate.Draft(draft))
+
+        val durationMs = buffer.durationMs
+        var refined = 0
+        draft.forEachIndexed { i, seg ->
+            if (seg.confidence >= minConfidence || seg.text.isBlank()) return@forEachIndexed
+            // A little audio either side: segment times are only as exact as the fast model.
+            val start = (seg.startMs - CASCADE_PAD_MS).coerceAtLeast(0L)
+            val end = (seg.endMs + CASCADE_PAD_MS).coerceAtMost(durationMs)
+            if (end <= start) return@forEachIndexed
+            val text = refiner.transcribeRange(
+                buffer, start, end, lang, translate, prompt = draft.getOrNull(i - 1)?.text
+            ) ?: return@forEachIndexed
+            refined++
+            emit(CascadeUpdate.Refined(i, seg.copy(text = text, refined = true)))
+        }
+        Log.d(LOG_TAG, "Cascade: ${draft.size} segments, $refined refined (min confidence $minConfidence)")
+    }
+
+    /**
+     * Transcribe a batch of short clips (e.g. voice commands), one text per buffer in order.
+     *
+     * Clips are packed into shared 30 s encoder windows with silence between them, decoded
+     * once, and split back by token timestamps. A pack is decoded clip by clip if text lands
+     * in a gap between clips. A null entry means that clip failed. The buffers stay owned
+     * by the caller.
+     *
+     * Packs run side by side on [parallelism] extra whisper states (kept for later batches;
+     * each costs its own KV cache and compute buffers), sharing the thread budget.
+     */
+    suspend fun transcribeMany(
+        buffers: List<PcmBuffer>,
+        lang: String,
+        translate: Boolean,
+        parallelism: Int = DEFAULT_BATCH_STATES
+    ): List<String?> = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext already released" }
+        require(parallelism > 0) { "parallelism must be positive" }
+        if (buffers.isEmpty()) return@withContext emptyList()
+
+        val numThreads = WhisperCpuConfig.preferredThreadCount
+        Log.d(LOG_TAG, "Whisper batch inference: clips=${buffers.size}, threads=$numThreads, states=$parallelism, lang=$lang")
+
+        val pool = ensureStatePool(parallelism)
+        val ptrs = LongArray(buffers.size) { buffers[it].nativePtr }
+        val texts = WhisperLib.fullTranscribeMany(pool, lang, numThreads, translate, ptrs)
+            ?: return@withContext List(buffers.size) { null }
+        texts.map { it?.trim() }
+    }
+
+    // Queue thread only.
+    private fun ensureStatePool(size: Int): Long {
+        if (statePool != 0L && statePoolSize == size) return statePool
+        freeStatePool()
+        statePool = WhisperLib.statePoolCreate(ptr, size)
+        check(statePool != 0L) { "Couldn't allocate $size whisper states" }
+        statePoolSize = size
+        return statePool
+    }
+
+    private fun freeStatePool() {
+        if (statePool != 0L) {
+            WhisperLib.statePoolFree(statePool)
+            statePool = 0L
+            statePoolSize = 0
+        }
+    }
+
+    /**
+     * Create an [AsyncTranscriber] with [workers] native worker threads (each holds its own
+     * whisper state) of [threadsPerJob] ggml threads. Closed together with this context.
+     */
+    suspend fun createAsyncTranscriber(
+        workers: Int = 1,
+        threadsPerJob: Int = maxOf(1, WhisperCpuConfig.preferredThreadCount / workers)
+    ): AsyncTranscriber = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext already released" }
+        require(workers > 0 && threadsPerJob > 0) { "workers and threadsPerJob must be positive" }
+        AsyncTranscriber(WhisperLib.asyncRunnerCreate(ptr, workers, threadsPerJob), workers)
+            .also { addDependent(it) }
+    }
+
+    private fun addDependent(d: AutoCloseable) {
+        synchronized(dependents) { dependents += d }
+    }
+
+    /**
+     * Compile [rules] (phrases, optionally with `(a|b)` / `[opt]` grammar, see [CommandSet])
+     * into a command set for [recognizeCommand].
+     */
+    suspend fun createCommandSet(rules: List<String>): CommandSet = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext already released" }
+        require(rules.isNotEmpty()) { "No command rules" }
+        val phrases = mutableListOf<String>()
+        val ruleOf = mutableListOf<Int>()
+        rules.forEachIndexed { i, rule ->
+            CommandSet.expand(rule).forEach { phrases += it; ruleOf += i }
+        }
+        CommandSet(
+            WhisperLib.commandSetCreate(ptr, phrases.toTypedArray()), this@WhisperContext,
+            rules, phrases, ruleOf.toIntArray()
+        ).also { addDependent(it) }
+    }
+
+    /**
+     * Which command of [commands] was said in [buffer] (first 10 s). The decode can only
+     * produce one of the phrases, so check [CommandMatch.score] against a threshold tuned
+     * for the model (non-commands score low). Null if no phrase was completed or the run
+     * failed.
+     */
+    suspend fun recognizeCommand(
+        buffer: PcmBuffer,
+        commands: CommandSet,
+        lang: String = "en"
+    ): CommandMatch? = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext already released" }
+        require(commands.owner === this@WhisperContext) { "CommandSet belongs to another context" }
+
+        val score = FloatArray(1)
+        val index = synchronized(commands) {
+            WhisperLib.commandRecognize(
+                commands.nativePtr, lang, WhisperCpuConfig.preferredThreadCount, buffer.nativePtr, score
+            )
+        }
+        commands.match(index, score[0])
+    }
+
+    /**
+     * Start a [TranscriptionSession] that carries up to [maxPromptTokens] tokens of context
+     * (including [initialPrompt], tokenized once here) from one run into the next.
+     */
+    suspend fun createSession(
+        initialPrompt: String? = null,
+        maxPromptTokens: Int = 64
+    ): TranscriptionSession = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext already released" }
+        require(maxPromptTokens > 0) { "maxPromptTokens must be positive" }
+        TranscriptionSession(
+            WhisperLib.sessionCreate(ptr, initialPrompt, maxPromptTokens), this@WhisperContext, maxPromptTokens
+        )
+    }
+
+    // Lock the session for the duration of a native run (it is read and updated there).
+    private inline fun withSession(session: TranscriptionSession?, block: (Long) -> Unit) {
+        if (session == null) {
+            block(0L)
+            return
+        }
+        require(session.owner === this) { "TranscriptionSession belongs to another context" }
+        synchronized(session) { block(session.nativePtr) }
+    }
+
+    /**
+     * Identify the spoken language from the first [maxMs] of [buffer] (one encoder pass, on a
+     * whisper state of its own with the encoder context shrunk to the clip).
+     *
+     * Works on a buffer that is still being recorded. Returns up to [topK] guesses, best
+     * first; pass the winner's code as `lang` to [transcribePcm]/[transcribeData] so the real
+     * decode skips detection. Empty if the model is English-only or the buffer is empty.
+     */
+    suspend fun detectLanguage(
+        buffer: PcmBuffer,
+        maxMs: Int = 3000,
+        topK: Int = 3
+    ): List<LanguageGuess> = withContext(scope.coroutineContext) {
+        require(ptr != 0L) { "WhisperContext already released" }
+        require(topK > 0) { "topK must be positive" }
+
+        val probs = FloatArray(topK)
+        val codes = WhisperLib.detectLanguage(
+            ptr, buffer.nativePtr, maxMs, WhisperCpuConfig.preferredThreadCount, probs
+        ) ?: return@withContext emptyList()
+        codes.indices.map { LanguageGuess(codes[it], probs[it]) }
+    }
+
+    // Segments of the last run with times and confidence (native thread only).
+    private fun collectSegments(): List<TranscriptSegment> =
+        List(WhisperLib.getTextSegmentCount(ptr)) { i ->
+            TranscriptSegment(
+                startMs = WhisperLib.getTextSegmentT0(ptr, i) * 10,
+                endMs = WhisperLib.getTextSegmentT1(ptr, i) * 10,
+                text = WhisperLib.getTextSegment(ptr, i),
+                confidence = WhisperLib.getTextSegmentConfidence(ptr, i)
+            )
+        }
+
+    // Read out text segments of the last run and optionally include timestamps.
+    private fun collectText(printTimestamp: Boolean): String {
         val textCount = WhisperLib.getTextSegmentCount(ptr)
         val sb = StringBuilder()
         for (i in 0 until textCount) {
@@ -128,36 +871,42 @@ class WhisperContext private constructor(
             }
             sb.append(WhisperLib.getTextSegment(ptr, i))
         }
-        sb.toString()
+        return sb.toString()
     }
 
     /**
      * Memory copy benchmark wrapper.
-     * Runs on the same single-threaded dispatcher as inference.
+     * Runs on the same thread as inference, at [RequestPriority.BENCHMARK].
      */
-    suspend fun benchMemory(nthreads: Int): String = withContext(scope.coroutineContext) {
-        WhisperLib.benchMemcpy(nthreads)
+    suspend fun benchMemory(nthreads: Int): String = queue.admit(RequestPriority.BENCHMARK) {
+        onQueue(RequestPriority.BENCHMARK) { WhisperLib.benchMemcpy(nthreads) }
     }
 
     /**
      * Matrix multiplication benchmark wrapper.
      */
-    suspend fun benchGgmlMulMat(nthreads: Int): String = withContext(scope.coroutineContext) {
-        WhisperLib.benchGgmlMulMat(nthreads)
+    suspend fun benchGgmlMulMat(nthreads: Int): String = queue.admit(RequestPriority.BENCHMARK) {
+        onQueue(RequestPriority.BENCHMARK) { WhisperLib.benchGgmlMulMat(nthreads) }
     }
 
     /**
      * Release native resources.
      *
      * This will free the native context (if any), cancel the internal coroutine scope,
-     * and shut down the dedicated executor/dispatcher.
+     * and stop the request queue's thread.
      *
      * It is safe to call multiple times.
      */
     suspend fun release() = withContext(scope.coroutineContext) {
         if (ptr != 0L) {
             try {
+                freeStatePool()  // states belong to the context
+                synchronized(dependents) {
+                    dependents.forEach { it.close() }
+                    dependents.clear()
+                }
                 WhisperLib.freeContext(ptr)
+                WhisperLib.preemptTokenFree(preemptToken)  // no batch run can hold it now
                 Log.d(LOG_TAG, "WhisperContext: released native resources")
             } catch (e: Exception) {
                 Log.w(LOG_TAG, "Error while freeing native context", e)
@@ -166,17 +915,9 @@ class WhisperContext private constructor(
             }
         }
 
-        // Cancel coroutine work and shutdown the dispatcher/executor.
+        // Cancel coroutine work and stop the queue thread.
         scope.cancel()
-        try {
-            dispatcher.close()
-        } catch (ignore: Throwable) {
-            // Some coroutine versions may not have close; ignore failures.
-        }
-        try {
-            executor.shutdownNow()
-        } catch (ignore: Throwable) {
-        }
+        queue.close()
     }
 
     /**
@@ -190,24 +931,52 @@ class WhisperContext private constructor(
     }
 
     companion object {
+        /** Loop guard hits of every context (process-wide; diff two reads for one run). */
+        val loopGuardStats: LoopGuardStats
+            get() = WhisperLib.loopGuardStats().let { LoopGuardStats(it[0], it[1], it[2]) }
+
+        // Two states keep a phone's big cores busy without doubling memory further.
+        private const val DEFAULT_BATCH_STATES = 2
+        private const val RESUMABLE_FAILED = -2L
+        private const val DEFAULT_CASCADE_MIN_CONFIDENCE = 0.6f
+        private const val CASCADE_PAD_MS = 100L
+
         /**
          * Create context by loading model from a file path.
          * Throws IllegalArgumentException if native init returns 0.
+         *
+         * @param load reports the read's progress and can cancel it (see [ModelLoad])
+         * @param warmUp run [WhisperContext.warmUp] before returning
+         * @param memory huge pages / mlock for the context's memory (see [memoryReport])
          */
-        fun createContextFromFile(filePath: String): WhisperContext {
-            val ptr = WhisperLib.initContext(filePath)
+        fun createContextFromFile(
+            filePath: String,
+            requestLimits: Map<RequestPriority, Int> = RequestQueue.DEFAULT_LIMITS,
+            load: ModelLoad? = null,
+            warmUp: Boolean = false,
+            memory: MemoryOptions? = null
+        ): WhisperContext {
+            val (ptr, report) = initWithMemory(memory) {
+                load?.withNative { WhisperLib.initContextObserved(filePath, it) }
+                    ?: WhisperLib.initContext(filePath)
+            }
             require(ptr != 0L) { "Couldn't create context from file: $filePath" }
-            return WhisperContext(ptr)
+            return finish(ptr, requestLimits, report, warmUp)
         }
 
         /**
          * Create context from an InputStream.
          * Note: native side must consume the stream fully.
          */
-        fun createContextFromInputStream(stream: InputStream): WhisperContext {
-            val ptr = WhisperLib.initContextFromInputStream(stream)
+        fun createContextFromInputStream(
+            stream: InputStream,
+            requestLimits: Map<RequestPriority, Int> = RequestQueue.DEFAULT_LIMITS,
+            warmUp: Boolean = false,
+            memory: MemoryOptions? = null
+        ): WhisperContext {
+            val (ptr, report) = initWithMemory(memory) { WhisperLib.initContextFromInputStream(stream) }
             require(ptr != 0L) { "Couldn't create context from input stream" }
-            return WhisperContext(ptr)
+            return finish(ptr, requestLimits, report, warmUp)
         }
 
         /**
@@ -215,11 +984,59 @@ class WhisperContext private constructor(
          *
          * @param assetManager application assets
          * @param assetPath path to the model file within assets (e.g. "models/whisper.bin")
+         * @param requestLimits requests per class queued or running at once (see [RequestQueue])
+         * @param load reports the read's progress and can cancel it (see [ModelLoad])
+         * @param warmUp run [WhisperContext.warmUp] before returning
+         * @param memory huge pages / mlock for the context's memory (see [memoryReport])
          */
-        fun createContextFromAsset(assetManager: AssetManager, assetPath: String): WhisperContext {
-            val ptr = WhisperLib.initContextFromAsset(assetManager, assetPath)
+        fun createContextFromAsset(
+            assetManager: AssetManager,
+            assetPath: String,
+            requestLimits: Map<RequestPriority, Int> = RequestQueue.DEFAULT_LIMITS,
+            load: ModelLoad? = null,
+            warmUp: Boolean = false,
+            memory: MemoryOptions? = null
+        ): WhisperContext {
+            val (ptr, report) = initWithMemory(memory) {
+                load?.withNative { WhisperLib.initContextFromAssetObserved(assetManager, assetPath, it) }
+                    ?: WhisperLib.initContextFromAsset(assetManager, assetPath)
+            }
             require(ptr != 0L) { "Couldn't create context from asset: $assetPath" }
-            return WhisperContext(ptr)
+            return finish(ptr, requestLimits, report, warmUp)
+        }
+
+        // Guards the snapshot-to-apply span of every load with memory options.
+        private val memoryInitLock = Any()
+
+        // Run init; with memory options, apply them to the mappings it created (release()
+        // unlocks them). Such loads run one at a time, so one never takes another's
+        // mappings; large native allocations of other threads meanwhile can still be
+        // taken (see hugepages.h for what qualifies).
+        private inline fun initWithMemory(memory: MemoryOptions?, init: () -> Long): Pair<Long, MemoryReport?> {
+            if (memory == null || (!memory.hugePages && !memory.lock)) return init() to null
+            synchronized(memoryInitLock) {
+                val snapshot = WhisperLib.memSnapshotTake()
+                try {
+                    val ptr = init()
+                    if (ptr == 0L || snapshot == 0L) return ptr to null
+                    val v = WhisperLib.memApply(snapshot, ptr, memory.hugePages, memory.lock)
+                        ?: return ptr to null
+                    return ptr to MemoryReport(v[0], v[1], v[2], v[3].toInt(), thpAvailable = v[4] != 0L)
+                } finally {
+                    WhisperLib.memSnapshotFree(snapshot)
+                }
+            }
+        }
+
+        // Warm-up after the memory options: it then runs on the pages it will keep.
+        private fun finish(
+            ptr: Long,
+            requestLimits: Map<RequestPriority, Int>,
+            report: MemoryReport?,
+            warmUp: Boolean
+        ): WhisperContext = WhisperContext(ptr, requestLimits).also {
+            it.memoryReport = report
+            if (warmUp) it.warmUpNow(null)
         }
 
         /** Return build / system info string provided by native lib. */
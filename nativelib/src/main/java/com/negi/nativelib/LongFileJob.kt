@@ -0,0 +1,123 @@
+package com.negi.nativelib
+
+import java.io.File
+import java.util.concurrent.locks.ReentrantReadWriteLock
+import kotlin.concurrent.read
+import kotlin.concurrent.write
+
+/**
+ * LongFileJob
+ *
+ * Transcription of a long WAV recording that survives the process. The file is decoded in
+ * slices, and after every 30 s window the finished segments and a checkpoint are appended
+ * to [journal] and synced. [WhisperContext.runLongJob] on a job whose journal already
+ * exists continues at the last checkpoint instead of starting over; with `restorePrompt`
+ * the text before it is given as the prompt, as if the run had never stopped.
+ *
+ * Keep the journal next to the recording (e.g. `recording.wav.journal`) and run the job
+ * again after a kill or a cancel. A journal written for a different recording (other
+ * length or rate) is started over. The job holds no model; one job runs at a time.
+ */
+class LongFileJob(
+    val wavFile: File,
+    val journal: File = File(wavFile.path + ".journal")
+) : AutoCloseable {
+
+    /** Where a job stands; [committedMs] of audio is in the journal. */
+    data class Progress(val committedMs: Long, val totalMs: Long, val segments: Int, val resumes: Int) {
+        val fraction: Float
+            get() = if (totalMs > 0) committedMs.toFloat() / totalMs else 0f
+    }
+
+    enum class Status { DONE, CANCELLED, FAILED }
+
+    private var ptr: Long = WhisperLib.jobCreate(wavFile.path, journal.path)
+
+    // Native calls (including a whole run) hold the read lock; close cancels, then waits.
+    private val lock = ReentrantReadWriteLock()
+
+    init {
+        require(ptr != 0L) { "Couldn't create job for $wavFile" }
+    }
+
+    internal fun <T> withNative(block: (Long) -> T): T = lock.read {
+        check(ptr != 0L) { "LongFileJob already closed" }
+        block(ptr)
+    }
+
+    val progress: Progress
+        get() = lock.read {
+            if (ptr == 0L) return Progress(0, 0, 0, 0)
+            val v = WhisperLib.jobProgress(ptr)
+            Progress(v[0], v[1], v[2].toInt(), v[3].toInt())
+        }
+
+    /** Stop a running job at the next window; the journal keeps everything before it. */
+    fun cancel() {
+        lock.read { if (ptr != 0L) WhisperLib.jobCancel(ptr) }
+    }
+
+    /** Committed segments in the journal so far (all of them once the job is done). */
+    fun segments(): List<TranscriptSegment> = readJournal(journal)
+
+    override fun close() {
+        cancel()
+        lock.write {
+            val p = ptr
+            if (p != 0L) {
+                ptr = 0L
+                WhisperLib.jobFree(p)
+            }
+        }
+    }
+
+    companion object {
+        /**
+         * Segments of a journal up to its last checkpoint (format in long_job.h);
+         * empty if there is none.
+         */
+        fun readJournal(journal: File): List<TranscriptSegment> {
+            if (!journal.exists()) return emptyList()
+            val committed = mutableListOf<TranscriptSegment>()
+            val pending = mutableListOf<TranscriptSegment>()
+            journal.useLines { lines ->
+                for (line in lines) {
+                    val f = line.split('\t', limit = 4)
+                    when (f[0]) {
+                        "S" -> if (f.size == 4) {
+                            pending += TranscriptSegment(
+                                f[1].toLong(), f[2].toLong(), unescape(f[3]), confidence = Float.NaN
+                            )
+                        }
+                        "C", "D" -> {
+                            committed += pending
+                            pending.clear()
+                        }
+                    }
+                }
+            }
+            return committed
+        }
+
+        private fun unescape(s: String): String {
+            if ('\\' !in s) return s
+            val sb = StringBuilder(s.length)
+            var i = 0
+            while (i < s.length) {
+                val c = s[i++]
+                if (c == '\\' && i < s.length) {
+                    sb.append(
+                        when (val e = s[i++]) {
+                            't' -> '\t'
+                            'n' -> '\n'
+                            else -> e
+                        }
+                    )
+                } else {
+                    sb.append(c)
+                }
+            }
+            return sb.toString()
+        }
+    }
+}
@@ -0,0 +1,62 @@
+package com.negi.nativelib
+
+import java.util.concurrent.locks.ReentrantReadWriteLock
+import kotlin.concurrent.read
+import kotlin.concurrent.write
+
+/**
+ * ModelLoad
+ *
+ * Watches one model load and can stop it. Pass it to
+ * [WhisperContext.createContextFromAsset] or [WhisperContext.createContextFromFile]; while
+ * that call blocks, another thread reads [progress] (bytes read by the model loader against
+ * the model's size) and may [cancel]. A cancelled load stops at the next tensor and the
+ * factory throws as for any failed load.
+ */
+class ModelLoad : AutoCloseable {
+
+    private var ptr: Long = WhisperLib.modelLoadCreate()
+
+    // Native calls (including the whole load) hold the read lock; close waits for them.
+    private val lock = ReentrantReadWriteLock()
+
+    @Volatile var isCancelled = false
+        private set
+
+    init {
+        require(ptr != 0L) { "Couldn't create model load" }
+    }
+
+    internal fun <T> withNative(block: (Long) -> T): T = lock.read {
+        check(ptr != 0L) { "ModelLoad already closed" }
+        block(ptr)
+    }
+
+    /** Bytes read so far and the model's size (0 until the load starts or if unknown). */
+    val bytes: Pair<Long, Long>
+        get() = lock.read {
+            if (ptr == 0L) return 0L to 0L
+            val v = WhisperLib.modelLoadProgress(ptr) ?: return 0L to 0L
+            v[0] to v[1]
+        }
+
+    /** Fraction read, 0..1 (0 while the size is unknown). */
+    val progress: Float
+        get() = bytes.let { (read, total) -> if (total > 0) (read.toFloat() / total).coerceIn(0f, 1f) else 0f }
+
+    /** Stop the load at the next tensor; safe from any thread, at any time. */
+    fun cancel() {
+        isCancelled = true
+        lock.read { if (ptr != 0L) WhisperLib.modelLoadCancel(ptr) }
+    }
+
+    override fun close() {
+        lock.write {
+            val p = ptr
+            if (p != 0L) {
+                ptr = 0L
+                WhisperLib.modelLoadFree(p)
+            }
+        }
+    }
+}
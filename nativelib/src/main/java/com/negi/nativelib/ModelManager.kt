@@ -0,0 +1,232 @@
+package com.negi.nativelib
+
+import android.content.res.AssetManager
+import android.os.Debug
+import android.os.SystemClock
+import android.util.Log
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.async
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.isActive
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.runBlocking
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import java.io.File
+
+/**
+ * ModelManager
+ *
+ * Keeps several [WhisperContext]s loaded at once so that switching back to a recently used
+ * model is a lookup instead of a cold load. Contexts are kept in least-recently-used order;
+ * when the memory they hold exceeds [budgetBytes], the least recently used ones are
+ * released. The context just asked for is never evicted, even if it alone is over budget.
+ *
+ * A load keeps the previously used context too, so that it can go on serving until the
+ * caller switches to the new one (a double-buffered swap); call [trimTo] with [budgetBytes]
+ * after the switch. Loads report their progress and stop when the caller is cancelled.
+ * With [warmUp], a load returns only once the new context has been warmed up
+ * ([WhisperContext.warmUp]), so it is at steady-state latency from its first request.
+ * [memory] applies to every load (see [MemoryOptions]); evicting a context unlocks its memory.
+ *
+ * A context's size is the native heap it added while loading (its weights and buffers),
+ * or the model file's size if that is larger. whisper.cpp copies the weights out of the
+ * model file, so eviction is a plain free; a model loaded again from a file or an
+ * uncompressed asset is read back from the page cache.
+ *
+ * Evicted contexts are released behind the requests already queued on them. Don't hold on
+ * to a context across [acquire] calls for other models: ask the manager again instead.
+ */
+class ModelManager(
+    @Volatile var budgetBytes: Long,
+    private val requestLimits: Map<RequestPriority, Int> = RequestQueue.DEFAULT_LIMITS,
+    private val warmUp: Boolean = false,
+    private val memory: MemoryOptions? = null
+) : AutoCloseable {
+
+    /** Residency since creation; [lastAcquireMs] is the time the last [acquire] took. */
+    data class Stats(
+        val resident: List<String>,
+        val residentBytes: Long,
+        val hits: Int,
+        val loads: Int,
+        val evictions: Int,
+        val lastAcquireMs: Long
+    )
+
+    private class Entry(val context: WhisperContext, val bytes: Long)
+
+    private val mutex = Mutex()
+
+    // Access-ordered: iteration starts at the least recently used model.
+    private val entries = LinkedHashMap<String, Entry>(8, 0.75f, true)
+    private var hits = 0
+    private var loads = 0
+    private var evictions = 0
+    private var lastAcquireMs = 0L
+    private var closed = false
+
+    /**
+     * The context of model [key], loaded with [load] unless it is resident. [sizeHint] is
+     * the model file's size, if known. Loads are serialized; a hit returns at once.
+     *
+     * While loading, [onProgress] gets the fraction read (0..1) on the caller's dispatcher.
+     * Cancelling the caller cancels the read through [ModelLoad] and returns once it has
+     * stopped.
+     */
+    suspend fun acquire(
+        key: String,
+        sizeHint: Long = 0L,
+        onProgress: ((Float) -> Unit)? = null,
+        load: (ModelLoad) -> WhisperContext
+    ): WhisperContext = mutex.withLock {
+        check(!closed) { "ModelManager closed" }
+        val start = SystemClock.elapsedRealtime()
+        val hit = entries[key]
+        val context = if (hit != null) {
+            hits++
+            hit.context
+        } else {
+            val serving = entries.keys.lastOrNull()
+            val (ctx, bytes) = loadObserved(sizeHint, onProgress, load)
+            entries[key] = Entry(ctx, bytes)
+            loads++
+            Log.i(TAG, "Loaded $key (${bytes / MB} MB)")
+            evictOver(budgetBytes, keep = setOfNotNull(key, serving))
+            ctx
+        }
+        lastAcquireMs = SystemClock.elapsedRealtime() - start
+        context
+    }
+
+    // The load on IO with its native heap growth, progress polled meanwhile.
+    private suspend fun loadObserved(
+        sizeHint: Long,
+        onProgress: ((Float) -> Unit)?,
+        load: (ModelLoad) -> WhisperContext
+    ): Pair<WhisperContext, Long> = ModelLoad().use { ml ->
+        coroutineScope {
+            val reader = async(Dispatchers.IO) {
+                val before = Debug.getNativeHeapAllocatedSize()
+                val ctx = try {
+                    load(ml)
+                } catch (e: IllegalArgumentException) {
+                    if (ml.isCancelled) throw CancellationException("Model load cancelled")
+                    throw e
+                }
+                if (ml.isCancelled) {
+                    // Finished just as it was cancelled: nobody will use it.
+                    ctx.close()
+                    throw CancellationException("Model load cancelled")
+                }
+                ctx to maxOf(Debug.getNativeHeapAllocatedSize() - before, sizeHint)
+            }
+            val ticker = onProgress?.let { report ->
+                launch {
+                    while (isActive) {
+                        report(ml.progress)
+                        delay(PROGRESS_INTERVAL_MS)
+                    }
+                }
+            }
+            try {
+                reader.await().also { onProgress?.invoke(1f) }
+            } catch (e: CancellationException) {
+                ml.cancel()  // the scope then waits for the read to stop
+                throw e
+            } finally {
+                ticker?.cancel()
+            }
+        }
+    }
+
+    /** [acquire] for a model file. */
+    suspend fun fromFile(filePath: String, onProgress: ((Float) -> Unit)? = null): WhisperContext =
+        acquire("file:$filePath", File(filePath).length(), onProgress) { ml ->
+            WhisperContext.createContextFromFile(filePath, requestLimits, ml, warmUp, memory)
+        }
+
+    /** [acquire] for a model in the APK's assets. */
+    suspend fun fromAsset(
+        assetManager: AssetManager,
+        assetPath: String,
+        onProgress: ((Float) -> Unit)? = null
+    ): WhisperContext {
+        // Length is only known for uncompressed assets.
+        val size = try {
+            assetManager.openFd(assetPath).use { it.length }
+        } catch (e: Exception) {
+            0L
+        }
+        return acquire("asset:$assetPath", size, onProgress) { ml ->
+            WhisperContext.createContextFromAsset(assetManager, assetPath, requestLimits, ml, warmUp, memory)
+        }
+    }
+
+    /** True if model [key] is loaded. */
+    suspend fun isResident(key: String): Boolean = mutex.withLock { entries.containsKey(key) }
+
+    /**
+     * Release least recently used models until at most [bytes] are held; the most recently
+     * used one is kept. Call on memory pressure (e.g. onTrimMemory).
+     */
+    suspend fun trimTo(bytes: Long) = mutex.withLock {
+        evictOver(bytes, keep = setOfNotNull(entries.keys.lastOrNull()))
+    }
+
+    /** Release model [key] if it is loaded. */
+    suspend fun evict(key: String) = mutex.withLock {
+        entries.remove(key)?.let { release(key, it) }
+    }
+
+    /** Resident models (least recently used first) and counters; waits for a load in progress. */
+    suspend fun stats(): Stats = mutex.withLock {
+        Stats(
+            resident = entries.keys.toList(),
+            residentBytes = entries.values.sumOf { it.bytes },
+            hits = hits,
+            loads = loads,
+            evictions = evictions,
+            lastAcquireMs = lastAcquireMs
+        )
+    }
+
+    // Locked.
+    private suspend fun evictOver(bytes: Long, keep: Set<String>) {
+        var held = entries.values.sumOf { it.bytes }
+        val it = entries.entries.iterator()
+        while (held > bytes && it.hasNext()) {
+            val (key, entry) = it.next()
+            if (key in keep) continue
+            it.remove()
+            held -= entry.bytes
+            evictions++
+            release(key, entry)
+        }
+    }
+
+    private suspend fun release(key: String, entry: Entry) {
+        entry.context.release()
+        Log.i(TAG, "Evicted $key (${entry.bytes / MB} MB)")
+    }
+
+    /** Release every resident model; the manager can't be used afterwards. */
+    suspend fun releaseAll() = mutex.withLock {
+        closed = true
+        entries.forEach { (key, entry) -> release(key, entry) }
+        entries.clear()
+    }
+
+    /** Blocking [releaseAll]. */
+    override fun close() {
+        runBlocking { releaseAll() }
+    }
+
+    private companion object {
+        const val TAG = "ModelManager"
+        const val MB = 1024L * 1024L
+        const val PROGRESS_INTERVAL_MS = 100L
+    }
+}
@@ -0,0 +1,137 @@
+package com.negi.nativelib
+
+import android.util.Log
+import java.io.File
+
+/**
+ * NativeCapture
+ *
+ * Microphone capture that never touches the JVM on the audio path: an AAudio input
+ * callback writes into a lock-free ring, and a native drain thread moves the samples
+ * into a [PcmBuffer] (and, optionally, a streamed WAV file).
+ *
+ * With an [EndpointConfig] the drain thread also runs the native endpointer, and
+ * [awaitEndpoint] returns as soon as the end of the utterance is detected; [split] then
+ * starts the next utterance on the same stream.
+ *
+ * Requires RECORD_AUDIO. Use [start]; a null result means AAudio is unavailable and the
+ * caller should fall back to AudioRecord.
+ */
+class NativeCapture private constructor(
+    @Volatile private var ptr: Long
+) : AutoCloseable {
+
+    /** Counters of the capture path; [dropped] > 0 means the ring overflowed. */
+    data class Stats(
+        val produced: Long,
+        val dropped: Long,
+        val consumed: Long,
+        val ringPeak: Long
+    )
+
+    /** Result of [stop] and [split]: [pcm] is null when the handoff limit was exceeded. */
+    class Captured(val pcm: PcmBuffer?, val wavOk: Boolean)
+
+    /** Rate actually delivered by the device (may differ from the requested one). */
+    val sampleRate: Int = WhisperLib.captureSampleRate(ptr)
+
+    val stats: Stats
+        get() {
+            val p = ptr
+            if (p == 0L) return Stats(0, 0, 0, 0)
+            val v = WhisperLib.captureStats(p)
+            return Stats(v[0], v[1], v[2], v[3])
+        }
+
+    /**
+     * Copy of the first [maxMs] captured so far, e.g. for language identification while
+     * recording continues; null before any audio arrived or after [stop]. Must not race
+     * with [stop]/[close].
+     */
+    fun snapshot(maxMs: Int): PcmBuffer? {
+        val p = ptr
+        if (p == 0L) return null
+        val pcm = WhisperLib.captureSnapshot(p, maxMs)
+        return if (pcm != 0L) PcmBuffer.adopt(pcm, sampleRate) else null
+    }
+
+    /**
+     * Block up to [timeoutMs] for the endpoint. Returns true once it has been reached, false on
+     * timeout or after [stop]. Safe to call from another thread while [stop] runs, but not
+     * concurrently with [close].
+     */
+    fun awaitEndpoint(timeoutMs: Int): Boolean {
+        val p = ptr
+        return p != 0L && WhisperLib.captureAwaitEndpoint(p, timeoutMs)
+    }
+
+    /**
+     * Stop the stream, drain the ring and finalize the WAV. May only be called once;
+     * the returned [PcmBuffer] is owned by the caller.
+     */
+    @Synchronized
+    fun stop(): Captured {
+        val p = ptr
+        check(p != 0L) { "NativeCapture already released" }
+        val result = WhisperLib.captureStop(p) ?: return Captured(null, false)
+        val pcm = if (result[0] != 0L) PcmBuffer.adopt(result[0], sampleRate) else null
+        return Captured(pcm, result[1] != 0L)
+    }
+
+    /**
+     * Cut the recording here without stopping the stream, e.g. at an endpoint: returns what
+     * was captured so far (as [stop] would) and goes on into a fresh buffer and [wavFile],
+     * with the endpointer re-armed for the next utterance. No audio is lost across the cut.
+     * Null, with the recording unchanged, if the new buffer or file can't be created. Must
+     * not race with [snapshot].
+     */
+    @Synchronized
+    fun split(wavFile: File?): Captured? {
+        val p = ptr
+        check(p != 0L) { "NativeCapture already released" }
+        val result = WhisperLib.captureSplit(p, wavFile?.absolutePath) ?: return null
+        val pcm = if (result[0] != 0L) PcmBuffer.adopt(result[0], sampleRate) else null
+        return Captured(pcm, result[1] != 0L)
+    }
+
+    @Synchronized
+    override fun close() {
+        val p = ptr
+        if (p != 0L) {
+            ptr = 0L
+            WhisperLib.captureFree(p)
+        }
+    }
+
+    companion object {
+        private const val LOG_TAG = "NativeCapture"
+        private const val DEFAULT_RING_MS = 2000
+
+        /**
+         * Open and start the default input device.
+         *
+         * @param wavFile WAV file to stream the recording into, or null for none
+         * @param maxHandoffMs audio kept in memory for transcription (0 = unlimited)
+         * @param endpoint enables end-of-utterance detection, or null for none
+         */
+        fun start(
+            sampleRate: Int,
+            wavFile: File?,
+            maxHandoffMs: Long,
+            endpoint: EndpointConfig? = null,
+            ringMs: Int = DEFAULT_RING_MS
+        ): NativeCapture? {
+            val p = WhisperLib.captureStart(
+                sampleRate, ringMs, wavFile?.absolutePath, maxHandoffMs,
+                endpoint?.trailingSilenceMs ?: 0,
+                endpoint?.minSpeechMs ?: 0,
+                endpoint?.maxUtteranceMs ?: 0
+            )
+            if (p == 0L) {
+                Log.w(LOG_TAG, "Native capture unavailable (rate=$sampleRate)")
+                return null
+            }
+            return NativeCapture(p)
+        }
+    }
+}
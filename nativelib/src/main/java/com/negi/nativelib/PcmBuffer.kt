@@ -0,0 +1,82 @@
+package com.negi.nativelib
+
+import java.nio.ByteBuffer
+
+/**
+ * PcmBuffer
+ *
+ * Native-owned, growable store of 16-bit mono PCM at the capture sample rate.
+ *
+ * The recorder appends straight from the direct ByteBuffer that AudioRecord fills, so
+ * samples are copied exactly once into native memory; with [NativeCapture] the buffer is
+ * filled entirely on the native side. At stop the same buffer is handed
+ * to [WhisperContext.transcribePcm] (no temp file, no WAV decode).
+ *
+ * Appends and reads may come from different threads. [close] must only be called once
+ * every reader has finished.
+ */
+class PcmBuffer private constructor(
+    @Volatile private var ptr: Long,
+    val sampleRate: Int
+) : AutoCloseable {
+
+    constructor(sampleRate: Int) : this(WhisperLib.pcmBufferCreate(sampleRate), sampleRate)
+
+    init {
+        require(ptr != 0L) { "Couldn't allocate native PCM buffer (rate=$sampleRate)" }
+    }
+
+    internal val nativePtr: Long
+        get() = ptr.also { check(it != 0L) { "PcmBuffer already closed" } }
+
+    /** Number of samples captured so far (at [sampleRate]). */
+    val sampleCount: Long
+        get() = if (ptr != 0L) WhisperLib.pcmBufferSampleCount(ptr) else 0L
+
+    /** Captured duration in milliseconds. */
+    val durationMs: Long
+        get() = sampleCount * 1000L / sampleRate
+
+    /**
+     * Append [bytes] bytes of little-endian 16-bit PCM from a direct [buffer].
+     * Returns false if the buffer is not direct or native memory is exhausted.
+     */
+    fun append(buffer: ByteBuffer, bytes: Int): Boolean {
+        require(buffer.isDirect) { "PcmBuffer.append needs a direct ByteBuffer" }
+        return WhisperLib.pcmBufferAppend(nativePtr, buffer, bytes)
+    }
+
+    /** Independent copy of the first [maxMs] captured so far (0 = all); null while empty. */
+    fun copy(maxMs: Long = 0): PcmBuffer? {
+        val maxSamples = if (maxMs > 0) maxMs * sampleRate / 1000 else 0L
+        val p = WhisperLib.pcmBufferCopy(nativePtr, maxSamples)
+        return if (p != 0L) PcmBuffer(p, sampleRate) else null
+    }
+
+    @Synchronized
+    override fun close() {
+        val p = ptr
+        if (p != 0L) {
+            ptr = 0L
+            WhisperLib.pcmBufferFree(p)
+        }
+    }
+
+    internal companion object {
+        /** Takes ownership of a buffer filled natively (see [NativeCapture.stop]). */
+        fun adopt(ptr: Long, sampleRate: Int): PcmBuffer = PcmBuffer(ptr, sampleRate)
+
+        /**
+         * Samples [startMs, endMs) of a 16-bit PCM WAV file (mono, at the file's rate), read
+         * without decoding the rest of the file, and the time of the first one in ms. Null if
+         * the file is unreadable or the span lies past its end.
+         */
+        fun fromWav(path: String, startMs: Long, endMs: Long): Pair<PcmBuffer, Long>? {
+            val info = LongArray(2)
+            val p = WhisperLib.pcmBufferFromWav(path, startMs, endMs, info)
+            if (p == 0L) return null
+            val rate = info[0].toInt()
+            return PcmBuffer(p, rate) to info[1] * 1000L / rate
+        }
+    }
+}
@@ -0,0 +1,171 @@
+package com.negi.nativelib
+
+import android.util.Log
+import kotlinx.coroutines.CoroutineDispatcher
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.sync.Semaphore
+import kotlinx.coroutines.sync.withPermit
+import java.util.concurrent.PriorityBlockingQueue
+import java.util.concurrent.atomic.AtomicInteger
+import java.util.concurrent.atomic.AtomicLong
+import kotlin.coroutines.CoroutineContext
+import kotlin.coroutines.EmptyCoroutineContext
+
+/** Request classes of a [WhisperContext], most urgent first. */
+enum class RequestPriority {
+    /** A live recording or anything a user is waiting on. */
+    INTERACTIVE,
+
+    /** Background batch work: re-transcription, long-file jobs. Preempted by [INTERACTIVE]. */
+    BATCH,
+
+    /** Benchmarks; they only run when nothing else is queued. */
+    BENCHMARK
+}
+
+/**
+ * RequestQueue
+ *
+ * The thread every native call of a [WhisperContext] runs on, fed by a priority queue instead
+ * of a FIFO: queued interactive work runs before batch work, batch before benchmarks, and
+ * requests of one class run in order.
+ *
+ * The context still runs one request at a time, so a batch request that is already running
+ * would hold up a recording for minutes. Batch runs therefore register a preempt hook while
+ * they run; an interactive request arriving meanwhile fires it, the run stops at its next
+ * window boundary (see preempt.h), and what is left is queued again behind the interactive
+ * request.
+ *
+ * [limits] bound how many requests of a class may be queued or running at once; further
+ * callers suspend until one finishes, so a large batch can't flood the queue.
+ */
+class RequestQueue internal constructor(
+    name: String,
+    limits: Map<RequestPriority, Int> = DEFAULT_LIMITS
+) : AutoCloseable {
+
+    /** Queue activity since creation. */
+    data class Stats(
+        val waiting: Int,
+        val preemptions: Int,
+        /** Longest time an interactive request waited for the thread. */
+        val maxInteractiveWaitMs: Long
+    )
+
+    private class Task(
+        val priority: RequestPriority,
+        val seq: Long,
+        val block: Runnable
+    ) : Comparable<Task> {
+        val queuedAt = System.nanoTime()
+
+        override fun compareTo(other: Task): Int =
+            compareValuesBy(this, other, { it.priority.ordinal }, { it.seq })
+    }
+
+    private val tasks = PriorityBlockingQueue<Task>()
+    private val seq = AtomicLong()
+    private val preemptions = AtomicInteger()
+    private val maxInteractiveWaitNs = AtomicLong()
+    private val admission = RequestPriority.values().associateWith { p ->
+        Semaphore(limits[p] ?: Int.MAX_VALUE)
+    }
+
+    // Hook of the batch run currently on the thread, if any. Guarded by hookLock
+    // so that no hook fires once preemptible has returned.
+    private val hookLock = Any()
+    private var preemptHook: (() -> Unit)? = null
+    @Volatile private var closed = false
+
+    private val lanes = RequestPriority.values().associateWith { Lane(it) }
+
+    private inner class Lane(val priority: RequestPriority) : CoroutineDispatcher() {
+        override fun dispatch(context: CoroutineContext, block: Runnable) {
+            if (closed) {
+                // Like a shut-down executor: the continuation finds the context released.
+                Dispatchers.IO.dispatch(context, block)
+                return
+            }
+            tasks.put(Task(priority, seq.getAndIncrement(), block))
+            if (priority == RequestPriority.INTERACTIVE) {
+                synchronized(hookLock) {
+                    preemptHook?.let {
+                        preemptions.incrementAndGet()
+                        it()
+                    }
+                }
+            }
+        }
+    }
+
+    private val thread = Thread({ runLoop() }, name).apply { start() }
+
+    private fun runLoop() {
+        while (!closed) {
+            val task = try {
+                tasks.take()
+            } catch (e: InterruptedException) {
+                continue
+            }
+            if (task.priority == RequestPriority.INTERACTIVE) {
+                maxInteractiveWaitNs.accumulateAndGet(System.nanoTime() - task.queuedAt, ::maxOf)
+            }
+            try {
+                task.block.run()
+            } catch (t: Throwable) {
+                Log.w(TAG, "Request failed on the queue thread", t)
+            }
+        }
+        // Anything still queued resumes elsewhere and sees the context released.
+        val rest = mutableListOf<Task>()
+        tasks.drainTo(rest)
+        rest.forEach { Dispatchers.IO.dispatch(EmptyCoroutineContext, it.block) }
+    }
+
+    /** Dispatcher running continuations on the queue thread at [priority]. */
+    internal fun dispatcher(priority: RequestPriority): CoroutineDispatcher = lanes.getValue(priority)
+
+    /** Run [block] within [priority]'s concurrency limit. */
+    internal suspend fun <T> admit(priority: RequestPriority, block: suspend () -> T): T =
+        admission.getValue(priority).withPermit { block() }
+
+    /** True if a request more urgent than [priority] is waiting. */
+    internal fun hasWaitingAbove(priority: RequestPriority): Boolean =
+        tasks.peek()?.let { it.priority < priority } == true
+
+    /**
+     * Queue thread only. Run [block] (a batch run) with [onPreempt] fired if an interactive
+     * request arrives meanwhile; it must make the run stop soon.
+     */
+    internal fun <T> preemptible(onPreempt: () -> Unit, block: () -> T): T {
+        synchronized(hookLock) { preemptHook = onPreempt }
+        try {
+            return block()
+        } finally {
+            synchronized(hookLock) { preemptHook = null }
+        }
+    }
+
+    val stats: Stats
+        get() = Stats(tasks.size, preemptions.get(), maxInteractiveWaitNs.get() / 1_000_000)
+
+    /**
+     * Stop the thread after the current request. Called on the queue thread itself (from
+     * [WhisperContext.release]) or from any other.
+     */
+    override fun close() {
+        if (closed) return
+        closed = true
+        if (Thread.currentThread() !== thread) thread.interrupt()
+    }
+
+    companion object {
+        private const val TAG = "WhisperQueue"
+
+        /** One batch request and one benchmark at a time; interactive requests unbounded. */
+        val DEFAULT_LIMITS: Map<RequestPriority, Int> = mapOf(
+            RequestPriority.BATCH to 1,
+            RequestPriority.BENCHMARK to 1
+        )
+    }
+}
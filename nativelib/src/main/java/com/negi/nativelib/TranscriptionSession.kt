@@ -0,0 +1,60 @@
+package com.negi.nativelib
+
+/**
+ * TranscriptionSession
+ *
+ * Decoder context carried across consecutive transcriptions of one [WhisperContext].
+ *
+ * The text tokens of each result are kept in a rolling window of at most
+ * [maxPromptTokens] (together with the optional initial prompt, which is tokenized once
+ * at creation) and passed as the prompt of the next run, so a recording decodes with its
+ * predecessor's vocabulary in context. Longer windows cost decoder prefill on every run;
+ * see [lastPrefill].
+ *
+ * Create with [WhisperContext.createSession]; pass to [WhisperContext.transcribePcm] or
+ * [WhisperContext.transcribeData]. Only valid with the context that created it.
+ */
+class TranscriptionSession internal constructor(
+    private var ptr: Long,
+    internal val owner: WhisperContext,
+    val maxPromptTokens: Int
+) : AutoCloseable {
+
+    /** Prompt cost of the last transcription run in this session. */
+    data class Prefill(
+        val promptTokens: Int,
+        val prefillMs: Float,
+        val carriedTokens: Int
+    )
+
+    init {
+        require(ptr != 0L) { "Couldn't create transcription session" }
+    }
+
+    // Held by the context while a run uses (and updates) the session.
+    internal val nativePtr: Long
+        get() = ptr.also { check(it != 0L) { "TranscriptionSession already closed" } }
+
+    val lastPrefill: Prefill
+        @Synchronized get() {
+            val p = ptr
+            if (p == 0L) return Prefill(0, 0f, 0)
+            val v = WhisperLib.sessionStats(p)
+            return Prefill(v[0].toInt(), v[1], v[2].toInt())
+        }
+
+    /** Drop the carried context (e.g. after a language change); the initial prompt stays. */
+    @Synchronized
+    fun reset() {
+        if (ptr != 0L) WhisperLib.sessionReset(ptr)
+    }
+
+    @Synchronized
+    override fun close() {
+        val p = ptr
+        if (p != 0L) {
+            ptr = 0L
+            WhisperLib.sessionFree(p)
+        }
+    }
+}
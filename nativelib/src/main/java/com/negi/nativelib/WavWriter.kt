@@ -0,0 +1,48 @@
+package com.negi.nativelib
+
+import java.io.File
+import java.io.IOException
+import java.nio.ByteBuffer
+
+/**
+ * WavWriter
+ *
+ * Single-pass 16-bit mono PCM -> WAV writer for capture paths that do not run natively
+ * (the AudioRecord fallback). It is the same native writer [NativeCapture] streams into,
+ * so both paths produce the same file: samples go straight into the final file and only
+ * the header sizes are patched, with in-place promotion to RF64 past the 4 GB RIFF limit
+ * and sizes refreshed on every flush so an interrupted recording stays playable.
+ *
+ * Not thread-safe: use from the recording thread only.
+ */
+class WavWriter(file: File, val sampleRate: Int) : AutoCloseable {
+
+    private var ptr: Long = WhisperLib.wavWriterOpen(file.absolutePath, sampleRate)
+
+    init {
+        if (ptr == 0L) throw IOException("Couldn't open ${file.path} for writing")
+    }
+
+    /** Bytes of sample data written so far (including what is still staged). */
+    val dataBytes: Long
+        get() = if (ptr != 0L) WhisperLib.wavWriterDataBytes(ptr) else 0L
+
+    /**
+     * Append [bytes] bytes of little-endian 16-bit PCM from a direct [buffer]
+     * (position and limit are not used or modified).
+     */
+    fun write(buffer: ByteBuffer, bytes: Int) {
+        require(buffer.isDirect) { "WavWriter.write needs a direct ByteBuffer" }
+        check(ptr != 0L) { "WavWriter already closed" }
+        if (!WhisperLib.wavWriterWrite(ptr, buffer, bytes)) throw IOException("WAV write failed")
+    }
+
+    /** Flush, write the final header (RIFF or RF64) and close the file. */
+    override fun close() {
+        val p = ptr
+        if (p != 0L) {
+            ptr = 0L
+            if (!WhisperLib.wavWriterClose(p)) throw IOException("Couldn't finalize WAV")
+        }
+    }
+}
@@ -9,23 +9,60 @@
 // - Safe error handling, logging, exception checks
 // - Prevents memory leaks and dangling pointers
 // - Explicit null checks and consistent resource release
+// - Native PCM buffer handoff from the recorder (no WAV round trip)
+// - Native AAudio capture session (ring buffer -> PCM buffer + WAV)
+// - End-of-utterance endpointer (on the capture stream or fed from Java)
+// - One streaming WAV/RF64 writer shared by native and AudioRecord capture
+// - Standalone language identification on the first seconds of audio
+// - Session context carryover between consecutive transcriptions
+// - Encode once, decode twice (original text + translation / second language)
+// - Batches of short clips packed into shared encoder windows
+// - State pool: independent windows encoded/decoded side by side
+// - Segment confidence and re-decoding of a time range (model cascade)
+// - Repetition loop guard on every decode (hit counters)
+// - Latency budget per run (cost model, degraded plan, partial results)
+// - Command mode: decoding restricted to a fixed phrase set (token trie)
+// - Random-access range reads from long WAV recordings (mmap of the span)
+// - Long-file jobs journaled per window, resumable after a kill
+// - Background runs preempted at window boundaries by interactive requests
+// - Async transcription: native workers, completions drained by one thread
+// - Model loads with byte progress and cancellation (wrapped loaders)
+// - Warm-up passes per audio_ctx bucket (cold vs warm first-request latency)
+// - Huge pages / mlock for the mappings a context creates (maps snapshot diff)
 // Build: Android NDK (C11 recommended)
 //
 
 #include <jni.h>
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
-#include <android/log.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "whisper.h"
-
-#define TAG "JNI-Whisper"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  TAG, __VA_ARGS__)
-#define LOGW(...) __android_log_print(ANDROID_LOG_WARN,  TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#include "async_runner.h"
+#include "capture.h"
+#include "clip_pack.h"
+#include "command.h"
+#include "deadline.h"
+#include "decoder.h"
+#include "endpointer.h"
+#include "long_job.h"
+#include "hugepages.h"
+#include "loop_guard.h"
+#include "model_load.h"
+#include "native_log.h"
+#include "pcm_buffer.h"
+#include "preempt.h"
+#include "session.h"
+#include "state_pool.h"
+#include "warmup.h"
+#include "wav_reader.h"
+#include "wav_writer.h"
 
 /* ============================================================
  * Helpers
@@ -144,8 +181,9 @@ static size_t asset_read(void *ctx, void *output, size_t read_size) {
 static bool asset_eof(void *ctx) { return AAsset_getRemainingLength64((AAsset *)ctx) <= 0; }
 static void asset_close(void *ctx) { if (ctx) AAsset_close((AAsset *)ctx); }
 
+// load (optional) observes the read and can cancel it.
 static struct whisper_context *whisper_init_from_asset(
-        JNIEnv *env, jobject assetManager, const char *asset_path) {
+        JNIEnv *env, jobject assetManager, const char *asset_path, struct model_load *load) {
     if (!assetManager || !asset_path) return NULL;
     LOGI("Loading model from asset '%s'", asset_path);
     AAssetManager *mgr = AAssetManager_fromJava(env, assetManager);
@@ -154,6 +192,10 @@ static struct whisper_context *whisper_init_from_asset(
     if (!asset) { LOGE("AAssetManager_open failed"); return NULL; }
 
     struct whisper_model_loader loader = { asset, asset_read, asset_eof, asset_close };
+    if (load && !model_load_wrap(load, loader, (int64_t)AAsset_getLength64(asset), &loader)) {
+        AAsset_close(asset);
+        return NULL;
+    }
     struct whisper_context_params cparams = whisper_context_default_params();
     return whisper_init_with_params(&loader, cparams);
 }
@@ -165,7 +207,7 @@ Java_com_negi_nativelib_WhisperLib_initContextFromAsset(
     if (!asset_path_str) return 0;
     const char *path = (*env)->GetStringUTFChars(env, asset_path_str, NULL);
     if (!path) return 0;
-    struct whisper_context *ctx = whisper_init_from_asset(env, assetManager, path);
+    struct whisper_context *ctx = whisper_init_from_asset(env, assetManager, path, NULL);
     (*env)->ReleaseStringUTFChars(env, asset_path_str, path);
     return (jlong) ctx;
 }
@@ -191,17 +233,225 @@ JNIEXPORT void JNICALL
 Java_com_negi_nativelib_WhisperLib_freeContext(
         JNIEnv *env, jclass clazz, jlong context_ptr) {
 (void)env; (void)clazz;
-if (context_ptr) whisper_free((struct whisper_context *) context_ptr);
+if (context_ptr) {
+    deadline_forget((struct whisper_context *) context_ptr);
+    hugepages_release((const void *) context_ptr);
+    whisper_free((struct whisper_context *) context_ptr);
+}
+}
+
+/* ============================================================
+ * Observable model loads
+ * ============================================================ */
+
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_modelLoadCreate(JNIEnv *env, jclass clazz) {
+    (void)env; (void)clazz;
+    return (jlong)model_load_create();
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_modelLoadFree(JNIEnv *env, jclass clazz, jlong load_ptr) {
+    (void)env; (void)clazz;
+    model_load_free((struct model_load *)load_ptr);
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_modelLoadCancel(JNIEnv *env, jclass clazz, jlong load_ptr) {
+    (void)env; (void)clazz;
+    model_load_cancel((struct model_load *)load_ptr);
+}
+
+// [bytes read, total bytes (0 = unknown)]
+JNIEXPORT jlongArray JNICALL
+Java_com_negi_nativelib_WhisperLib_modelLoadProgress(JNIEnv *env, jclass clazz, jlong load_ptr) {
+    (void)clazz;
+    struct model_load *l = (struct model_load *)load_ptr;
+    if (!l) return NULL;
+    const jlong v[2] = { (jlong)atomic_load(&l->read), (jlong)atomic_load(&l->total) };
+    jlongArray out = (*env)->NewLongArray(env, 2);
+    if (out) (*env)->SetLongArrayRegion(env, out, 0, 2, v);
+    return out;
+}
+
+// initContextFromAsset observed by load_ptr; 0 on failure or cancel.
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_initContextFromAssetObserved(
+        JNIEnv *env, jclass clazz, jobject assetManager, jstring asset_path_str, jlong load_ptr) {
+    (void)clazz;
+    if (!asset_path_str || !load_ptr) return 0;
+    const char *path = (*env)->GetStringUTFChars(env, asset_path_str, NULL);
+    if (!path) return 0;
+    struct whisper_context *ctx =
+            whisper_init_from_asset(env, assetManager, path, (struct model_load *)load_ptr);
+    (*env)->ReleaseStringUTFChars(env, asset_path_str, path);
+    return (jlong) ctx;
+}
+
+// initContext observed by load_ptr; 0 on failure or cancel.
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_initContextObserved(
+        JNIEnv *env, jclass clazz, jstring model_path_str, jlong load_ptr) {
+    (void)clazz;
+    if (!model_path_str || !load_ptr) return 0;
+    const char *path = (*env)->GetStringUTFChars(env, model_path_str, NULL);
+    if (!path) return 0;
+    struct whisper_model_loader loader;
+    int64_t size = 0;
+    struct whisper_context *ctx = NULL;
+    if (model_load_file_loader(path, &loader, &size)) {
+        if (model_load_wrap((struct model_load *)load_ptr, loader, size, &loader)) {
+            struct whisper_context_params cparams = whisper_context_default_params();
+            ctx = whisper_init_with_params(&loader, cparams);
+        } else {
+            loader.close(loader.context);
+        }
+    }
+    (*env)->ReleaseStringUTFChars(env, model_path_str, path);
+    return (jlong) ctx;
+}
+
+/* ============================================================
+ * Huge pages / mlock
+ * ============================================================ */
+
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_memSnapshotTake(JNIEnv *env, jclass clazz) {
+    (void)env; (void)clazz;
+    return (jlong)mem_snapshot_take();
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_memSnapshotFree(JNIEnv *env, jclass clazz, jlong snapshot_ptr) {
+    (void)env; (void)clazz;
+    mem_snapshot_free((struct mem_snapshot *)snapshot_ptr);
+}
+
+// Advise / lock the mappings created since the snapshot for the new context
+// (see hugepages.h); freeContext unlocks them.
+// [bytes, huge bytes, locked bytes, regions, THP mode], or null.
+JNIEXPORT jlongArray JNICALL
+Java_com_negi_nativelib_WhisperLib_memApply(
+        JNIEnv *env, jclass clazz, jlong snapshot_ptr, jlong context_ptr, jboolean huge, jboolean lock) {
+    (void)clazz;
+    struct hugepage_report rep;
+    if (!hugepages_apply((const struct mem_snapshot *)snapshot_ptr, (const void *)context_ptr,
+                         huge == JNI_TRUE, lock == JNI_TRUE, &rep)) {
+        return NULL;
+    }
+    const jlong v[5] = { rep.bytes, rep.huge_bytes, rep.locked_bytes, rep.regions, (jlong)rep.thp };
+    jlongArray out = (*env)->NewLongArray(env, 5);
+    if (out) (*env)->SetLongArrayRegion(env, out, 0, 5, v);
+    return out;
+}
+
+/* ============================================================
+ * Warm-up
+ * ============================================================ */
+
+// Synthetic passes over a new context (see warmup.h); clip_ms may be null.
+// [cold ms, warm ms, total ms, passes], or null if a pass failed.
+JNIEXPORT jfloatArray JNICALL
+Java_com_negi_nativelib_WhisperLib_warmUp(
+        JNIEnv *env, jclass clazz, jlong context_ptr, jint num_threads, jintArray clip_ms) {
+    (void)clazz;
+    struct whisper_context *ctx = (struct whisper_context *)context_ptr;
+    if (!ctx) return NULL;
+    jint *clips = NULL;
+    jsize n_clips = 0;
+    if (clip_ms) {
+        n_clips = (*env)->GetArrayLength(env, clip_ms);
+        clips = (*env)->GetIntArrayElements(env, clip_ms, NULL);
+        if (!clips) return NULL;
+    }
+    struct warmup_report rep;
+    const bool ok = warmup_run(ctx, num_threads, (const int *)clips, (int)n_clips, &rep);
+    if (clips) (*env)->ReleaseIntArrayElements(env, clip_ms, clips, JNI_ABORT);
+    if (!ok) return NULL;
+
+    const jfloat v[4] = { rep.cold_ms, rep.warm_ms, rep.total_ms, (jfloat)rep.passes };
+    jfloatArray out = (*env)->NewFloatArray(env, 4);
+    if (out) (*env)->SetFloatArrayRegion(env, out, 0, 4, v);
+    return out;
 }
 
 /* ============================================================
  * Transcribe
  * ============================================================ */
 
+static bool count_encoder_runs(struct whisper_context *ctx, struct whisper_state *state, void *user_data) {
+    (void)ctx; (void)state;
+    ++*(int *)user_data;
+    return true;
+}
+
+// Parameters shared by every transcription entry point.
+static struct whisper_full_params transcribe_params(const char *lang, jint num_threads, jboolean translate) {
+    struct whisper_full_params p = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    p.n_threads = (num_threads > 0 ? num_threads : 1);
+    p.translate = (translate == JNI_TRUE);
+    p.no_context = true;
+    p.print_realtime = false;
+    p.print_progress = false;
+    p.print_timestamps = false;
+    p.print_special = false;
+
+    // detect_language=true would make whisper_full return right after detection;
+    // "auto" detects and then transcribes.
+    p.detect_language = false;
+    p.language = (lang && lang[0] != '\0') ? lang : "auto";
+
+    // Close a window as soon as the decoder starts looping.
+    loop_guard_apply(&p);
+    return p;
+}
+
+// session may be NULL (every run starts without context). n_encodes, if not
+// NULL, receives the number of encoder passes whisper_full ran. deadline_ms > 0
+// fits the run into that budget (see deadline.h); the segments finished in
+// time are kept even when it runs out.
+static bool transcribe_f32(struct whisper_context *ctx, struct transcribe_session *session, const char *lang,
+                           jint num_threads, jboolean translate, const float *pcm, int n, int *n_encodes,
+                           jlong deadline_ms) {
+    struct whisper_full_params p = transcribe_params(lang, num_threads, translate);
+
+    // Carried context goes in as prompt tokens; no_context stays true so only
+    // the session decides what is carried.
+    transcribe_session_apply(session, &p);
+
+    if (n_encodes) {
+        *n_encodes = 0;
+        p.encoder_begin_callback = count_encoder_runs;
+        p.encoder_begin_callback_user_data = n_encodes;
+    }
+
+    struct deadline_run deadline;
+    if (deadline_ms > 0) deadline_begin(&deadline, ctx, &p, n, (int)deadline_ms);
+
+    whisper_reset_timings(ctx);
+    const int rc = whisper_full(ctx, p, pcm, n);
+    deadline_observe(ctx, n, p.audio_ctx, deadline_ms > 0 && deadline.truncated);
+    if (deadline_ms > 0) deadline_end(&deadline);
+    if (rc != 0) {
+        LOGW("whisper_full failed");
+        return false;
+    }
+    whisper_print_timings(ctx);
+
+    if (session) {
+        transcribe_session_commit(session, ctx);
+        struct transcribe_session_stats st;
+        transcribe_session_stats(session, &st);
+        LOGI("session: prompt %d tokens, prefill %.2f ms, carrying %d",
+             st.prompt_tokens, st.prefill_ms, st.carried_tokens);
+    }
+    return true;
+}
+
 JNIEXPORT void JNICALL
 Java_com_negi_nativelib_WhisperLib_fullTranscribe(
-        JNIEnv *env, jclass clazz, jlong context_ptr, jstring lang_str,
-        jint num_threads, jboolean translate, jfloatArray audio_data) {
+        JNIEnv *env, jclass clazz, jlong context_ptr, jlong session_ptr, jstring lang_str,
+        jint num_threads, jboolean translate, jfloatArray audio_data, jlong deadline_ms) {
 (void)clazz;
 struct whisper_context *ctx = (struct whisper_context *) context_ptr;
 if (!ctx || !audio_data) { LOGW("fullTranscribe: invalid args"); return; }
@@ -213,31 +463,994 @@ const jsize n = (*env)->GetArrayLength(env, audio_data);
 const char *lang = NULL;
 if (lang_str) lang = (*env)->GetStringUTFChars(env, lang_str, NULL);
 
-struct whisper_full_params p = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-p.n_threads = (num_threads > 0 ? num_threads : 1);
-p.translate = (translate == JNI_TRUE);
-p.no_context = true;
-p.print_realtime = false;
-p.print_progress = false;
-p.print_timestamps = false;
-p.print_special = false;
+transcribe_f32(ctx, (struct transcribe_session *) session_ptr, lang, num_threads, translate, pcm, (int)n, NULL,
+               deadline_ms);
 
-if (lang && lang[0] != '\0' && strcmp(lang, "auto") != 0) {
-p.language = lang;
-p.detect_language = false;
-} else {
-p.detect_language = true;
+if (lang_str && lang) (*env)->ReleaseStringUTFChars(env, lang_str, lang);
+(*env)->ReleaseFloatArrayElements(env, audio_data, pcm, JNI_ABORT);
 }
 
-whisper_reset_timings(ctx);
-if (whisper_full(ctx, p, pcm, (int)n) != 0) {
-LOGW("whisper_full failed");
-} else {
-whisper_print_timings(ctx);
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_fullTranscribePcm(
+        JNIEnv *env, jclass clazz, jlong context_ptr, jlong session_ptr, jstring lang_str,
+        jint num_threads, jboolean translate, jlong pcm_ptr, jlong deadline_ms) {
+    (void)clazz;
+    struct whisper_context *ctx = (struct whisper_context *) context_ptr;
+    struct pcm_buffer *buf = (struct pcm_buffer *) pcm_ptr;
+    if (!ctx || !buf) { LOGW("fullTranscribePcm: invalid args"); return; }
+
+    int n = 0;
+    float *pcm = pcm_buffer_to_f32(buf, 0, &n);
+    if (!pcm) { LOGW("fullTranscribePcm: empty buffer"); return; }
+
+    const char *lang = NULL;
+    if (lang_str) lang = (*env)->GetStringUTFChars(env, lang_str, NULL);
+
+    transcribe_f32(ctx, (struct transcribe_session *) session_ptr, lang, num_threads, translate, pcm, n, NULL,
+                   deadline_ms);
+
+    if (lang_str && lang) (*env)->ReleaseStringUTFChars(env, lang_str, lang);
+    free(pcm);
 }
 
-if (lang_str && lang) (*env)->ReleaseStringUTFChars(env, lang_str, lang);
-(*env)->ReleaseFloatArrayElements(env, audio_data, pcm, JNI_ABORT);
+// Text of every segment of the last whisper_full (malloc'd).
+static char *full_text(struct whisper_context *ctx) {
+    const int n_segments = whisper_full_n_segments(ctx);
+    size_t len = 0;
+    for (int i = 0; i < n_segments; ++i) len += strlen(whisper_full_get_segment_text(ctx, i));
+    char *text = (char *)malloc(len + 1);
+    if (!text) return NULL;
+    text[0] = '\0';
+    for (int i = 0, off = 0; i < n_segments; ++i) {
+        const char *s = whisper_full_get_segment_text(ctx, i);
+        const size_t l = strlen(s);
+        memcpy(text + off, s, l + 1);
+        off += (int)l;
+    }
+    return text;
+}
+
+// Re-decode [start_ms, end_ms) of the buffer, e.g. a low-confidence segment
+// of a faster model, with prompt (may be null) as the preceding text. Returns
+// the text without timestamps, or null on failure. Replaces the context's
+// segments.
+JNIEXPORT jstring JNICALL
+Java_com_negi_nativelib_WhisperLib_fullTranscribeRange(
+        JNIEnv *env, jclass clazz, jlong context_ptr, jstring lang_str, jint num_threads,
+        jboolean translate, jlong pcm_ptr, jlong start_ms, jlong end_ms, jstring prompt_str) {
+    (void)clazz;
+    struct whisper_context *ctx = (struct whisper_context *) context_ptr;
+    struct pcm_buffer *buf = (struct pcm_buffer *) pcm_ptr;
+    if (!ctx || !buf || start_ms < 0 || end_ms <= start_ms) { LOGW("fullTranscribeRange: invalid args"); return NULL; }
+
+    const int rate = pcm_buffer_sample_rate(buf);
+    int n = 0;
+    float *pcm = pcm_buffer_range_to_f32(buf, (size_t)(start_ms * rate / 1000),
+                                         (size_t)((end_ms - start_ms) * rate / 1000), &n);
+    if (!pcm) { LOGW("fullTranscribeRange: empty range"); return NULL; }
+
+    const char *lang = lang_str ? (*env)->GetStringUTFChars(env, lang_str, NULL) : NULL;
+    const char *prompt = prompt_str ? (*env)->GetStringUTFChars(env, prompt_str, NULL) : NULL;
+    struct whisper_full_params p = transcribe_params(lang, num_threads, translate);
+    p.no_timestamps = true;
+    p.single_segment = true;
+    p.initial_prompt = prompt;
+
+    char *text = whisper_full(ctx, p, pcm, n) == 0 ? full_text(ctx) : NULL;
+    if (!text) LOGW("fullTranscribeRange: whisper_full failed");
+    if (prompt) (*env)->ReleaseStringUTFChars(env, prompt_str, prompt);
+    if (lang) (*env)->ReleaseStringUTFChars(env, lang_str, lang);
+    free(pcm);
+
+    jstring out = text ? (*env)->NewStringUTF(env, text) : NULL;
+    free(text);
+    return out;
+}
+
+/* ============================================================
+ * Dual decode (one encoder pass, two decoder passes)
+ * ============================================================ */
+
+
+// Second pass over the encoder output the primary pass left in the state
+// (single-window audio only).
+static char *decode_second_pass(struct whisper_context *ctx, int lang_id, bool translate,
+                                int n_threads, int n_encodes) {
+    if (lang_id < 0 || n_encodes < 1) return NULL;
+
+    // whisper_full may have re-encoded a tail window after the last timestamp;
+    // the mel is still there, so encode window 0 again (rare).
+    if (n_encodes > 1 && whisper_encode(ctx, 0, n_threads) != 0) {
+        LOGW("dual: re-encode failed");
+        return NULL;
+    }
+
+    const int max_tokens = whisper_n_text_ctx(ctx) / 2;
+    whisper_token *tokens = (whisper_token *)malloc((size_t)max_tokens * sizeof(whisper_token));
+    if (!tokens) return NULL;
+    const int n = greedy_decode(ctx, lang_id, translate, n_threads, tokens, max_tokens);
+    char *text = n >= 0 ? decoder_tokens_to_text(ctx, tokens, n) : NULL;
+    free(tokens);
+    return text;
+}
+
+// Primary pass as fullTranscribePcm (its segments are read with getTextSegment*),
+// then a second decode of the same encoder output: English translation when
+// second_lang is null/empty, otherwise a transcription in second_lang. Returns
+// the second text (no timestamps), or NULL on failure.
+JNIEXPORT jstring JNICALL
+Java_com_negi_nativelib_WhisperLib_fullTranscribeDual(
+        JNIEnv *env, jclass clazz, jlong context_ptr, jlong session_ptr, jstring lang_str,
+        jint num_threads, jboolean translate, jstring second_lang_str, jlong pcm_ptr) {
+    (void)clazz;
+    struct whisper_context *ctx = (struct whisper_context *) context_ptr;
+    struct pcm_buffer *buf = (struct pcm_buffer *) pcm_ptr;
+    if (!ctx || !buf) { LOGW("fullTranscribeDual: invalid args"); return NULL; }
+
+    int n = 0;
+    float *pcm = pcm_buffer_to_f32(buf, 0, &n);
+    if (!pcm) { LOGW("fullTranscribeDual: empty buffer"); return NULL; }
+
+    const char *lang = lang_str ? (*env)->GetStringUTFChars(env, lang_str, NULL) : NULL;
+    const char *second = second_lang_str ? (*env)->GetStringUTFChars(env, second_lang_str, NULL) : NULL;
+    const bool second_translate = !second || second[0] == '\0';
+    const int n_threads = num_threads > 0 ? num_threads : 1;
+    struct transcribe_session *session = (struct transcribe_session *) session_ptr;
+
+    struct timespec t1, t2;
+
+    char *text = NULL;
+    const bool one_window = n <= WHISPER_SAMPLE_RATE * 30;
+    if (!one_window && (second_translate || whisper_lang_id(second) >= 0)) {
+        // Several windows: the encoder output of the first is gone by the end of
+        // the primary pass, so the second pass is a full run of its own. It goes
+        // first so that the primary result is what the segment getters see.
+        LOGI("dual: %d samples span several windows, running two full passes", n);
+        if (transcribe_f32(ctx, NULL, second_translate ? lang : second, num_threads,
+                           second_translate ? JNI_TRUE : JNI_FALSE, pcm, n, NULL, 0)) {
+            text = full_text(ctx);
+        }
+    }
+
+    int n_encodes = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (!transcribe_f32(ctx, session, lang, num_threads, translate, pcm, n, &n_encodes, 0)) {
+        free(text);  // without a primary result the segment getters would show the second pass
+        text = NULL;
+    } else if (one_window) {
+        clock_gettime(CLOCK_MONOTONIC, &t2);
+        // Translation keeps the source language token; "auto" resolves to what was detected.
+        const int lang_id = second_translate ? whisper_full_lang_id(ctx) : whisper_lang_id(second);
+        text = decode_second_pass(ctx, lang_id, second_translate, n_threads, n_encodes);
+
+        struct timespec t3;
+        clock_gettime(CLOCK_MONOTONIC, &t3);
+        LOGI("dual: primary %.1f ms, second pass %.1f ms (%d encoder run%s)",
+             (double)(t2.tv_sec - t1.tv_sec) * 1e3 + (double)(t2.tv_nsec - t1.tv_nsec) / 1e6,
+             (double)(t3.tv_sec - t2.tv_sec) * 1e3 + (double)(t3.tv_nsec - t2.tv_nsec) / 1e6,
+             n_encodes, n_encodes == 1 ? "" : "s");
+    }
+
+    if (second) (*env)->ReleaseStringUTFChars(env, second_lang_str, second);
+    if (lang) (*env)->ReleaseStringUTFChars(env, lang_str, lang);
+    free(pcm);
+
+    if (!text) return NULL;
+    jstring out = (*env)->NewStringUTF(env, text);
+    free(text);
+    return out;
+}
+
+/* ============================================================
+ * Batch of short clips (packed encoder windows)
+ * ============================================================ */
+
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_statePoolCreate(
+        JNIEnv *env, jclass clazz, jlong context_ptr, jint n_states) {
+    (void)env; (void)clazz;
+    struct state_pool *pool = state_pool_create((struct whisper_context *) context_ptr, n_states);
+    if (!pool) LOGE("statePoolCreate failed (n=%d)", (int)n_states);
+    return (jlong) pool;
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_statePoolFree(
+        JNIEnv *env, jclass clazz, jlong pool_ptr) {
+    (void)env; (void)clazz;
+    state_pool_free((struct state_pool *) pool_ptr);
+}
+
+// One text per buffer, in order (null where a clip failed). Runs on the pool's
+// states, not the context's own, so its segment getters are unaffected.
+JNIEXPORT jobjectArray JNICALL
+Java_com_negi_nativelib_WhisperLib_fullTranscribeMany(
+        JNIEnv *env, jclass clazz, jlong pool_ptr, jstring lang_str,
+        jint num_threads, jboolean translate, jlongArray pcm_ptrs) {
+    (void)clazz;
+    struct state_pool *pool = (struct state_pool *) pool_ptr;
+    if (!pool || !pcm_ptrs) { LOGW("fullTranscribeMany: invalid args"); return NULL; }
+
+    const jsize n_clips = (*env)->GetArrayLength(env, pcm_ptrs);
+    jclass str_cls = (*env)->FindClass(env, "java/lang/String");
+    jobjectArray out = str_cls ? (*env)->NewObjectArray(env, n_clips, str_cls, NULL) : NULL;
+    if (!out || n_clips == 0) return out;
+
+    jlong *ptrs = (*env)->GetLongArrayElements(env, pcm_ptrs, NULL);
+    float **clips = (float **)calloc((size_t)n_clips, sizeof(float *));
+    int *n_samples = (int *)calloc((size_t)n_clips, sizeof(int));
+    char **texts = (char **)calloc((size_t)n_clips, sizeof(char *));
+    if (!ptrs || !clips || !n_samples || !texts) {
+        LOGE("fullTranscribeMany: out of memory");
+    } else {
+        for (jsize i = 0; i < n_clips; ++i) {
+            struct pcm_buffer *buf = (struct pcm_buffer *) ptrs[i];
+            clips[i] = buf ? pcm_buffer_to_f32(buf, 0, &n_samples[i]) : NULL;
+            if (!clips[i]) n_samples[i] = 0;  // empty clips pack as zero-length
+        }
+
+        const char *lang = lang_str ? (*env)->GetStringUTFChars(env, lang_str, NULL) : NULL;
+        struct whisper_full_params p = transcribe_params(lang, num_threads, translate);
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        struct clip_pack_stats st;
+        transcribe_many(pool, p, (const float *const *)clips, n_samples, n_clips, texts, &st);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        LOGI("fullTranscribeMany: %d clips, %d encoder windows in %.1f ms", (int)n_clips,
+             st.windows + st.singles,
+             (double)(t1.tv_sec - t0.tv_sec) * 1e3 + (double)(t1.tv_nsec - t0.tv_nsec) / 1e6);
+        if (lang) (*env)->ReleaseStringUTFChars(env, lang_str, lang);
+
+        for (jsize i = 0; i < n_clips; ++i) {
+            if (!texts[i]) continue;
+            jstring s = (*env)->NewStringUTF(env, texts[i]);
+            (*env)->SetObjectArrayElement(env, out, i, s);
+            (*env)->DeleteLocalRef(env, s);
+        }
+    }
+
+    for (jsize i = 0; clips && i < n_clips; ++i) free(clips[i]);
+    for (jsize i = 0; texts && i < n_clips; ++i) free(texts[i]);
+    free(texts);
+    free(n_samples);
+    free(clips);
+    if (ptrs) (*env)->ReleaseLongArrayElements(env, pcm_ptrs, ptrs, JNI_ABORT);
+    return out;
+}
+
+/* ============================================================
+ * Long-file jobs (checkpointed, resumable)
+ * ============================================================ */
+
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_jobCreate(
+        JNIEnv *env, jclass clazz, jstring wav_path_str, jstring journal_path_str) {
+    (void)clazz;
+    if (!wav_path_str || !journal_path_str) return 0;
+    const char *wav_path = (*env)->GetStringUTFChars(env, wav_path_str, NULL);
+    const char *journal_path = (*env)->GetStringUTFChars(env, journal_path_str, NULL);
+    struct long_job *job = wav_path && journal_path ? long_job_create(wav_path, journal_path) : NULL;
+    if (journal_path) (*env)->ReleaseStringUTFChars(env, journal_path_str, journal_path);
+    if (wav_path) (*env)->ReleaseStringUTFChars(env, wav_path_str, wav_path);
+    if (!job) LOGE("jobCreate failed");
+    return (jlong) job;
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_jobFree(
+        JNIEnv *env, jclass clazz, jlong job_ptr) {
+    (void)env; (void)clazz;
+    long_job_free((struct long_job *) job_ptr);
+}
+
+// Run or resume the job on the context: 1 done, 0 cancelled or preempted
+// (resumable), -1 failed. preempt_ptr (may be 0) pauses it at a window boundary.
+JNIEXPORT jint JNICALL
+Java_com_negi_nativelib_WhisperLib_jobRun(
+        JNIEnv *env, jclass clazz, jlong context_ptr, jlong job_ptr, jlong preempt_ptr, jstring lang_str,
+        jint num_threads, jboolean translate, jboolean restore_prompt) {
+    (void)clazz;
+    struct whisper_context *ctx = (struct whisper_context *) context_ptr;
+    struct long_job *job = (struct long_job *) job_ptr;
+    if (!ctx || !job) { LOGW("jobRun: invalid args"); return LONG_JOB_FAILED; }
+
+    const char *lang = lang_str ? (*env)->GetStringUTFChars(env, lang_str, NULL) : NULL;
+    struct whisper_full_params p = transcribe_params(lang, num_threads, translate);
+    struct preempt_run preempt;
+    if (preempt_ptr) preempt_begin(&preempt, (struct preempt_token *) preempt_ptr, &p);
+    const enum long_job_status status = long_job_run(job, ctx, p, restore_prompt == JNI_TRUE);
+    if (lang) (*env)->ReleaseStringUTFChars(env, lang_str, lang);
+    return status;
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_jobCancel(
+        JNIEnv *env, jclass clazz, jlong job_ptr) {
+    (void)env; (void)clazz;
+    long_job_cancel((struct long_job *) job_ptr);
+}
+
+// [committedMs, totalMs, segments, resumes]
+JNIEXPORT jlongArray JNICALL
+Java_com_negi_nativelib_WhisperLib_jobProgress(
+        JNIEnv *env, jclass clazz, jlong job_ptr) {
+    (void)clazz;
+    struct long_job_progress pr = { 0 };
+    if (job_ptr) long_job_get_progress((struct long_job *) job_ptr, &pr);
+    const jlong v[4] = { pr.committed_ms, pr.total_ms, pr.segments, pr.resumes };
+    jlongArray out = (*env)->NewLongArray(env, 4);
+    if (out) (*env)->SetLongArrayRegion(env, out, 0, 4, v);
+    return out;
+}
+
+/* ============================================================
+ * Preemption (request queue)
+ * ============================================================ */
+
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_preemptTokenCreate(
+        JNIEnv *env, jclass clazz) {
+    (void)env; (void)clazz;
+    return (jlong) preempt_token_create();
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_preemptTokenFree(
+        JNIEnv *env, jclass clazz, jlong token_ptr) {
+    (void)env; (void)clazz;
+    preempt_token_free((struct preempt_token *) token_ptr);
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_preemptRequest(
+        JNIEnv *env, jclass clazz, jlong token_ptr) {
+    (void)env; (void)clazz;
+    preempt_request((struct preempt_token *) token_ptr);
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_preemptReset(
+        JNIEnv *env, jclass clazz, jlong token_ptr) {
+    (void)env; (void)clazz;
+    preempt_reset((struct preempt_token *) token_ptr);
+}
+
+// Transcribe the buffer from offset_ms on, stopping early if the token is
+// signalled. Returns -1 when the end was reached, -2 on failure, else the
+// position (ms) to resume from; the segments up to it are in the context.
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_fullTranscribeResumable(
+        JNIEnv *env, jclass clazz, jlong context_ptr, jlong token_ptr, jstring lang_str,
+        jint num_threads, jboolean translate, jlong pcm_ptr, jlong offset_ms) {
+    (void)clazz;
+    struct whisper_context *ctx = (struct whisper_context *) context_ptr;
+    struct preempt_token *token = (struct preempt_token *) token_ptr;
+    struct pcm_buffer *buf = (struct pcm_buffer *) pcm_ptr;
+    if (!ctx || !token || !buf) { LOGW("fullTranscribeResumable: invalid args"); return -2; }
+
+    int n = 0;
+    float *pcm = pcm_buffer_to_f32(buf, 0, &n);
+    if (!pcm) { LOGW("fullTranscribeResumable: empty buffer"); return -2; }
+
+    const char *lang = lang_str ? (*env)->GetStringUTFChars(env, lang_str, NULL) : NULL;
+    struct whisper_full_params p = transcribe_params(lang, num_threads, translate);
+    p.offset_ms = (int)offset_ms;
+    struct preempt_run preempt;
+    preempt_begin(&preempt, token, &p);
+
+    whisper_reset_timings(ctx);
+    const int rc = whisper_full(ctx, p, pcm, n);
+    if (lang) (*env)->ReleaseStringUTFChars(env, lang_str, lang);
+    free(pcm);
+    if (rc != 0) { LOGW("fullTranscribeResumable: whisper_full failed"); return -2; }
+    return preempt.stopped ? (jlong) preempt.resume_ms : -1;
+}
+
+/* ============================================================
+ * Async transcription (worker threads, completion channel)
+ * ============================================================ */
+
+// One native thread, attached to the JVM, drains the completion channel and
+// calls WhisperLib.onAsyncComplete(tag) for every finished job; no JVM thread
+// waits inside whisper_full.
+static pthread_mutex_t g_async_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool            g_async_started;
+static JavaVM         *g_async_jvm;
+static jclass          g_async_class;
+static jmethodID       g_async_complete;
+
+static void *async_dispatch_main(void *arg) {
+    (void)arg;
+    JNIEnv *env = get_env_from_jvm(g_async_jvm);
+    if (!env) return NULL;
+    const int fd = async_completion_fd();
+    uint64_t tags[64];
+    for (;;) {
+        uint64_t count;
+        if (read(fd, &count, sizeof(count)) < 0) {
+            if (errno == EINTR) continue;
+            LOGE("async dispatch: eventfd read failed (%d)", errno);
+            break;
+        }
+        int n;
+        while ((n = async_completion_drain(tags, 64)) > 0) {
+            for (int i = 0; i < n; ++i) {
+                (*env)->CallStaticVoidMethod(env, g_async_class, g_async_complete, (jlong) tags[i]);
+                if ((*env)->ExceptionCheck(env)) {
+                    (*env)->ExceptionDescribe(env);
+                    (*env)->ExceptionClear(env);
+                }
+            }
+        }
+    }
+    (*g_async_jvm)->DetachCurrentThread(g_async_jvm);
+    return NULL;
+}
+
+// On a JVM thread (FindClass needs the app's class loader).
+static bool async_dispatch_start(JNIEnv *env) {
+    pthread_mutex_lock(&g_async_lock);
+    if (!g_async_started && (*env)->GetJavaVM(env, &g_async_jvm) == 0) {
+        jclass cls = (*env)->FindClass(env, "com/negi/nativelib/WhisperLib");
+        g_async_class = cls ? (jclass)(*env)->NewGlobalRef(env, cls) : NULL;
+        g_async_complete = g_async_class
+                ? (*env)->GetStaticMethodID(env, g_async_class, "onAsyncComplete", "(J)V") : NULL;
+        pthread_t thread;
+        if (g_async_complete && pthread_create(&thread, NULL, async_dispatch_main, NULL) == 0) {
+            pthread_detach(thread);
+            g_async_started = true;
+        } else {
+            LOGE("async dispatch: can't start");
+        }
+    }
+    const bool started = g_async_started;
+    pthread_mutex_unlock(&g_async_lock);
+    return started;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_asyncRunnerCreate(
+        JNIEnv *env, jclass clazz, jlong context_ptr, jint n_workers, jint threads_per_job) {
+    (void)clazz;
+    if (!async_dispatch_start(env)) return 0;
+    struct async_runner *r = async_runner_create((struct whisper_context *) context_ptr, n_workers, threads_per_job);
+    if (!r) LOGE("asyncRunnerCreate failed (workers=%d)", (int)n_workers);
+    return (jlong) r;
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_asyncRunnerFree(
+        JNIEnv *env, jclass clazz, jlong runner_ptr) {
+    (void)env; (void)clazz;
+    async_runner_free((struct async_runner *) runner_ptr);
+}
+
+// Queue a transcription of the buffer as job tag; false if it can't be queued.
+// Returns at once: tag is passed to WhisperLib.onAsyncComplete when it ends.
+JNIEXPORT jboolean JNICALL
+Java_com_negi_nativelib_WhisperLib_asyncSubmit(
+        JNIEnv *env, jclass clazz, jlong runner_ptr, jlong tag, jstring lang_str, jboolean translate,
+        jlong pcm_ptr) {
+    (void)clazz;
+    struct async_runner *r = (struct async_runner *) runner_ptr;
+    struct pcm_buffer *buf = (struct pcm_buffer *) pcm_ptr;
+    if (!r || !buf) { LOGW("asyncSubmit: invalid args"); return JNI_FALSE; }
+
+    int n = 0;
+    float *pcm = pcm_buffer_to_f32(buf, 0, &n);
+    if (!pcm) { LOGW("asyncSubmit: empty buffer"); return JNI_FALSE; }
+
+    const char *lang = lang_str ? (*env)->GetStringUTFChars(env, lang_str, NULL) : NULL;
+    // The thread count is the runner's; the language string is copied.
+    const bool ok = async_runner_submit(r, transcribe_params(lang, 1, translate), pcm, n, (uint64_t) tag);
+    if (lang) (*env)->ReleaseStringUTFChars(env, lang_str, lang);
+    free(pcm);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+// Texts of an ended job's segments; times_out[0] receives their times as
+// [t0, t1, t0, t1, ...] in 10 ms units. Null while the job is queued or running
+// (it stays), or if it failed (it is gone).
+JNIEXPORT jobjectArray JNICALL
+Java_com_negi_nativelib_WhisperLib_asyncTake(
+        JNIEnv *env, jclass clazz, jlong runner_ptr, jlong tag, jobjectArray times_out) {
+    (void)clazz;
+    struct async_runner *r = (struct async_runner *) runner_ptr;
+    if (!r || !times_out) return NULL;
+    struct async_result res;
+    if (async_runner_take(r, (uint64_t) tag, &res) != 1) return NULL;
+
+    jclass str_cls = (*env)->FindClass(env, "java/lang/String");
+    jobjectArray texts = str_cls ? (*env)->NewObjectArray(env, res.n_segments, str_cls, NULL) : NULL;
+    jlongArray times = texts ? (*env)->NewLongArray(env, 2 * res.n_segments) : NULL;
+    for (int i = 0; times && i < res.n_segments; ++i) {
+        jstring text = (*env)->NewStringUTF(env, res.texts[i]);
+        (*env)->SetObjectArrayElement(env, texts, i, text);
+        (*env)->DeleteLocalRef(env, text);
+        const jlong t[2] = { res.t0[i], res.t1[i] };
+        (*env)->SetLongArrayRegion(env, times, 2 * i, 2, t);
+    }
+    async_result_free(&res);
+    if (!times) return NULL;
+    (*env)->SetObjectArrayElement(env, times_out, 0, times);
+    return texts;
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_asyncCancel(
+        JNIEnv *env, jclass clazz, jlong runner_ptr, jlong tag) {
+    (void)env; (void)clazz;
+    if (runner_ptr) async_runner_cancel((struct async_runner *) runner_ptr, (uint64_t) tag);
+}
+
+/* ============================================================
+ * Command recognition (fixed phrase set)
+ * ============================================================ */
+
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_commandSetCreate(
+        JNIEnv *env, jclass clazz, jlong context_ptr, jobjectArray phrases_arr) {
+    (void)clazz;
+    struct whisper_context *ctx = (struct whisper_context *) context_ptr;
+    const jsize n = phrases_arr ? (*env)->GetArrayLength(env, phrases_arr) : 0;
+    if (!ctx || n <= 0) { LOGW("commandSetCreate: invalid args"); return 0; }
+
+    const char **phrases = (const char **)calloc((size_t)n, sizeof(char *));
+    jstring *strs = (jstring *)calloc((size_t)n, sizeof(jstring));
+    struct command_set *cs = NULL;
+    if (phrases && strs) {
+        for (jsize i = 0; i < n; ++i) {
+            strs[i] = (jstring)(*env)->GetObjectArrayElement(env, phrases_arr, i);
+            phrases[i] = strs[i] ? (*env)->GetStringUTFChars(env, strs[i], NULL) : NULL;
+        }
+        cs = command_set_create(ctx, phrases, (int)n);
+        for (jsize i = 0; i < n; ++i) {
+            if (phrases[i]) (*env)->ReleaseStringUTFChars(env, strs[i], phrases[i]);
+            if (strs[i]) (*env)->DeleteLocalRef(env, strs[i]);
+        }
+    }
+    free(strs);
+    free(phrases);
+    if (!cs) LOGE("commandSetCreate failed (%d phrases)", (int)n);
+    return (jlong) cs;
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_commandSetFree(
+        JNIEnv *env, jclass clazz, jlong command_ptr) {
+    (void)env; (void)clazz;
+    command_set_free((struct command_set *) command_ptr);
+}
+
+// Index of the phrase said in the buffer (first COMMAND_MAX_MS), -1 if none was
+// completed or the run failed. score_out[0] receives its score (0..1).
+JNIEXPORT jint JNICALL
+Java_com_negi_nativelib_WhisperLib_commandRecognize(
+        JNIEnv *env, jclass clazz, jlong command_ptr, jstring lang_str, jint num_threads,
+        jlong pcm_ptr, jfloatArray score_out) {
+    (void)clazz;
+    struct command_set *cs = (struct command_set *) command_ptr;
+    struct pcm_buffer *buf = (struct pcm_buffer *) pcm_ptr;
+    if (!cs || !buf) { LOGW("commandRecognize: invalid args"); return -1; }
+
+    int n = 0;
+    float *pcm = pcm_buffer_range_to_f32(buf, 0, (size_t)COMMAND_MAX_MS * pcm_buffer_sample_rate(buf) / 1000, &n);
+    if (!pcm) { LOGW("commandRecognize: empty buffer"); return -1; }
+
+    const char *lang = lang_str ? (*env)->GetStringUTFChars(env, lang_str, NULL) : NULL;
+    struct command_match match;
+    command_recognize(cs, transcribe_params(lang, num_threads, JNI_FALSE), pcm, n, &match);
+    if (lang) (*env)->ReleaseStringUTFChars(env, lang_str, lang);
+    free(pcm);
+
+    if (score_out && (*env)->GetArrayLength(env, score_out) > 0) {
+        (*env)->SetFloatArrayRegion(env, score_out, 0, 1, &match.score);
+    }
+    return match.index;
+}
+
+/* ============================================================
+ * Session (context carryover)
+ * ============================================================ */
+
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_sessionCreate(
+        JNIEnv *env, jclass clazz, jlong context_ptr, jstring prompt_str, jint max_prompt_tokens) {
+    (void)clazz;
+    struct whisper_context *ctx = (struct whisper_context *) context_ptr;
+    if (!ctx) return 0;
+    const char *prompt = prompt_str ? (*env)->GetStringUTFChars(env, prompt_str, NULL) : NULL;
+    struct transcribe_session *s = transcribe_session_create(ctx, prompt, max_prompt_tokens);
+    if (prompt) (*env)->ReleaseStringUTFChars(env, prompt_str, prompt);
+    if (!s) LOGE("sessionCreate failed (max_prompt_tokens=%d)", (int)max_prompt_tokens);
+    return (jlong) s;
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_sessionReset(
+        JNIEnv *env, jclass clazz, jlong session_ptr) {
+    (void)env; (void)clazz;
+    transcribe_session_reset((struct transcribe_session *) session_ptr);
+}
+
+// [promptTokens, prefillMs, carriedTokens] of the last run
+JNIEXPORT jfloatArray JNICALL
+Java_com_negi_nativelib_WhisperLib_sessionStats(
+        JNIEnv *env, jclass clazz, jlong session_ptr) {
+    (void)clazz;
+    struct transcribe_session_stats st;
+    transcribe_session_stats((struct transcribe_session *) session_ptr, &st);
+    const jfloat v[3] = { (jfloat) st.prompt_tokens, st.prefill_ms, (jfloat) st.carried_tokens };
+    jfloatArray out = (*env)->NewFloatArray(env, 3);
+    if (out) (*env)->SetFloatArrayRegion(env, out, 0, 3, v);
+    return out;
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_sessionFree(
+        JNIEnv *env, jclass clazz, jlong session_ptr) {
+    (void)env; (void)clazz;
+    transcribe_session_free((struct transcribe_session *) session_ptr);
+}
+
+/* ============================================================
+ * Language identification
+ * ============================================================ */
+
+// whisper_full sets a state's encoder context (audio_ctx) only after language
+// detection, and the API has no other setter. A run with the language fixed
+// computes the mel and sets audio_ctx; this stops it before its encoder pass.
+static bool stop_before_encode(struct whisper_context *ctx, struct whisper_state *state, void *user_data) {
+    (void)ctx; (void)state; (void)user_data;
+    return false;
+}
+
+// Runs one encoder pass on the first max_ms of the buffer, on a state of its
+// own with audio_ctx shrunk to the clip (clip_pack_audio_ctx), so whatever the
+// context's default state last ran with does not matter. Returns the top-k
+// language codes, best first, and writes their probabilities into probs_out
+// (k = its length). The caller passes the winner as the language of the real
+// decode, so that run skips detection.
+JNIEXPORT jobjectArray JNICALL
+Java_com_negi_nativelib_WhisperLib_detectLanguage(
+        JNIEnv *env, jclass clazz, jlong context_ptr, jlong pcm_ptr,
+        jint max_ms, jint num_threads, jfloatArray probs_out) {
+    (void)clazz;
+    struct whisper_context *ctx = (struct whisper_context *) context_ptr;
+    struct pcm_buffer *buf = (struct pcm_buffer *) pcm_ptr;
+    if (!ctx || !buf || !probs_out) { LOGW("detectLanguage: invalid args"); return NULL; }
+    if (!whisper_is_multilingual(ctx)) { LOGW("detectLanguage: model is English-only"); return NULL; }
+
+    const jsize k = (*env)->GetArrayLength(env, probs_out);
+    const int n_threads = num_threads > 0 ? num_threads : 1;
+    const size_t max_samples = max_ms > 0
+            ? (size_t)((int64_t)pcm_buffer_sample_rate(buf) * max_ms / 1000) : 0;
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    int n = 0;
+    float *pcm = pcm_buffer_to_f32(buf, max_samples, &n);
+    if (!pcm) { LOGW("detectLanguage: empty buffer"); return NULL; }
+    struct whisper_state *state = whisper_init_state(ctx);
+    if (!state) { LOGW("detectLanguage: whisper_init_state failed"); free(pcm); return NULL; }
+
+    struct whisper_full_params p = transcribe_params("en", n_threads, JNI_FALSE);
+    p.audio_ctx = clip_pack_audio_ctx(ctx, n);
+    p.encoder_begin_callback = stop_before_encode;
+    const int prep_rc = whisper_full_with_state(ctx, state, p, pcm, n);
+    free(pcm);
+    if (prep_rc != 0) {
+        LOGW("detectLanguage: mel failed (%d)", prep_rc);
+        whisper_free_state(state);
+        return NULL;
+    }
+
+    const int n_lang = whisper_lang_max_id() + 1;
+    float *probs = (float *)malloc((size_t)n_lang * sizeof(float));
+    const int lang_rc = probs ? whisper_lang_auto_detect_with_state(ctx, state, 0, n_threads, probs) : -1;
+    whisper_free_state(state);
+    if (lang_rc < 0) {
+        LOGW("detectLanguage: whisper_lang_auto_detect failed");
+        free(probs);
+        return NULL;
+    }
+
+    jclass str_cls = (*env)->FindClass(env, "java/lang/String");
+    jobjectArray codes = str_cls ? (*env)->NewObjectArray(env, k, str_cls, NULL) : NULL;
+    if (!codes) { free(probs); return NULL; }
+
+    // k is tiny: repeated arg-max, consuming each pick.
+    for (jsize i = 0; i < k; ++i) {
+        int best = 0;
+        for (int id = 1; id < n_lang; ++id) if (probs[id] > probs[best]) best = id;
+        const jfloat p = probs[best] > 0.0f ? probs[best] : 0.0f;
+        (*env)->SetFloatArrayRegion(env, probs_out, i, 1, &p);
+        jstring code = (*env)->NewStringUTF(env, whisper_lang_str(best));
+        (*env)->SetObjectArrayElement(env, codes, i, code);
+        (*env)->DeleteLocalRef(env, code);
+        probs[best] = -1.0f;
+    }
+    free(probs);
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    LOGI("detectLanguage: %d samples, audio_ctx %d, in %.1f ms", n, p.audio_ctx,
+         (double)(t1.tv_sec - t0.tv_sec) * 1e3 + (double)(t1.tv_nsec - t0.tv_nsec) / 1e6);
+    return codes;
+}
+
+/* ============================================================
+ * PCM buffer (recorder -> transcriber handoff)
+ * ============================================================ */
+
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_pcmBufferCreate(
+        JNIEnv *env, jclass clazz, jint sample_rate) {
+    (void)env; (void)clazz;
+    struct pcm_buffer *buf = pcm_buffer_create(sample_rate);
+    if (!buf) LOGE("pcmBufferCreate failed (rate=%d)", (int)sample_rate);
+    return (jlong) buf;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_negi_nativelib_WhisperLib_pcmBufferAppend(
+        JNIEnv *env, jclass clazz, jlong pcm_ptr, jobject direct_buffer, jint n_bytes) {
+    (void)clazz;
+    struct pcm_buffer *buf = (struct pcm_buffer *) pcm_ptr;
+    if (!buf || !direct_buffer || n_bytes <= 0) return JNI_FALSE;
+
+    const int16_t *src = (const int16_t *)(*env)->GetDirectBufferAddress(env, direct_buffer);
+    jlong cap = (*env)->GetDirectBufferCapacity(env, direct_buffer);
+    if (!src || cap < n_bytes) { LOGW("pcmBufferAppend: not a direct buffer or too small"); return JNI_FALSE; }
+
+    return pcm_buffer_append(buf, src, (size_t)n_bytes / sizeof(int16_t)) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_pcmBufferCopy(
+        JNIEnv *env, jclass clazz, jlong pcm_ptr, jlong max_samples) {
+    (void)env; (void)clazz;
+    return (jlong) pcm_buffer_copy((struct pcm_buffer *) pcm_ptr, max_samples > 0 ? (size_t)max_samples : 0);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_pcmBufferSampleCount(
+        JNIEnv *env, jclass clazz, jlong pcm_ptr) {
+    (void)env; (void)clazz;
+    return (jlong) pcm_buffer_samples((struct pcm_buffer *) pcm_ptr);
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_pcmBufferFree(
+        JNIEnv *env, jclass clazz, jlong pcm_ptr) {
+    (void)env; (void)clazz;
+    pcm_buffer_free((struct pcm_buffer *) pcm_ptr);
+}
+
+// Frames [start_ms, end_ms) of a 16-bit PCM WAV/RF64 file as a new buffer at
+// the file's rate (mono), read through an mmap of that span only. info_out
+// receives [sample rate, first frame]. 0 if the span is empty or on failure.
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_pcmBufferFromWav(
+        JNIEnv *env, jclass clazz, jstring path_str, jlong start_ms, jlong end_ms, jlongArray info_out) {
+    (void)clazz;
+    if (!path_str) return 0;
+    const char *path = (*env)->GetStringUTFChars(env, path_str, NULL);
+    if (!path) return 0;
+    uint64_t first = 0;
+    struct pcm_buffer *buf = wav_reader_load_range(path, start_ms, end_ms, &first);
+    (*env)->ReleaseStringUTFChars(env, path_str, path);
+    if (!buf) return 0;
+
+    if (info_out && (*env)->GetArrayLength(env, info_out) >= 2) {
+        const jlong info[2] = { pcm_buffer_sample_rate(buf), (jlong) first };
+        (*env)->SetLongArrayRegion(env, info_out, 0, 2, info);
+    }
+    return (jlong) buf;
+}
+
+/* ============================================================
+ * Native capture (AAudio -> ring -> PCM buffer + WAV)
+ * ============================================================ */
+
+// trailing_silence_ms <= 0 disables the endpointer.
+static bool endpoint_config_from_args(struct endpoint_config *cfg, jint trailing_silence_ms,
+                                      jint min_speech_ms, jint max_utterance_ms) {
+    if (trailing_silence_ms <= 0) return false;
+    endpoint_config_default(cfg);
+    cfg->trailing_silence_ms = trailing_silence_ms;
+    if (min_speech_ms >= 0) cfg->min_speech_ms = min_speech_ms;
+    cfg->max_utterance_ms = max_utterance_ms > 0 ? max_utterance_ms : 0;
+    return true;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_captureStart(
+        JNIEnv *env, jclass clazz, jint sample_rate, jint ring_ms, jstring wav_path, jlong max_handoff_ms,
+        jint trailing_silence_ms, jint min_speech_ms, jint max_utterance_ms) {
+    (void)clazz;
+    struct endpoint_config ep_cfg;
+    const bool use_ep = endpoint_config_from_args(&ep_cfg, trailing_silence_ms, min_speech_ms, max_utterance_ms);
+
+    struct capture_engine *engine = capture_open_aaudio(sample_rate, ring_ms);
+    if (!engine) return 0;
+
+    const char *path = wav_path ? (*env)->GetStringUTFChars(env, wav_path, NULL) : NULL;
+    const size_t max_samples = max_handoff_ms > 0
+            ? (size_t)((int64_t)capture_sample_rate(engine) * max_handoff_ms / 1000)
+            : 0;
+    struct capture_session *s = capture_session_start(engine, path, max_samples, use_ep ? &ep_cfg : NULL);
+    if (path) (*env)->ReleaseStringUTFChars(env, wav_path, path);
+
+    if (!s) LOGE("captureStart failed");
+    return (jlong) s;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_negi_nativelib_WhisperLib_captureSampleRate(
+        JNIEnv *env, jclass clazz, jlong capture_ptr) {
+    (void)env; (void)clazz;
+    return capture_session_sample_rate((struct capture_session *) capture_ptr);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_negi_nativelib_WhisperLib_captureAwaitEndpoint(
+        JNIEnv *env, jclass clazz, jlong capture_ptr, jint timeout_ms) {
+    (void)env; (void)clazz;
+    return capture_session_wait_endpoint((struct capture_session *) capture_ptr, timeout_ms) ? JNI_TRUE : JNI_FALSE;
+}
+
+// Owned copy of the first max_ms captured so far (0 if nothing yet / stopped).
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_captureSnapshot(
+        JNIEnv *env, jclass clazz, jlong capture_ptr, jint max_ms) {
+    (void)env; (void)clazz;
+    struct capture_session *s = (struct capture_session *) capture_ptr;
+    const size_t max_samples = max_ms > 0
+            ? (size_t)((int64_t)capture_session_sample_rate(s) * max_ms / 1000) : 0;
+    return (jlong) pcm_buffer_copy(capture_session_pcm(s), max_samples);
+}
+
+// [produced, dropped, consumed, ringPeak]
+JNIEXPORT jlongArray JNICALL
+Java_com_negi_nativelib_WhisperLib_captureStats(
+        JNIEnv *env, jclass clazz, jlong capture_ptr) {
+    (void)clazz;
+    struct capture_stats st;
+    capture_session_stats((struct capture_session *) capture_ptr, &st);
+    const jlong v[4] = { (jlong) st.produced, (jlong) st.dropped, (jlong) st.consumed, (jlong) st.ring_peak };
+    jlongArray out = (*env)->NewLongArray(env, 4);
+    if (out) (*env)->SetLongArrayRegion(env, out, 0, 4, v);
+    return out;
+}
+
+// [pcmPtr (0 if the handoff limit was hit), wavOk (0/1)]
+JNIEXPORT jlongArray JNICALL
+Java_com_negi_nativelib_WhisperLib_captureStop(
+        JNIEnv *env, jclass clazz, jlong capture_ptr) {
+    (void)clazz;
+    bool wav_ok = false;
+    struct pcm_buffer *pcm = capture_session_stop((struct capture_session *) capture_ptr, &wav_ok);
+    const jlong v[2] = { (jlong) pcm, wav_ok ? 1 : 0 };
+    jlongArray out = (*env)->NewLongArray(env, 2);
+    if (!out) { pcm_buffer_free(pcm); return NULL; }
+    (*env)->SetLongArrayRegion(env, out, 0, 2, v);
+    return out;
+}
+
+// Same result as captureStop for the audio before the cut; capture continues
+// into wav_path. NULL if the session could not be split.
+JNIEXPORT jlongArray JNICALL
+Java_com_negi_nativelib_WhisperLib_captureSplit(
+        JNIEnv *env, jclass clazz, jlong capture_ptr, jstring wav_path) {
+    (void)clazz;
+    const char *path = wav_path ? (*env)->GetStringUTFChars(env, wav_path, NULL) : NULL;
+    if (wav_path && !path) return NULL;
+    struct pcm_buffer *pcm = NULL;
+    bool wav_ok = false;
+    const bool split = capture_session_split((struct capture_session *) capture_ptr, path, &pcm, &wav_ok);
+    if (path) (*env)->ReleaseStringUTFChars(env, wav_path, path);
+    if (!split) return NULL;
+
+    const jlong v[2] = { (jlong) pcm, wav_ok ? 1 : 0 };
+    jlongArray out = (*env)->NewLongArray(env, 2);
+    if (!out) { pcm_buffer_free(pcm); return NULL; }
+    (*env)->SetLongArrayRegion(env, out, 0, 2, v);
+    return out;
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_captureFree(
+        JNIEnv *env, jclass clazz, jlong capture_ptr) {
+    (void)env; (void)clazz;
+    capture_session_free((struct capture_session *) capture_ptr);
+}
+
+/* ============================================================
+ * Endpointer (for capture paths that do not run natively)
+ * ============================================================ */
+
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_endpointerCreate(
+        JNIEnv *env, jclass clazz, jint sample_rate, jint trailing_silence_ms,
+        jint min_speech_ms, jint max_utterance_ms) {
+    (void)env; (void)clazz;
+    struct endpoint_config cfg;
+    if (!endpoint_config_from_args(&cfg, trailing_silence_ms, min_speech_ms, max_utterance_ms)) return 0;
+    return (jlong) endpointer_create(&cfg, sample_rate);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_negi_nativelib_WhisperLib_endpointerFeed(
+        JNIEnv *env, jclass clazz, jlong ep_ptr, jobject direct_buffer, jint n_bytes) {
+    (void)clazz;
+    struct endpointer *ep = (struct endpointer *) ep_ptr;
+    if (!ep || !direct_buffer || n_bytes <= 0) return JNI_FALSE;
+
+    const int16_t *src = (const int16_t *)(*env)->GetDirectBufferAddress(env, direct_buffer);
+    jlong cap = (*env)->GetDirectBufferCapacity(env, direct_buffer);
+    if (!src || cap < n_bytes) return JNI_FALSE;
+
+    return endpointer_feed(ep, src, (size_t)n_bytes / sizeof(int16_t)) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_endpointerRearm(
+        JNIEnv *env, jclass clazz, jlong ep_ptr) {
+    (void)env; (void)clazz;
+    endpointer_rearm((struct endpointer *) ep_ptr);
+}
+
+JNIEXPORT void JNICALL
+Java_com_negi_nativelib_WhisperLib_endpointerFree(
+        JNIEnv *env, jclass clazz, jlong ep_ptr) {
+    (void)env; (void)clazz;
+    endpointer_free((struct endpointer *) ep_ptr);
+}
+
+/* ============================================================
+ * WAV writer (for capture paths that do not run natively)
+ * ============================================================ */
+
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_wavWriterOpen(
+        JNIEnv *env, jclass clazz, jstring path_str, jint sample_rate) {
+    (void)clazz;
+    if (!path_str) return 0;
+    const char *path = (*env)->GetStringUTFChars(env, path_str, NULL);
+    if (!path) return 0;
+    struct wav_writer *w = wav_writer_open(path, sample_rate);
+    (*env)->ReleaseStringUTFChars(env, path_str, path);
+    return (jlong) w;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_negi_nativelib_WhisperLib_wavWriterWrite(
+        JNIEnv *env, jclass clazz, jlong writer_ptr, jobject direct_buffer, jint n_bytes) {
+    (void)clazz;
+    struct wav_writer *w = (struct wav_writer *) writer_ptr;
+    if (!w || !direct_buffer || n_bytes <= 0) return JNI_FALSE;
+
+    const int16_t *src = (const int16_t *)(*env)->GetDirectBufferAddress(env, direct_buffer);
+    jlong cap = (*env)->GetDirectBufferCapacity(env, direct_buffer);
+    if (!src || cap < n_bytes) return JNI_FALSE;
+
+    return wav_writer_write(w, src, (size_t)n_bytes / sizeof(int16_t)) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_negi_nativelib_WhisperLib_wavWriterDataBytes(
+        JNIEnv *env, jclass clazz, jlong writer_ptr) {
+    (void)env; (void)clazz;
+    return (jlong) wav_writer_data_bytes((const struct wav_writer *) writer_ptr);
+}
+
+// Flushes, writes the final header (RIFF or RF64) and frees the writer.
+JNIEXPORT jboolean JNICALL
+Java_com_negi_nativelib_WhisperLib_wavWriterClose(
+        JNIEnv *env, jclass clazz, jlong writer_ptr) {
+    (void)env; (void)clazz;
+    return wav_writer_close((struct wav_writer *) writer_ptr) ? JNI_TRUE : JNI_FALSE;
 }
 
 /* ============================================================
@@ -274,6 +1487,56 @@ Java_com_negi_nativelib_WhisperLib_getTextSegmentT1(
     return context_ptr ? whisper_full_get_segment_t1((struct whisper_context*)context_ptr, index) : 0;
 }
 
+// Mean probability of the text tokens of a segment (1 if it has none): how
+// sure the decoder was of what it wrote.
+JNIEXPORT jfloat JNICALL
+Java_com_negi_nativelib_WhisperLib_getTextSegmentConfidence(
+        JNIEnv *env, jclass clazz, jlong context_ptr, jint index) {
+    (void)env; (void)clazz;
+    struct whisper_context *ctx = (struct whisper_context *) context_ptr;
+    if (!ctx) return 0.0f;
+    const whisper_token eot = whisper_token_eot(ctx);
+    const int n_tokens = whisper_full_n_tokens(ctx, index);
+    float sum = 0.0f;
+    int n = 0;
+    for (int i = 0; i < n_tokens; ++i) {
+        const whisper_token_data t = whisper_full_get_token_data(ctx, index, i);
+        if (t.id >= eot) continue;  // special and timestamp tokens
+        sum += t.p;
+        n++;
+    }
+    return n > 0 ? sum / (float)n : 1.0f;
+}
+
+// [budgetMs, elapsedMs, audioCtx, maxTokens, truncated] of the context's last
+// run with a deadline, or null if there was none.
+JNIEXPORT jfloatArray JNICALL
+Java_com_negi_nativelib_WhisperLib_getDeadlineReport(
+        JNIEnv *env, jclass clazz, jlong context_ptr) {
+    (void)clazz;
+    struct deadline_report rep;
+    if (!context_ptr || !deadline_last_report((struct whisper_context *) context_ptr, &rep)) return NULL;
+    const jfloat v[5] = {
+        rep.budget_ms, rep.elapsed_ms, (jfloat) rep.audio_ctx, (jfloat) rep.max_tokens, rep.truncated ? 1.0f : 0.0f
+    };
+    jfloatArray out = (*env)->NewFloatArray(env, 5);
+    if (out) (*env)->SetFloatArrayRegion(env, out, 0, 5, v);
+    return out;
+}
+
+// [repeats, stalls, lowVariety] loop guard hits since the library was loaded
+JNIEXPORT jintArray JNICALL
+Java_com_negi_nativelib_WhisperLib_loopGuardStats(
+        JNIEnv *env, jclass clazz) {
+    (void)clazz;
+    struct loop_guard_stats st;
+    loop_guard_totals(&st);
+    const jint v[3] = { st.repeats, st.stalls, st.low_variety };
+    jintArray out = (*env)->NewIntArray(env, 3);
+    if (out) (*env)->SetIntArrayRegion(env, out, 0, 3, v);
+    return out;
+}
+
 /* ============================================================
  * System / Bench
  * ============================================================ */
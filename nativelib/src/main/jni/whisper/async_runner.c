@@ -0,0 +1,344 @@
+//
+// async_runner.c — non-blocking transcription jobs (see async_runner.h)
+//
+
+#include "async_runner.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "native_log.h"
+
+enum job_phase { JOB_QUEUED, JOB_RUNNING, JOB_DONE, JOB_FAILED };
+
+struct job {
+    uint64_t                   tag;
+    enum job_phase             phase;
+    atomic_bool                abort;
+    bool                       detached;   // cancelled while running: free when it ends
+    struct whisper_full_params params;
+    ggml_abort_callback        prev_abort;   // the caller's own, chained
+    void                      *prev_abort_data;
+    char                      *lang;
+    float                     *pcm;
+    int                        n_samples;
+    struct async_result        res;
+    struct job                *next;
+};
+
+struct async_runner {
+    struct whisper_context *ctx;
+    int                     n_workers;
+    int                     n_threads;
+    pthread_t              *workers;
+    struct whisper_state  **states;
+    int                     n_started;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  queued;
+    struct job     *head;    // every job not yet taken, in submission order
+    struct job     *tail;
+    bool            stop;
+};
+
+/* ---- completion channel (process-wide) ---- */
+
+static pthread_once_t  g_channel_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t g_channel_lock = PTHREAD_MUTEX_INITIALIZER;
+static int             g_channel_fd = -1;
+static uint64_t       *g_tags;
+static int             g_n_tags;
+static int             g_cap_tags;
+
+static void channel_init(void) {
+    g_channel_fd = eventfd(0, EFD_CLOEXEC);
+    if (g_channel_fd < 0) LOGE("async_runner: eventfd failed");
+}
+
+int async_completion_fd(void) {
+    pthread_once(&g_channel_once, channel_init);
+    return g_channel_fd;
+}
+
+static void post_completion(uint64_t tag) {
+    pthread_mutex_lock(&g_channel_lock);
+    if (g_n_tags == g_cap_tags) {
+        const int cap = g_cap_tags ? g_cap_tags * 2 : 64;
+        uint64_t *grown = (uint64_t *)realloc(g_tags, (size_t)cap * sizeof(uint64_t));
+        if (!grown) {
+            pthread_mutex_unlock(&g_channel_lock);
+            LOGE("async_runner: completion queue full, tag %llu lost", (unsigned long long)tag);
+            return;
+        }
+        g_tags = grown;
+        g_cap_tags = cap;
+    }
+    g_tags[g_n_tags++] = tag;
+    pthread_mutex_unlock(&g_channel_lock);
+
+    const uint64_t one = 1;
+    if (write(async_completion_fd(), &one, sizeof(one)) != (ssize_t)sizeof(one)) {
+        LOGW("async_runner: eventfd write failed");
+    }
+}
+
+int async_completion_drain(uint64_t *tags, int max) {
+    pthread_mutex_lock(&g_channel_lock);
+    const int n = g_n_tags < max ? g_n_tags : max;
+    memcpy(tags, g_tags, (size_t)n * sizeof(uint64_t));
+    memmove(g_tags, g_tags + n, (size_t)(g_n_tags - n) * sizeof(uint64_t));
+    g_n_tags -= n;
+    const bool more = g_n_tags > 0;
+    pthread_mutex_unlock(&g_channel_lock);
+
+    // Left over tags: keep the fd readable so the reader comes back.
+    if (more) {
+        const uint64_t one = 1;
+        if (write(async_completion_fd(), &one, sizeof(one)) < 0) LOGW("async_runner: eventfd write failed");
+    }
+    return n;
+}
+
+/* ---- jobs ---- */
+
+void async_result_free(struct async_result *res) {
+    for (int i = 0; i < res->n_segments; ++i) free(res->texts[i]);
+    free(res->texts);
+    free(res->t0);
+    free(res->t1);
+    memset(res, 0, sizeof(*res));
+}
+
+static void job_free(struct job *j) {
+    async_result_free(&j->res);
+    free(j->lang);
+    free(j->pcm);
+    free(j);
+}
+
+// Locked.
+static struct job *find(struct async_runner *r, uint64_t tag) {
+    for (struct job *j = r->head; j; j = j->next) {
+        if (j->tag == tag) return j;
+    }
+    return NULL;
+}
+
+// Locked.
+static void unlink_job(struct async_runner *r, struct job *j) {
+    struct job *prev = NULL;
+    for (struct job *it = r->head; it && it != j; it = it->next) prev = it;
+    if (prev) prev->next = j->next;
+    else r->head = j->next;
+    if (r->tail == j) r->tail = prev;
+}
+
+static bool on_abort(void *user_data) {
+    struct job *j = (struct job *)user_data;
+    if (atomic_load(&j->abort)) return true;
+    return j->prev_abort && j->prev_abort(j->prev_abort_data);
+}
+
+static bool collect(struct whisper_state *state, struct async_result *res) {
+    const int n = whisper_full_n_segments_from_state(state);
+    res->texts = (char **)calloc((size_t)(n > 0 ? n : 1), sizeof(char *));
+    res->t0 = (int64_t *)malloc((size_t)(n > 0 ? n : 1) * sizeof(int64_t));
+    res->t1 = (int64_t *)malloc((size_t)(n > 0 ? n : 1) * sizeof(int64_t));
+    if (!res->texts || !res->t0 || !res->t1) return false;
+    for (int i = 0; i < n; ++i) {
+        const char *text = whisper_full_get_segment_text_from_state(state, i);
+        res->texts[i] = strdup(text ? text : "");
+        if (!res->texts[i]) return false;
+        res->n_segments = i + 1;
+        res->t0[i] = whisper_full_get_segment_t0_from_state(state, i);
+        res->t1[i] = whisper_full_get_segment_t1_from_state(state, i);
+    }
+    return true;
+}
+
+struct worker_arg {
+    struct async_runner *r;
+    int                  index;
+};
+
+static void *worker_main(void *arg) {
+    struct async_runner *r = ((struct worker_arg *)arg)->r;
+    struct whisper_state *state = r->states[((struct worker_arg *)arg)->index];
+    free(arg);
+
+    pthread_mutex_lock(&r->lock);
+    while (!r->stop) {
+        struct job *j = r->head;
+        while (j && j->phase != JOB_QUEUED) j = j->next;
+        if (!j) {
+            pthread_cond_wait(&r->queued, &r->lock);
+            continue;
+        }
+        j->phase = JOB_RUNNING;
+        pthread_mutex_unlock(&r->lock);
+
+        j->prev_abort = j->params.abort_callback;
+        j->prev_abort_data = j->params.abort_callback_user_data;
+        j->params.abort_callback = on_abort;
+        j->params.abort_callback_user_data = j;
+        const int rc = whisper_full_with_state(r->ctx, state, j->params, j->pcm, j->n_samples);
+        const bool ok = rc == 0 && !atomic_load(&j->abort) && collect(state, &j->res);
+        free(j->pcm);
+        j->pcm = NULL;
+
+        pthread_mutex_lock(&r->lock);
+        if (j->detached) {
+            unlink_job(r, j);
+            job_free(j);
+            continue;
+        }
+        if (r->stop) {
+            j->phase = JOB_FAILED;  // freed with the runner, no completion
+            break;
+        }
+        j->phase = ok ? JOB_DONE : JOB_FAILED;
+        const uint64_t tag = j->tag;
+        pthread_mutex_unlock(&r->lock);
+        post_completion(tag);
+        pthread_mutex_lock(&r->lock);
+    }
+    pthread_mutex_unlock(&r->lock);
+    return NULL;
+}
+
+struct async_runner *async_runner_create(struct whisper_context *ctx, int n_workers, int n_threads) {
+    if (!ctx || n_workers < 1 || async_completion_fd() < 0) return NULL;
+    struct async_runner *r = calloc(1, sizeof(*r));
+    if (!r) return NULL;
+    r->ctx = ctx;
+    r->n_workers = n_workers;
+    r->n_threads = n_threads > 0 ? n_threads : 1;
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->queued, NULL);
+    r->workers = calloc((size_t)n_workers, sizeof(pthread_t));
+    r->states = calloc((size_t)n_workers, sizeof(struct whisper_state *));
+    if (!r->workers || !r->states) {
+        async_runner_free(r);
+        return NULL;
+    }
+    for (int i = 0; i < n_workers; ++i) {
+        r->states[i] = whisper_init_state(ctx);
+        struct worker_arg *arg = malloc(sizeof(*arg));
+        if (!r->states[i] || !arg) {
+            free(arg);
+            LOGE("async_runner: can't set up worker %d", i);
+            async_runner_free(r);
+            return NULL;
+        }
+        arg->r = r;
+        arg->index = i;
+        if (pthread_create(&r->workers[i], NULL, worker_main, arg) != 0) {
+            free(arg);
+            async_runner_free(r);
+            return NULL;
+        }
+        r->n_started++;
+    }
+    LOGI("async_runner: %d workers x %d threads", n_workers, r->n_threads);
+    return r;
+}
+
+void async_runner_free(struct async_runner *r) {
+    if (!r) return;
+    pthread_mutex_lock(&r->lock);
+    r->stop = true;
+    for (struct job *j = r->head; j; j = j->next) atomic_store(&j->abort, true);
+    pthread_cond_broadcast(&r->queued);
+    pthread_mutex_unlock(&r->lock);
+    for (int i = 0; i < r->n_started; ++i) pthread_join(r->workers[i], NULL);
+
+    for (struct job *j = r->head; j;) {
+        struct job *next = j->next;
+        job_free(j);
+        j = next;
+    }
+    if (r->states) {
+        for (int i = 0; i < r->n_workers; ++i) {
+            if (r->states[i]) whisper_free_state(r->states[i]);
+        }
+    }
+    free(r->states);
+    free(r->workers);
+    pthread_cond_destroy(&r->queued);
+    pthread_mutex_destroy(&r->lock);
+    free(r);
+}
+
+bool async_runner_submit(struct async_runner *r, struct whisper_full_params params, const float *pcm,
+                         int n_samples, uint64_t tag) {
+    if (!r || !pcm || n_samples <= 0) return false;
+    struct job *j = calloc(1, sizeof(*j));
+    if (!j) return false;
+    j->pcm = (float *)malloc((size_t)n_samples * sizeof(float));
+    j->lang = params.language ? strdup(params.language) : NULL;
+    if (!j->pcm || (params.language && !j->lang)) {
+        job_free(j);
+        return false;
+    }
+    memcpy(j->pcm, pcm, (size_t)n_samples * sizeof(float));
+    j->n_samples = n_samples;
+    j->tag = tag;
+    j->params = params;
+    j->params.language = j->lang;
+    j->params.n_threads = r->n_threads;
+    atomic_init(&j->abort, false);
+
+    pthread_mutex_lock(&r->lock);
+    if (r->stop || find(r, tag)) {
+        pthread_mutex_unlock(&r->lock);
+        job_free(j);
+        return false;
+    }
+    if (r->tail) r->tail->next = j;
+    else r->head = j;
+    r->tail = j;
+    pthread_cond_signal(&r->queued);
+    pthread_mutex_unlock(&r->lock);
+    return true;
+}
+
+int async_runner_take(struct async_runner *r, uint64_t tag, struct async_result *out) {
+    memset(out, 0, sizeof(*out));
+    pthread_mutex_lock(&r->lock);
+    struct job *j = find(r, tag);
+    if (j && (j->phase == JOB_QUEUED || j->phase == JOB_RUNNING)) {
+        pthread_mutex_unlock(&r->lock);
+        return 0;
+    }
+    int rc = -1;
+    if (j) {
+        unlink_job(r, j);
+        if (j->phase == JOB_DONE) {
+            *out = j->res;
+            memset(&j->res, 0, sizeof(j->res));
+            rc = 1;
+        }
+        job_free(j);
+    }
+    pthread_mutex_unlock(&r->lock);
+    return rc;
+}
+
+void async_runner_cancel(struct async_runner *r, uint64_t tag) {
+    pthread_mutex_lock(&r->lock);
+    struct job *j = find(r, tag);
+    if (j) {
+        if (j->phase == JOB_RUNNING) {
+            atomic_store(&j->abort, true);
+            j->detached = true;
+        } else {
+            unlink_job(r, j);
+            job_free(j);
+        }
+    }
+    pthread_mutex_unlock(&r->lock);
+}
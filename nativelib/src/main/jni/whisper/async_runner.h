@@ -0,0 +1,67 @@
+//
+// async_runner.h — transcriptions submitted without blocking the caller
+//
+// A blocking JNI call keeps a JVM thread parked inside whisper_full for the
+// whole run; with several contexts or states those threads pile up. A runner
+// owns native worker threads, one whisper_state each, and a FIFO of submitted
+// jobs. Submit returns at once; a job is named by its caller's 64-bit tag.
+// When a job ends, the tag is posted to one process-wide completion channel
+// (an eventfd plus a queue of tags) that a single thread drains, whatever the
+// number of runners and jobs in flight; the result is then taken by tag.
+//
+// A job cancelled while queued is dropped; while running, it is aborted at
+// the next ggml graph check (abort_callback). Either way no completion is
+// posted for it and its result is freed by the runner.
+//
+
+#ifndef ASYNC_RUNNER_H
+#define ASYNC_RUNNER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "whisper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct async_runner;
+
+struct async_result {
+    int      n_segments;
+    char   **texts;    // n_segments strings
+    int64_t *t0;       // 10 ms units
+    int64_t *t1;
+};
+
+// n_workers states and threads; every job runs whisper_full on one of them
+// with n_threads ggml threads. NULL on failure.
+struct async_runner *async_runner_create(struct whisper_context *ctx, int n_workers, int n_threads);
+// Aborts running jobs and drops the rest (no completions are posted).
+void async_runner_free(struct async_runner *r);
+
+// Queue a run of params over pcm (copied, as is params.language) as job tag
+// (unique among the runner's jobs). False if it can't be queued.
+bool async_runner_submit(struct async_runner *r, struct whisper_full_params params, const float *pcm,
+                         int n_samples, uint64_t tag);
+
+// Take the result of an ended job. 1 = done (*out filled, free with
+// async_result_free), 0 = still queued or running, -1 = failed or unknown.
+// A job's result can be taken once.
+int async_runner_take(struct async_runner *r, uint64_t tag, struct async_result *out);
+void async_result_free(struct async_result *res);
+
+// Drop job tag (see above). Safe on ended or unknown tags.
+void async_runner_cancel(struct async_runner *r, uint64_t tag);
+
+// The completion channel: the fd becomes readable (eventfd counter) when tags
+// are posted; read it, then drain. -1 if it can't be created.
+int async_completion_fd(void);
+int async_completion_drain(uint64_t *tags, int max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ASYNC_RUNNER_H
@@ -0,0 +1,579 @@
+//
+// capture.c — capture engine core, file backend and capture session
+//
+
+#define _FILE_OFFSET_BITS 64
+
+#include "capture_internal.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "native_log.h"
+#include "wav_writer.h"
+
+#define DRAIN_SAMPLES     4096
+#define DRAIN_IDLE_NS     (5 * 1000 * 1000)
+#define FILE_BLOCK_MS     10
+#define FILE_FAST_FRAMES  4096
+
+static void sleep_ns(long ns) {
+    struct timespec ts = { ns / 1000000000L, ns % 1000000000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+/* ===================== Engine core ===================== */
+
+struct capture_engine *capture_engine_alloc(const struct capture_backend_ops *ops,
+                                            int sample_rate, int ring_ms) {
+    struct capture_engine *e = (struct capture_engine *)calloc(1, sizeof(*e));
+    if (!e) return NULL;
+    if (ring_ms <= 0) ring_ms = 2000;
+    const int ring_rate = sample_rate > 48000 ? sample_rate : 48000;
+    if (!ring_init(&e->ring, (size_t)ring_rate * (size_t)ring_ms / 1000)) {
+        free(e);
+        return NULL;
+    }
+    e->ops = ops;
+    e->sample_rate = sample_rate;
+    atomic_init(&e->source_done, false);
+    atomic_init(&e->produced, 0);
+    atomic_init(&e->dropped, 0);
+    return e;
+}
+
+int capture_start(struct capture_engine *e) {
+    return (e && e->ops->start) ? e->ops->start(e) : -1;
+}
+
+void capture_stop(struct capture_engine *e) {
+    if (e && e->ops->stop) e->ops->stop(e);
+}
+
+void capture_close(struct capture_engine *e) {
+    if (!e) return;
+    capture_stop(e);
+    if (e->ops->close) e->ops->close(e);
+    ring_free(&e->ring);
+    free(e);
+}
+
+int capture_sample_rate(const struct capture_engine *e) {
+    return e ? e->sample_rate : 0;
+}
+
+bool capture_source_done(struct capture_engine *e) {
+    return e && atomic_load_explicit(&e->source_done, memory_order_acquire);
+}
+
+/* ===================== File / stdin backend ===================== */
+
+struct file_source {
+    FILE       *f;
+    bool        is_stdin;
+    bool        realtime;
+    int         channels;
+    uint64_t    data_left;          // bytes; UINT64_MAX = until EOF
+    uint8_t     pending[4];         // bytes consumed while sniffing raw input
+    size_t      n_pending;
+    pthread_t   thread;
+    bool        thread_started;
+    atomic_bool running;
+};
+
+static bool read_exact(FILE *f, void *buf, size_t n) {
+    return fread(buf, 1, n, f) == n;
+}
+
+static uint32_t le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// fseek does not work on pipes, so chunks are skipped by reading.
+static bool skip_bytes(FILE *f, uint64_t n) {
+    uint8_t scratch[512];
+    while (n > 0) {
+        size_t take = n < sizeof(scratch) ? (size_t)n : sizeof(scratch);
+        if (!read_exact(f, scratch, take)) return false;
+        n -= take;
+    }
+    return true;
+}
+
+// Sequential RIFF/RF64 parse up to the start of the data chunk.
+static bool parse_wav_header(struct file_source *src, int *sample_rate) {
+    uint8_t buf[16];
+    uint64_t ds64_data = UINT64_MAX;
+    bool have_fmt = false;
+
+    if (!read_exact(src->f, buf, 8) || memcmp(buf + 4, "WAVE", 4) != 0) return false;
+
+    for (;;) {
+        if (!read_exact(src->f, buf, 8)) return false;
+        const uint32_t size = le32(buf + 4);
+
+        if (memcmp(buf, "ds64", 4) == 0) {
+            uint8_t ds[16];
+            if (size < 16 || !read_exact(src->f, ds, 16)) return false;
+            ds64_data = (uint64_t)le32(ds + 8) | ((uint64_t)le32(ds + 12) << 32);
+            if (!skip_bytes(src->f, size - 16)) return false;
+        } else if (memcmp(buf, "fmt ", 4) == 0) {
+            uint8_t fmt[16];
+            if (size < 16 || !read_exact(src->f, fmt, 16)) return false;
+            const uint16_t format = le16(fmt);
+            const uint16_t bits = le16(fmt + 14);
+            src->channels = le16(fmt + 2);
+            *sample_rate = (int)le32(fmt + 4);
+            if ((format != 1 && format != 0xFFFE) || bits != 16 || src->channels < 1) {
+                LOGE("capture: unsupported WAV (format=%u bits=%u ch=%d)", format, bits, src->channels);
+                return false;
+            }
+            if (!skip_bytes(src->f, size - 16 + (size & 1))) return false;
+            have_fmt = true;
+        } else if (memcmp(buf, "data", 4) == 0) {
+            if (!have_fmt) return false;
+            if (size == 0xFFFFFFFFu) src->data_left = ds64_data;
+            else if (size == 0)      src->data_left = UINT64_MAX;   // streamed, size never patched
+            else                     src->data_left = size;
+            return true;
+        } else if (!skip_bytes(src->f, (uint64_t)size + (size & 1))) {
+            return false;
+        }
+    }
+}
+
+// Reads up to max bytes, serving sniffed bytes first and honoring data_left.
+static size_t file_read(struct file_source *src, uint8_t *dst, size_t max) {
+    if (src->data_left != UINT64_MAX && max > src->data_left) max = (size_t)src->data_left;
+    size_t got = 0;
+    while (src->n_pending > 0 && got < max) {
+        dst[got++] = src->pending[0];
+        memmove(src->pending, src->pending + 1, --src->n_pending);
+    }
+    if (got < max) got += fread(dst + got, 1, max - got, src->f);
+    if (src->data_left != UINT64_MAX) src->data_left -= got;
+    return got;
+}
+
+static void *file_reader_main(void *arg) {
+    struct capture_engine *e = (struct capture_engine *)arg;
+    struct file_source *src = (struct file_source *)e->impl;
+
+    const size_t frames = src->realtime
+                        ? (size_t)e->sample_rate * FILE_BLOCK_MS / 1000
+                        : FILE_FAST_FRAMES;
+    const size_t frame_bytes = (size_t)src->channels * sizeof(int16_t);
+    uint8_t *raw = (uint8_t *)malloc(frames * frame_bytes);
+    int16_t *mono = (int16_t *)malloc(frames * sizeof(int16_t));
+    size_t carry = 0;   // partial frame bytes left in raw from the previous read
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (raw && mono && atomic_load_explicit(&src->running, memory_order_acquire)) {
+        size_t got = carry + file_read(src, raw + carry, frames * frame_bytes - carry);
+        const size_t n = got / frame_bytes;
+        if (n == 0) break;
+
+        const int16_t *in = (const int16_t *)raw;
+        if (src->channels == 1) {
+            memcpy(mono, in, n * sizeof(int16_t));
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                int32_t acc = 0;
+                for (int c = 0; c < src->channels; c++) acc += in[i * src->channels + c];
+                mono[i] = (int16_t)(acc / src->channels);
+            }
+        }
+        carry = got - n * frame_bytes;
+        if (carry > 0) memmove(raw, raw + n * frame_bytes, carry);
+
+        if (src->realtime) {
+            // Behaves like a microphone: late consumer means dropped samples.
+            capture_engine_push(e, mono, n);
+            next.tv_nsec += (long)(n * 1000000000ull / (uint64_t)e->sample_rate);
+            while (next.tv_nsec >= 1000000000L) { next.tv_nsec -= 1000000000L; next.tv_sec++; }
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR) {}
+        } else {
+            // Fast mode is lossless: wait for the drain thread instead of dropping.
+            size_t off = 0;
+            atomic_fetch_add_explicit(&e->produced, n, memory_order_relaxed);
+            while (off < n && atomic_load_explicit(&src->running, memory_order_acquire)) {
+                size_t w = ring_write(&e->ring, mono + off, n - off);
+                off += w;
+                if (w == 0) sleep_ns(1000 * 1000);
+            }
+        }
+    }
+
+    free(raw);
+    free(mono);
+    atomic_store_explicit(&e->source_done, true, memory_order_release);
+    return NULL;
+}
+
+static int file_start(struct capture_engine *e) {
+    struct file_source *src = (struct file_source *)e->impl;
+    if (src->thread_started) return 0;
+    atomic_store(&src->running, true);
+    if (pthread_create(&src->thread, NULL, file_reader_main, e) != 0) {
+        LOGE("capture: failed to start file reader");
+        return -1;
+    }
+    src->thread_started = true;
+    return 0;
+}
+
+static void file_stop(struct capture_engine *e) {
+    struct file_source *src = (struct file_source *)e->impl;
+    if (!src->thread_started) return;
+    atomic_store(&src->running, false);
+    pthread_join(src->thread, NULL);
+    src->thread_started = false;
+}
+
+static void file_close(struct capture_engine *e) {
+    struct file_source *src = (struct file_source *)e->impl;
+    if (!src) return;
+    if (src->f && !src->is_stdin) fclose(src->f);
+    free(src);
+    e->impl = NULL;
+}
+
+static const struct capture_backend_ops FILE_OPS = {
+    .start = file_start,
+    .stop  = file_stop,
+    .close = file_close,
+};
+
+struct capture_engine *capture_open_file(const char *path, int raw_sample_rate,
+                                         bool realtime, int ring_ms) {
+    if (!path) return NULL;
+    struct file_source *src = (struct file_source *)calloc(1, sizeof(*src));
+    if (!src) return NULL;
+
+    src->is_stdin = strcmp(path, "-") == 0;
+    src->f = src->is_stdin ? stdin : fopen(path, "rb");
+    if (!src->f) {
+        LOGE("capture: cannot open %s", path);
+        free(src);
+        return NULL;
+    }
+    src->realtime = realtime;
+    src->channels = 1;
+    src->data_left = UINT64_MAX;
+    atomic_init(&src->running, false);
+
+    int rate = raw_sample_rate;
+    src->n_pending = fread(src->pending, 1, 4, src->f);
+    if (src->n_pending == 4 && (memcmp(src->pending, "RIFF", 4) == 0 || memcmp(src->pending, "RF64", 4) == 0)) {
+        src->n_pending = 0;
+        if (!parse_wav_header(src, &rate)) {
+            LOGE("capture: invalid WAV header in %s", path);
+            if (!src->is_stdin) fclose(src->f);
+            free(src);
+            return NULL;
+        }
+    }
+    if (rate <= 0) {
+        LOGE("capture: raw input needs a sample rate");
+        if (!src->is_stdin) fclose(src->f);
+        free(src);
+        return NULL;
+    }
+
+    struct capture_engine *e = capture_engine_alloc(&FILE_OPS, rate, ring_ms);
+    if (!e) {
+        if (!src->is_stdin) fclose(src->f);
+        free(src);
+        return NULL;
+    }
+    e->impl = src;
+    return e;
+}
+
+/* ===================== Session ===================== */
+
+struct capture_session {
+    struct capture_engine *engine;
+    struct pcm_buffer     *pcm;
+    struct wav_writer     *wav;
+    size_t                 max_handoff;
+    bool                   overflow;
+    bool                   wav_failed;
+
+    pthread_t              thread;
+    bool                   thread_started;
+    atomic_bool            stop_requested;
+    atomic_uint_least64_t  consumed;
+    atomic_size_t          ring_peak;
+
+    struct endpointer     *endpointer;
+
+    // pcm, wav, overflow, wav_failed and endpointer: drain thread vs split
+    pthread_mutex_t        sink_lock;
+
+    pthread_mutex_t        lock;
+    pthread_cond_t         cond;
+    bool                   source_drained;
+    bool                   endpoint_reached;
+    bool                   stopped;
+};
+
+static void session_consume(struct capture_session *s, const int16_t *samples, size_t n) {
+    pthread_mutex_lock(&s->sink_lock);
+    if (!s->overflow) {
+        if (s->max_handoff > 0 && pcm_buffer_samples(s->pcm) + n > s->max_handoff) {
+            LOGW("capture: handoff limit reached, buffer stops growing");
+            s->overflow = true;
+        } else if (!pcm_buffer_append(s->pcm, samples, n)) {
+            s->overflow = true;
+        }
+    }
+    if (s->wav && !s->wav_failed && !wav_writer_write(s->wav, samples, n)) {
+        LOGE("capture: WAV write failed");
+        s->wav_failed = true;
+    }
+    atomic_fetch_add_explicit(&s->consumed, n, memory_order_relaxed);
+
+    const bool endpoint = s->endpointer && endpointer_feed(s->endpointer, samples, n);
+    if (endpoint) {
+        LOGI("capture: endpoint at %.2f s", (double)endpointer_speech_end(s->endpointer) / s->engine->sample_rate);
+    }
+    pthread_mutex_unlock(&s->sink_lock);
+
+    if (endpoint) {
+        pthread_mutex_lock(&s->lock);
+        s->endpoint_reached = true;
+        pthread_cond_broadcast(&s->cond);
+        pthread_mutex_unlock(&s->lock);
+    }
+}
+
+static void *session_drain_main(void *arg) {
+    struct capture_session *s = (struct capture_session *)arg;
+    struct ring_buffer *ring = &s->engine->ring;
+    int16_t block[DRAIN_SAMPLES];
+
+    for (;;) {
+        const size_t avail = ring_available(ring);
+        if (avail > atomic_load_explicit(&s->ring_peak, memory_order_relaxed))
+            atomic_store_explicit(&s->ring_peak, avail, memory_order_relaxed);
+
+        const size_t n = ring_read(ring, block, DRAIN_SAMPLES);
+        if (n > 0) {
+            session_consume(s, block, n);
+            continue;
+        }
+        // The engine is stopped before stop_requested is set, so an empty ring
+        // here means everything has been drained.
+        if (atomic_load_explicit(&s->stop_requested, memory_order_acquire)) break;
+
+        if (capture_source_done(s->engine) && ring_available(ring) == 0) {
+            pthread_mutex_lock(&s->lock);
+            if (!s->source_drained) {
+                s->source_drained = true;
+                pthread_cond_broadcast(&s->cond);
+            }
+            pthread_mutex_unlock(&s->lock);
+        }
+        sleep_ns(DRAIN_IDLE_NS);
+    }
+    return NULL;
+}
+
+struct capture_session *capture_session_start(struct capture_engine *e, const char *wav_path,
+                                              size_t max_handoff_samples,
+                                              const struct endpoint_config *endpoint) {
+    if (!e) return NULL;
+    struct capture_session *s = (struct capture_session *)calloc(1, sizeof(*s));
+    if (!s) return NULL;
+
+    s->engine = e;
+    s->max_handoff = max_handoff_samples;
+    s->pcm = pcm_buffer_create(e->sample_rate);
+    atomic_init(&s->stop_requested, false);
+    atomic_init(&s->consumed, 0);
+    atomic_init(&s->ring_peak, 0);
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    pthread_mutex_init(&s->sink_lock, NULL);
+
+    if (wav_path) {
+        s->wav = wav_writer_open(wav_path, e->sample_rate);
+        s->wav_failed = (s->wav == NULL);
+    }
+    if (endpoint) s->endpointer = endpointer_create(endpoint, e->sample_rate);
+
+    if (!s->pcm || (endpoint && !s->endpointer) || pthread_create(&s->thread, NULL, session_drain_main, s) != 0) {
+        LOGE("capture: failed to start session");
+        s->stopped = true;
+        capture_session_free(s);
+        return NULL;
+    }
+    s->thread_started = true;
+
+    if (capture_start(e) != 0) {
+        capture_session_free(s);
+        return NULL;
+    }
+    return s;
+}
+
+void capture_session_wait_source(struct capture_session *s) {
+    if (!s) return;
+    pthread_mutex_lock(&s->lock);
+    while (!s->source_drained && !s->stopped) pthread_cond_wait(&s->cond, &s->lock);
+    pthread_mutex_unlock(&s->lock);
+}
+
+bool capture_session_wait_endpoint(struct capture_session *s, int timeout_ms) {
+    if (!s) return false;
+    struct timespec deadline;
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec  += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) { deadline.tv_nsec -= 1000000000L; deadline.tv_sec++; }
+    }
+
+    pthread_mutex_lock(&s->lock);
+    while (!s->endpoint_reached && !s->source_drained && !s->stopped) {
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&s->cond, &s->lock);
+        } else if (pthread_cond_timedwait(&s->cond, &s->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    const bool reached = s->endpoint_reached;
+    pthread_mutex_unlock(&s->lock);
+    return reached;
+}
+
+struct pcm_buffer *capture_session_pcm(struct capture_session *s) {
+    return s ? s->pcm : NULL;
+}
+
+int capture_session_sample_rate(const struct capture_session *s) {
+    return s ? capture_sample_rate(s->engine) : 0;
+}
+
+void capture_session_stats(struct capture_session *s, struct capture_stats *out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!s) return;
+    out->produced  = atomic_load_explicit(&s->engine->produced, memory_order_relaxed);
+    out->dropped   = atomic_load_explicit(&s->engine->dropped, memory_order_relaxed);
+    out->consumed  = atomic_load_explicit(&s->consumed, memory_order_relaxed);
+    out->ring_peak = atomic_load_explicit(&s->ring_peak, memory_order_relaxed);
+}
+
+// Stops the engine and joins the drain thread; idempotent.
+static void session_halt(struct capture_session *s) {
+    capture_stop(s->engine);
+    atomic_store_explicit(&s->stop_requested, true, memory_order_release);
+    if (s->thread_started) {
+        pthread_join(s->thread, NULL);
+        s->thread_started = false;
+    }
+    pthread_mutex_lock(&s->lock);
+    s->stopped = true;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+}
+
+struct pcm_buffer *capture_session_stop(struct capture_session *s, bool *wav_ok) {
+    if (wav_ok) *wav_ok = false;
+    if (!s) return NULL;
+    session_halt(s);
+
+    if (s->wav) {
+        if (!wav_writer_close(s->wav)) s->wav_failed = true;
+        s->wav = NULL;
+        if (wav_ok) *wav_ok = !s->wav_failed;
+    }
+
+    struct capture_stats st;
+    capture_session_stats(s, &st);
+    LOGI("capture: stopped (produced=%llu dropped=%llu consumed=%llu ring_peak=%zu)",
+         (unsigned long long)st.produced, (unsigned long long)st.dropped,
+         (unsigned long long)st.consumed, st.ring_peak);
+
+    struct pcm_buffer *pcm = s->pcm;
+    s->pcm = NULL;
+    if (s->overflow) {
+        pcm_buffer_free(pcm);
+        return NULL;
+    }
+    return pcm;
+}
+
+bool capture_session_split(struct capture_session *s, const char *wav_path,
+                           struct pcm_buffer **pcm_out, bool *wav_ok) {
+    if (pcm_out) *pcm_out = NULL;
+    if (wav_ok) *wav_ok = false;
+    if (!s) return false;
+    pthread_mutex_lock(&s->lock);
+    const bool stopped = s->stopped;
+    pthread_mutex_unlock(&s->lock);
+    if (stopped) return false;
+
+    // Everything that can fail or block happens outside the drain thread's way.
+    struct pcm_buffer *pcm = pcm_buffer_create(s->engine->sample_rate);
+    struct wav_writer *wav = wav_path ? wav_writer_open(wav_path, s->engine->sample_rate) : NULL;
+    if (!pcm || (wav_path && !wav)) {
+        LOGE("capture: split failed, recording continues unchanged");
+        pcm_buffer_free(pcm);
+        if (wav) wav_writer_close(wav);
+        return false;
+    }
+
+    pthread_mutex_lock(&s->sink_lock);
+    struct pcm_buffer *old_pcm = s->pcm;
+    struct wav_writer *old_wav = s->wav;
+    const bool old_overflow = s->overflow;
+    const bool old_wav_failed = s->wav_failed;
+    s->pcm = pcm;
+    s->wav = wav;
+    s->overflow = false;
+    s->wav_failed = false;
+    if (s->endpointer) endpointer_rearm(s->endpointer);
+    pthread_mutex_unlock(&s->sink_lock);
+
+    pthread_mutex_lock(&s->lock);
+    s->endpoint_reached = false;
+    pthread_mutex_unlock(&s->lock);
+
+    bool ok = !old_wav_failed;
+    if (old_wav && !wav_writer_close(old_wav)) ok = false;
+    if (wav_ok) *wav_ok = old_wav && ok;
+
+    if (old_overflow) {
+        pcm_buffer_free(old_pcm);
+    } else if (pcm_out) {
+        *pcm_out = old_pcm;
+    } else {
+        pcm_buffer_free(old_pcm);
+    }
+    return true;
+}
+
+void capture_session_free(struct capture_session *s) {
+    if (!s) return;
+    session_halt(s);
+    if (s->wav) wav_writer_close(s->wav);
+    pcm_buffer_free(s->pcm);
+    capture_close(s->engine);
+    endpointer_free(s->endpointer);
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->lock);
+    pthread_mutex_destroy(&s->sink_lock);
+    free(s);
+}
@@ -0,0 +1,109 @@
+//
+// capture.h — native audio capture engine + capture session
+//
+// Engine: a backend produces 16-bit mono PCM into a lock-free SPSC ring.
+//   - AAudio (Android): low-latency input stream, the data callback writes
+//     straight into the ring (no locks, no allocation, no JVM).
+//   - File (any platform): reads a WAV or raw s16le file, or stdin ("-"),
+//     optionally paced in real time, so the capture -> text pipeline can be
+//     driven and benchmarked on a Linux host (see tools/capture_bench.c).
+//
+// Session: one drain thread owns the consumer end of the ring and moves the
+// audio into a pcm_buffer (handed to whisper at stop) and, optionally, a WAV
+// file. Transcription therefore reads the captured samples directly.
+// The drain thread can also run an endpointer, so the end of an utterance is
+// detected on the stream itself instead of waiting for a manual stop.
+//
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "endpointer.h"
+#include "pcm_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct capture_engine;
+struct capture_session;
+
+struct capture_stats {
+    uint64_t produced;     // samples the backend delivered
+    uint64_t dropped;      // samples lost because the ring was full
+    uint64_t consumed;     // samples drained by the session
+    size_t   ring_peak;    // high-water mark of the ring (samples)
+};
+
+/* ---- Engine ---- */
+
+#ifdef __ANDROID__
+// Open an AAudio input stream. The device may pick a different rate than
+// requested; use capture_sample_rate() for the actual one.
+struct capture_engine *capture_open_aaudio(int sample_rate, int ring_ms);
+#endif
+
+// path "-" reads stdin. WAV input uses its own header; raw input is taken as
+// s16le mono at raw_sample_rate. realtime paces delivery like a microphone.
+struct capture_engine *capture_open_file(const char *path, int raw_sample_rate,
+                                         bool realtime, int ring_ms);
+
+int  capture_start(struct capture_engine *e);
+void capture_stop(struct capture_engine *e);
+void capture_close(struct capture_engine *e);
+
+int  capture_sample_rate(const struct capture_engine *e);
+// True once a finite source (file) has delivered everything.
+bool capture_source_done(struct capture_engine *e);
+
+/* ---- Session ---- */
+
+// Starts the engine and the drain thread. wav_path may be NULL. Once more than
+// max_handoff_samples are captured (0 = unlimited) the pcm_buffer stops
+// growing; the WAV keeps everything. endpoint (may be NULL) enables end of
+// utterance detection. The session takes ownership of the engine, also when
+// it fails (the engine is closed and NULL is returned).
+struct capture_session *capture_session_start(struct capture_engine *e, const char *wav_path,
+                                              size_t max_handoff_samples,
+                                              const struct endpoint_config *endpoint);
+
+// Block until a finite source is exhausted and fully drained (host tools).
+void capture_session_wait_source(struct capture_session *s);
+
+// Block up to timeout_ms (< 0 = forever) for the endpoint. Returns true once
+// it has been reached; false on timeout, or when the source ended or the
+// session was stopped without one.
+bool capture_session_wait_endpoint(struct capture_session *s, int timeout_ms);
+
+// Read-only access to the live buffer (e.g. for early language detection).
+struct pcm_buffer *capture_session_pcm(struct capture_session *s);
+int  capture_session_sample_rate(const struct capture_session *s);
+void capture_session_stats(struct capture_session *s, struct capture_stats *out);
+
+// Stop capture, drain the ring, finalize the WAV. Returns the pcm_buffer
+// (ownership passes to the caller) or NULL if the handoff limit was hit.
+// The session still has to be released with capture_session_free().
+struct pcm_buffer *capture_session_stop(struct capture_session *s, bool *wav_ok);
+
+// Cut the recording here without stopping the stream (e.g. at an endpoint):
+// what was captured so far is finished like capture_session_stop() would
+// (*pcm_out is NULL if the handoff limit was hit, the WAV is finalized), and
+// capture goes on into a fresh buffer and wav_path (may be NULL) with the
+// endpointer re-armed. No sample is lost or duplicated across the cut.
+// Returns false, and changes nothing, if the new buffer or file can't be
+// created. Must not race with capture_session_pcm() readers.
+bool capture_session_split(struct capture_session *s, const char *wav_path,
+                           struct pcm_buffer **pcm_out, bool *wav_ok);
+
+// Frees the session and its engine (stopping first if needed).
+void capture_session_free(struct capture_session *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CAPTURE_H
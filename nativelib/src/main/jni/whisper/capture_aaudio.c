@@ -0,0 +1,146 @@
+//
+// capture_aaudio.c — AAudio input backend for the capture engine
+//
+// The data callback runs on a real-time audio thread: it only converts to
+// mono if needed and pushes into the ring. Everything else (WAV, pcm_buffer)
+// happens on the session drain thread.
+//
+
+#ifdef __ANDROID__
+
+#include "capture_internal.h"
+
+#include <aaudio/AAudio.h>
+
+#include "native_log.h"
+
+#define DOWNMIX_FRAMES 256
+
+struct aaudio_source {
+    AAudioStream *stream;
+    int           channels;
+    bool          started;
+};
+
+static aaudio_data_callback_result_t on_audio(AAudioStream *stream, void *user,
+                                              void *audio, int32_t num_frames) {
+    (void)stream;
+    struct capture_engine *e = (struct capture_engine *)user;
+    const struct aaudio_source *src = (const struct aaudio_source *)e->impl;
+    const int16_t *in = (const int16_t *)audio;
+
+    if (src->channels == 1) {
+        capture_engine_push(e, in, (size_t)num_frames);
+        return AAUDIO_CALLBACK_RESULT_CONTINUE;
+    }
+
+    // Mono was requested, but the device is free to ignore that.
+    int16_t mono[DOWNMIX_FRAMES];
+    for (int32_t done = 0; done < num_frames; ) {
+        int32_t n = num_frames - done;
+        if (n > DOWNMIX_FRAMES) n = DOWNMIX_FRAMES;
+        for (int32_t i = 0; i < n; i++) {
+            int32_t acc = 0;
+            for (int c = 0; c < src->channels; c++) acc += in[(done + i) * src->channels + c];
+            mono[i] = (int16_t)(acc / src->channels);
+        }
+        capture_engine_push(e, mono, (size_t)n);
+        done += n;
+    }
+    return AAUDIO_CALLBACK_RESULT_CONTINUE;
+}
+
+static void on_error(AAudioStream *stream, void *user, aaudio_result_t error) {
+    (void)stream;
+    struct capture_engine *e = (struct capture_engine *)user;
+    // Typically a disconnect (headset unplugged). The stream cannot be reopened
+    // from this thread; end the source so the session can be stopped cleanly.
+    LOGE("capture: AAudio stream error %s", AAudio_convertResultToText(error));
+    atomic_store_explicit(&e->source_done, true, memory_order_release);
+}
+
+static int aaudio_start(struct capture_engine *e) {
+    struct aaudio_source *src = (struct aaudio_source *)e->impl;
+    if (src->started) return 0;
+    aaudio_result_t r = AAudioStream_requestStart(src->stream);
+    if (r != AAUDIO_OK) {
+        LOGE("capture: AAudio start failed: %s", AAudio_convertResultToText(r));
+        return -1;
+    }
+    src->started = true;
+    return 0;
+}
+
+static void aaudio_stop(struct capture_engine *e) {
+    struct aaudio_source *src = (struct aaudio_source *)e->impl;
+    if (!src->started) return;
+    // requestStop returns once no further callbacks will be issued.
+    AAudioStream_requestStop(src->stream);
+    src->started = false;
+}
+
+static void aaudio_close(struct capture_engine *e) {
+    struct aaudio_source *src = (struct aaudio_source *)e->impl;
+    if (!src) return;
+    if (src->stream) AAudioStream_close(src->stream);
+    free(src);
+    e->impl = NULL;
+}
+
+static const struct capture_backend_ops AAUDIO_OPS = {
+    .start = aaudio_start,
+    .stop  = aaudio_stop,
+    .close = aaudio_close,
+};
+
+struct capture_engine *capture_open_aaudio(int sample_rate, int ring_ms) {
+    struct aaudio_source *src = (struct aaudio_source *)calloc(1, sizeof(*src));
+    if (!src) return NULL;
+
+    // The engine is the callback user pointer, so it exists before the stream.
+    struct capture_engine *e = capture_engine_alloc(&AAUDIO_OPS, sample_rate, ring_ms);
+    if (!e) { free(src); return NULL; }
+    e->impl = src;
+
+    AAudioStreamBuilder *builder = NULL;
+    aaudio_result_t r = AAudio_createStreamBuilder(&builder);
+    if (r != AAUDIO_OK) {
+        LOGE("capture: AAudio builder failed: %s", AAudio_convertResultToText(r));
+        capture_close(e);
+        return NULL;
+    }
+
+    AAudioStreamBuilder_setDirection(builder, AAUDIO_DIRECTION_INPUT);
+    AAudioStreamBuilder_setSampleRate(builder, sample_rate);
+    AAudioStreamBuilder_setChannelCount(builder, 1);
+    AAudioStreamBuilder_setFormat(builder, AAUDIO_FORMAT_PCM_I16);
+    AAudioStreamBuilder_setPerformanceMode(builder, AAUDIO_PERFORMANCE_MODE_LOW_LATENCY);
+    AAudioStreamBuilder_setSharingMode(builder, AAUDIO_SHARING_MODE_SHARED);
+#if __ANDROID_API__ >= 28
+    AAudioStreamBuilder_setInputPreset(builder, AAUDIO_INPUT_PRESET_VOICE_RECOGNITION);
+#endif
+    AAudioStreamBuilder_setDataCallback(builder, on_audio, e);
+    AAudioStreamBuilder_setErrorCallback(builder, on_error, e);
+
+    r = AAudioStreamBuilder_openStream(builder, &src->stream);
+    AAudioStreamBuilder_delete(builder);
+    if (r != AAUDIO_OK) {
+        LOGE("capture: AAudio open failed: %s", AAudio_convertResultToText(r));
+        src->stream = NULL;
+        capture_close(e);
+        return NULL;
+    }
+
+    src->channels = AAudioStream_getChannelCount(src->stream);
+    e->sample_rate = AAudioStream_getSampleRate(src->stream);
+    if (src->channels < 1 || e->sample_rate <= 0) {
+        LOGE("capture: AAudio stream reported an invalid format");
+        capture_close(e);
+        return NULL;
+    }
+    LOGI("capture: AAudio input %d Hz, %d ch, burst %d frames",
+         e->sample_rate, src->channels, AAudioStream_getFramesPerBurst(src->stream));
+    return e;
+}
+
+#endif // __ANDROID__
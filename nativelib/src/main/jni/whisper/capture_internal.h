@@ -0,0 +1,40 @@
+//
+// capture_internal.h — engine layout shared by capture.c and the backends
+//
+
+#ifndef CAPTURE_INTERNAL_H
+#define CAPTURE_INTERNAL_H
+
+#include <stdatomic.h>
+
+#include "capture.h"
+#include "ring_buffer.h"
+
+struct capture_backend_ops {
+    int  (*start)(struct capture_engine *e);
+    void (*stop)(struct capture_engine *e);
+    void (*close)(struct capture_engine *e);   // frees impl
+};
+
+struct capture_engine {
+    const struct capture_backend_ops *ops;
+    void              *impl;
+    struct ring_buffer ring;
+    int                sample_rate;
+    atomic_bool        source_done;
+    atomic_uint_least64_t produced;
+    atomic_uint_least64_t dropped;
+};
+
+// Allocates the engine and its ring (sized for ring_ms at max(rate, 48 kHz)).
+struct capture_engine *capture_engine_alloc(const struct capture_backend_ops *ops,
+                                            int sample_rate, int ring_ms);
+
+// Producer entry point; real-time safe (no locks, no allocation).
+static inline void capture_engine_push(struct capture_engine *e, const int16_t *samples, size_t n) {
+    size_t written = ring_write(&e->ring, samples, n);
+    atomic_fetch_add_explicit(&e->produced, n, memory_order_relaxed);
+    if (written < n) atomic_fetch_add_explicit(&e->dropped, n - written, memory_order_relaxed);
+}
+
+#endif // CAPTURE_INTERNAL_H
@@ -0,0 +1,221 @@
+//
+// clip_pack.c — many short clips per encoder window (see clip_pack.h)
+//
+
+#include "clip_pack.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "native_log.h"
+
+#define MS_TO_SAMPLES(ms) ((int)((int64_t)(ms) * WHISPER_SAMPLE_RATE / 1000))
+#define SAMPLES_TO_CS(n)  ((int64_t)(n) * 100 / WHISPER_SAMPLE_RATE)
+
+int clip_pack_plan(const int *n_samples, int n_clips, int *pack_start) {
+    const int window = MS_TO_SAMPLES(CLIP_PACK_WINDOW_MS);
+    const int gap = MS_TO_SAMPLES(CLIP_PACK_GAP_MS);
+    int n_packs = 0;
+    int used = 0;  // samples in the current pack, 0 = no pack open
+
+    for (int i = 0; i < n_clips; ++i) {
+        const int len = n_samples[i];
+        if (used > 0 && used + gap + len <= window) {
+            used += gap + len;
+            continue;
+        }
+        pack_start[n_packs++] = i;
+        // A clip that fills the window alone closes its pack straight away.
+        used = len < window ? len : window;
+    }
+    return n_packs;
+}
+
+int clip_pack_locate(const int64_t *start, const int64_t *end, int n, int64_t t) {
+    const int64_t tol = CLIP_PACK_TOLERANCE_MS / 10;
+    for (int i = 0; i < n; ++i) {
+        if (t >= start[i] - tol && t <= end[i] + tol) return i;
+    }
+    return -1;
+}
+
+int clip_pack_audio_ctx(struct whisper_context *ctx, int n_samples) {
+    // 1500 positions per 30 s: one per 320 samples, plus a little margin.
+    int n = ((n_samples / 320 + 32 + 63) / 64) * 64;
+    if (n < 256) n = 256;
+    return n < whisper_n_audio_ctx(ctx) ? n : 0;
+}
+
+// Appends s to *buf (malloc'd, may be NULL). Returns false on OOM.
+static bool append_text(char **buf, const char *s) {
+    const size_t old = *buf ? strlen(*buf) : 0;
+    const size_t add = strlen(s);
+    char *p = (char *)realloc(*buf, old + add + 1);
+    if (!p) return false;
+    memcpy(p + old, s, add + 1);
+    *buf = p;
+    return true;
+}
+
+// All segment text of the last run on state (malloc'd), or NULL on OOM.
+static char *collect_text(struct whisper_state *state) {
+    char *text = NULL;
+    if (!append_text(&text, "")) return NULL;
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    for (int i = 0; i < n_segments; ++i) {
+        if (!append_text(&text, whisper_full_get_segment_text_from_state(state, i))) {
+            free(text);
+            return NULL;
+        }
+    }
+    return text;
+}
+
+static char *transcribe_single(struct whisper_context *ctx, struct whisper_state *state,
+                               struct whisper_full_params params, const float *clip, int n,
+                               struct clip_pack_stats *stats) {
+    params.token_timestamps = false;
+    stats->singles++;
+    if (whisper_full_with_state(ctx, state, params, clip, n) != 0) {
+        LOGW("transcribe_many: whisper_full failed on a single clip");
+        return NULL;
+    }
+    return collect_text(state);
+}
+
+// Decode clips [first, first + count) in one window and split the text back.
+// Returns false if the guard rejected the pack; texts are then left untouched.
+static bool transcribe_pack(struct whisper_context *ctx, struct whisper_state *state,
+                            struct whisper_full_params params, const float *const *clips, const int *n_samples, int first, int count,
+                            char **texts, struct clip_pack_stats *stats) {
+    const int gap = MS_TO_SAMPLES(CLIP_PACK_GAP_MS);
+    int total = 0;
+    for (int i = 0; i < count; ++i) total += (i > 0 ? gap : 0) + n_samples[first + i];
+
+    float *packed = (float *)calloc((size_t)total, sizeof(float));
+    int64_t *start = (int64_t *)malloc((size_t)count * sizeof(int64_t));
+    int64_t *end = (int64_t *)malloc((size_t)count * sizeof(int64_t));
+    char **parts = (char **)calloc((size_t)count, sizeof(char *));
+    bool ok = packed && start && end && parts;
+
+    if (ok) {
+        int off = 0;
+        for (int i = 0; i < count; ++i) {
+            if (i > 0) off += gap;
+            if (n_samples[first + i] > 0) {
+                memcpy(packed + off, clips[first + i], (size_t)n_samples[first + i] * sizeof(float));
+            }
+            start[i] = SAMPLES_TO_CS(off);
+            off += n_samples[first + i];
+            end[i] = SAMPLES_TO_CS(off);
+        }
+
+        params.token_timestamps = true;
+        stats->windows++;
+        ok = whisper_full_with_state(ctx, state, params, packed, total) == 0;
+        if (!ok) LOGW("transcribe_many: whisper_full failed on a pack of %d", count);
+    }
+
+    const whisper_token eot = ok ? whisper_token_eot(ctx) : 0;
+    const int n_segments = ok ? whisper_full_n_segments_from_state(state) : 0;
+    for (int s = 0; ok && s < n_segments; ++s) {
+        const int n_tokens = whisper_full_n_tokens_from_state(state, s);
+        for (int t = 0; ok && t < n_tokens; ++t) {
+            const whisper_token_data td = whisper_full_get_token_data_from_state(state, s, t);
+            if (td.id >= eot) continue;
+            const int clip = clip_pack_locate(start, end, count, (td.t0 + td.t1) / 2);
+            if (clip < 0) {
+                LOGI("transcribe_many: text in a gap at %lld cs, decoding %d clips separately",
+                     (long long)td.t0, count);
+                ok = false;
+                break;
+            }
+            ok = append_text(&parts[clip], whisper_full_get_token_text_from_state(ctx, state, s, t));
+        }
+    }
+
+    if (ok) {
+        for (int i = 0; i < count; ++i) texts[first + i] = parts[i];  // NULL = no text, retried
+    } else if (parts) {
+        for (int i = 0; i < count; ++i) free(parts[i]);
+    }
+    free(parts);
+    free(end);
+    free(start);
+    free(packed);
+    return ok;
+}
+
+struct many_run {
+    struct whisper_context     *ctx;
+    struct whisper_full_params  params;
+    const float *const         *clips;
+    const int                  *n_samples;
+    int                         n_clips;
+    const int                  *pack_start;
+    int                         n_packs;
+    char                      **texts;
+    struct clip_pack_stats     *pack_stats;  // one per pack, summed at the end
+};
+
+// One pack on one state (state_pool_job).
+static void run_pack(void *user, struct whisper_state *state, int p, int n_threads) {
+    struct many_run *run = (struct many_run *)user;
+    struct whisper_full_params params = run->params;
+    params.n_threads = n_threads;
+    struct clip_pack_stats *stats = &run->pack_stats[p];
+
+    const int first = run->pack_start[p];
+    const int count = (p + 1 < run->n_packs ? run->pack_start[p + 1] : run->n_clips) - first;
+    if (count > 1 && !transcribe_pack(run->ctx, state, params, run->clips, run->n_samples,
+                                      first, count, run->texts, stats)) {
+        stats->fallbacks++;
+    }
+    // Single clips, rejected packs and clips a pack left without text.
+    for (int i = first; i < first + count; ++i) {
+        if (run->texts[i]) continue;
+        run->texts[i] = run->n_samples[i] > 0
+                ? transcribe_single(run->ctx, state, params, run->clips[i], run->n_samples[i], stats)
+                : strdup("");
+    }
+}
+
+bool transcribe_many(struct state_pool *pool, struct whisper_full_params params,
+                     const float *const *clips, const int *n_samples, int n_clips,
+                     char **texts, struct clip_pack_stats *stats) {
+    if (!pool || !clips || !n_samples || !texts || n_clips <= 0) return false;
+    struct clip_pack_stats local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    memset(texts, 0, (size_t)n_clips * sizeof(char *));
+
+    int *pack_start = (int *)malloc((size_t)n_clips * sizeof(int));
+    struct clip_pack_stats *pack_stats = (struct clip_pack_stats *)calloc((size_t)n_clips, sizeof(*pack_stats));
+    if (!pack_start || !pack_stats) {
+        free(pack_stats);
+        free(pack_start);
+        return false;
+    }
+
+    struct many_run run = {
+        .ctx = state_pool_context(pool), .params = params,
+        .clips = clips, .n_samples = n_samples, .n_clips = n_clips,
+        .pack_start = pack_start, .n_packs = clip_pack_plan(n_samples, n_clips, pack_start),
+        .texts = texts, .pack_stats = pack_stats,
+    };
+    // Packs are independent: one per pool state at a time.
+    state_pool_run(pool, run.n_packs, params.n_threads, run_pack, &run);
+
+    for (int p = 0; p < run.n_packs; ++p) {
+        stats->windows   += pack_stats[p].windows;
+        stats->singles   += pack_stats[p].singles;
+        stats->fallbacks += pack_stats[p].fallbacks;
+    }
+    free(pack_stats);
+    free(pack_start);
+
+    LOGI("transcribe_many: %d clips in %d packed windows + %d single runs (%d packs rejected, %d states)",
+         n_clips, stats->windows, stats->singles, stats->fallbacks, state_pool_size(pool));
+    for (int i = 0; i < n_clips; ++i) if (texts[i]) return true;
+    return false;
+}
@@ -0,0 +1,65 @@
+//
+// clip_pack.h — many short clips per encoder window
+//
+// Every whisper_full pays a full 30 s encoder pass, however short the audio.
+// For batches of short clips (voice commands) the clips are laid out in one
+// window, separated by silence, decoded once, and the text is split back to
+// the clips by token timestamps.
+//
+// Accuracy guard: if any text token falls into a silence gap (hallucination or
+// a word bleeding across a boundary) the pack is decoded clip by clip instead.
+// A clip that ends up with no text in a pack is also re-decoded on its own.
+//
+
+#ifndef CLIP_PACK_H
+#define CLIP_PACK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "state_pool.h"
+#include "whisper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CLIP_PACK_GAP_MS      1000   // silence between packed clips
+#define CLIP_PACK_WINDOW_MS   29000  // packed audio per window (keeps the tail off the 30 s edge)
+#define CLIP_PACK_TOLERANCE_MS 200   // token timestamps may stray this far past a clip edge
+
+struct clip_pack_stats {
+    int windows;      // whisper_full runs on packed windows
+    int singles;      // whisper_full runs on a single clip (unpackable, fallback or retry)
+    int fallbacks;    // packs rejected by the accuracy guard
+};
+
+// Plan packs for clips of the given lengths (16 kHz samples), in order. Writes
+// the first clip index of each pack to pack_start (room for n_clips entries)
+// and returns the number of packs. A clip too long to share a window gets a
+// pack of its own.
+int clip_pack_plan(const int *n_samples, int n_clips, int *pack_start);
+
+// Index (0..n-1) of the clip whose [start, end] (in 10 ms units, widened by the
+// tolerance) contains t, or -1 if t lies in a gap.
+int clip_pack_locate(const int64_t *start, const int64_t *end, int n, int64_t t);
+
+// Encoder positions (audio_ctx) that cover a clip of n_samples with some
+// margin, in steps of 64 and at least 256; 0 (the model's full context) if
+// that is no smaller. Fewer positions make the encoder pass proportionally
+// cheaper; the clip must then be shorter than the window the positions span.
+int clip_pack_audio_ctx(struct whisper_context *ctx, int n_samples);
+
+// Transcribe n_clips 16 kHz clips with the given base parameters. Packs run in
+// parallel on the pool's states, sharing params.n_threads. texts[i] receives a
+// malloc'd string (caller frees), or NULL if that clip failed. Returns false
+// only if no clip could be transcribed.
+bool transcribe_many(struct state_pool *pool, struct whisper_full_params params,
+                     const float *const *clips, const int *n_samples, int n_clips,
+                     char **texts, struct clip_pack_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CLIP_PACK_H
@@ -0,0 +1,211 @@
+//
+// command.c — phrase-restricted recognition (see command.h)
+//
+
+#include "command.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "clip_pack.h"
+#include "native_log.h"
+
+#define CMD_MAX_TOKENS   48      // tokens per phrase (longer phrases are skipped)
+#define CMD_MAX_TEXT     512
+#define CMD_LOGP_FLOOR   -30.0f  // a token whisper itself suppressed
+
+struct trie_node {
+    whisper_token token;
+    int child;      // first child, -1 = none
+    int sibling;    // next child of the same parent, -1 = none
+    int phrase;     // phrase ending here, -1 = none
+};
+
+struct command_set {
+    struct whisper_context *ctx;
+    struct trie_node *nodes;  // nodes[0] is the root
+    int n_nodes;
+    int cap;
+    int max_depth;
+};
+
+struct command_run {
+    const struct command_set *cs;
+    float logp[CMD_MAX_TOKENS + 1];  // chosen token's log-probability per position
+    int   n_tokens;                  // path length once EOT was chosen
+    int   phrase;
+};
+
+static int find_child(const struct command_set *cs, int node, whisper_token token) {
+    for (int c = cs->nodes[node].child; c >= 0; c = cs->nodes[c].sibling) {
+        if (cs->nodes[c].token == token) return c;
+    }
+    return -1;
+}
+
+static int add_node(struct command_set *cs, int parent, whisper_token token) {
+    if (cs->n_nodes == cs->cap) {
+        const int cap = cs->cap ? cs->cap * 2 : 64;
+        struct trie_node *nodes = realloc(cs->nodes, (size_t)cap * sizeof(*nodes));
+        if (!nodes) return -1;
+        cs->nodes = nodes;
+        cs->cap = cap;
+    }
+    const int i = cs->n_nodes++;
+    cs->nodes[i] = (struct trie_node){ token, -1, -1, -1 };
+    if (parent >= 0) {
+        cs->nodes[i].sibling = cs->nodes[parent].child;
+        cs->nodes[parent].child = i;
+    }
+    return i;
+}
+
+// Returns false on OOM; a phrase that cannot be tokenized is skipped.
+static bool insert(struct command_set *cs, const char *text, int phrase) {
+    whisper_token tokens[CMD_MAX_TOKENS];
+    const int n = whisper_tokenize(cs->ctx, text, tokens, CMD_MAX_TOKENS);
+    if (n <= 0) {
+        LOGW("command: can't tokenize \"%s\" (%d)", text, n);
+        return true;
+    }
+    int node = 0;
+    for (int i = 0; i < n; ++i) {
+        int next = find_child(cs, node, tokens[i]);
+        if (next < 0 && (next = add_node(cs, node, tokens[i])) < 0) return false;
+        node = next;
+    }
+    if (cs->nodes[node].phrase < 0) cs->nodes[node].phrase = phrase;
+    if (n > cs->max_depth) cs->max_depth = n;
+    return true;
+}
+
+struct command_set *command_set_create(struct whisper_context *ctx, const char *const *phrases, int n) {
+    if (!ctx || !phrases || n <= 0) return NULL;
+    struct command_set *cs = calloc(1, sizeof(*cs));
+    if (!cs) return NULL;
+    cs->ctx = ctx;
+    if (add_node(cs, -1, -1) < 0) goto fail;
+
+    for (int i = 0; i < n; ++i) {
+        const char *s = phrases[i];
+        while (s && isspace((unsigned char)*s)) s++;
+        if (!s || !*s || strlen(s) + 3 > CMD_MAX_TEXT) continue;
+
+        // Whisper writes the first word with a leading space, usually
+        // capitalized, and tends to close with a full stop: accept all of it.
+        char text[CMD_MAX_TEXT];
+        for (int variant = 0; variant < 4; ++variant) {
+            snprintf(text, sizeof(text), " %s%s", s, variant & 1 ? "." : "");
+            if (variant & 2) {
+                if (!islower((unsigned char)text[1])) continue;
+                text[1] = (char)toupper((unsigned char)text[1]);
+            }
+            if (!insert(cs, text, i)) goto fail;
+        }
+    }
+    if (cs->max_depth == 0) goto fail;
+    LOGI("command: %d phrases, %d trie nodes, longest %d tokens", n, cs->n_nodes - 1, cs->max_depth);
+    return cs;
+
+fail:
+    command_set_free(cs);
+    return NULL;
+}
+
+void command_set_free(struct command_set *cs) {
+    if (!cs) return;
+    free(cs->nodes);
+    free(cs);
+}
+
+// Leaves only the best continuation of the trie path the tokens so far took
+// (EOT where a phrase ends) and records its probability under the full model.
+static void on_logits(struct whisper_context *ctx, struct whisper_state *state,
+                      const whisper_token_data *tokens, int n_tokens, float *logits, void *user_data) {
+    (void)state;
+    struct command_run *r = (struct command_run *)user_data;
+    const struct command_set *cs = r->cs;
+    const whisper_token eot = whisper_token_eot(ctx);
+
+    int node = 0;
+    for (int i = 0; i < n_tokens && node >= 0; ++i) node = find_child(cs, node, tokens[i].id);
+
+    whisper_token best = eot;
+    float best_logit = -INFINITY;
+    if (node >= 0 && n_tokens <= CMD_MAX_TOKENS) {
+        for (int c = cs->nodes[node].child; c >= 0; c = cs->nodes[c].sibling) {
+            if (best_logit == -INFINITY || logits[cs->nodes[c].token] > best_logit) {
+                best = cs->nodes[c].token;
+                best_logit = logits[best];
+            }
+        }
+        if (cs->nodes[node].phrase >= 0 && logits[eot] > best_logit) {
+            best = eot;
+            best_logit = logits[eot];
+        }
+    }
+
+    // Log-probability among text tokens and EOT, before restriction.
+    float max = -INFINITY;
+    for (int i = 0; i <= eot; ++i) max = logits[i] > max ? logits[i] : max;
+    double sum = 0.0;
+    for (int i = 0; i <= eot; ++i) sum += exp((double)(logits[i] - max));
+    const float lp = best_logit - max - (float)log(sum);
+    if (n_tokens <= CMD_MAX_TOKENS) r->logp[n_tokens] = isfinite(lp) && lp > CMD_LOGP_FLOOR ? lp : CMD_LOGP_FLOOR;
+
+    if (best == eot) {
+        // Off the trie (whisper fed something else) is no match.
+        const bool matched = node >= 0 && cs->nodes[node].phrase >= 0 && n_tokens <= CMD_MAX_TOKENS;
+        r->n_tokens = matched ? n_tokens + 1 : 0;
+        r->phrase = matched ? cs->nodes[node].phrase : -1;
+    }
+
+    const int n_vocab = whisper_n_vocab(ctx);
+    for (int i = 0; i < n_vocab; ++i) {
+        if (i != best) logits[i] = -INFINITY;
+    }
+}
+
+bool command_recognize(struct command_set *cs, struct whisper_full_params params,
+                       const float *pcm, int n_samples, struct command_match *out) {
+    *out = (struct command_match){ -1, 0.0f, 0 };
+    const int max_samples = COMMAND_MAX_MS * (WHISPER_SAMPLE_RATE / 1000);
+    if (n_samples > max_samples) {
+        LOGW("command: %d ms of audio, using the first %d ms", n_samples / (WHISPER_SAMPLE_RATE / 1000),
+             COMMAND_MAX_MS);
+        n_samples = max_samples;
+    }
+
+    struct command_run run = { .cs = cs, .phrase = -1 };
+    params.translate = false;
+    params.no_context = true;
+    params.no_timestamps = true;
+    params.single_segment = true;
+    params.token_timestamps = false;
+    params.initial_prompt = NULL;
+    params.prompt_tokens = NULL;
+    params.prompt_n_tokens = 0;
+    params.max_tokens = 0;              // the trie ends every path
+    params.temperature_inc = 0.0f;      // a forced decode gains nothing from resampling
+    params.audio_ctx = clip_pack_audio_ctx(cs->ctx, n_samples);
+    params.logits_filter_callback = on_logits;
+    params.logits_filter_callback_user_data = &run;
+
+    if (whisper_full(cs->ctx, params, pcm, n_samples) != 0) {
+        LOGW("command: whisper_full failed");
+        return false;
+    }
+    if (run.n_tokens == 0) return true;  // no phrase completed
+
+    float sum = 0.0f;
+    for (int i = 0; i < run.n_tokens; ++i) sum += run.logp[i];
+    out->index = run.phrase;
+    out->tokens = run.n_tokens;
+    out->score = expf(sum / (float)run.n_tokens);
+    LOGI("command: phrase %d, score %.3f over %d tokens (audio_ctx %d)", out->index, out->score, out->tokens,
+         params.audio_ctx);
+    return true;
+}
@@ -0,0 +1,54 @@
+//
+// command.h — recognize one of a fixed set of phrases
+//
+// Voice commands need to know which of a few known phrases was said, not an
+// open-vocabulary transcript. The phrases are tokenized once into a token
+// trie; a recognition run is a whisper_full whose logits filter allows only
+// the tokens that continue a phrase (or EOT where one ends), with no
+// timestamps, one segment and an audio_ctx shrunk to the clip. The decode is
+// a handful of decoder calls over a fraction of the encoder work.
+//
+// The score is the geometric mean of the path's token probabilities under the
+// unrestricted model (text tokens and EOT), so audio that matches no phrase
+// scores low even though the decode always ends on some phrase.
+//
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stdbool.h>
+
+#include "whisper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COMMAND_MAX_MS 10000  // audio beyond this is ignored
+
+struct command_set;
+
+struct command_match {
+    int   index;     // phrase index, -1 if the run failed
+    float score;     // 0..1
+    int   tokens;    // tokens decoded (EOT included)
+};
+
+// Tokenize phrases with ctx's vocabulary into a trie. Phrases are matched as
+// spoken after a pause (leading space, as whisper writes the first word);
+// duplicates keep the first index. NULL if no phrase could be tokenized.
+struct command_set *command_set_create(struct whisper_context *ctx, const char *const *phrases, int n);
+
+void command_set_free(struct command_set *cs);
+
+// Recognize the phrase in pcm (16 kHz) with the given base params (language,
+// threads); the run overrides everything that shapes the decode. Runs on the
+// context's default state. Returns false if whisper_full failed.
+bool command_recognize(struct command_set *cs, struct whisper_full_params params,
+                       const float *pcm, int n_samples, struct command_match *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COMMAND_H
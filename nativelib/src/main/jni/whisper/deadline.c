@@ -0,0 +1,220 @@
+//
+// deadline.c — latency-budgeted whisper_full runs (see deadline.h)
+//
+
+#include "deadline.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "clip_pack.h"
+#include "loop_guard.h"
+#include "native_log.h"
+#include "timings.h"
+
+#define DL_MAX_CONTEXTS      8
+#define DL_EMA               0.3f   // weight of a new observation
+#define DL_TOKENS_PER_SEC    4.0f   // until measured
+#define DL_MIN_TOKENS        16     // never cap segments below this
+#define DL_WINDOW_SAMPLES    (WHISPER_SAMPLE_RATE * 30)
+
+struct cost_model {
+    const struct whisper_context *ctx;
+    float enc_full_ms;   // encoder pass at the full audio context, 0 = not measured
+    float dec_ms;        // one decoder call (one token)
+    float tokens_per_s;  // text tokens per second of audio
+    bool  has_report;
+    struct deadline_report report;
+};
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct cost_model g_models[DL_MAX_CONTEXTS];
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+// Lock held. The context's entry; with create, a free slot (or the first one).
+static struct cost_model *find(const struct whisper_context *ctx, bool create) {
+    struct cost_model *free_slot = NULL;
+    for (int i = 0; i < DL_MAX_CONTEXTS; ++i) {
+        if (g_models[i].ctx == ctx) return &g_models[i];
+        if (!g_models[i].ctx && !free_slot) free_slot = &g_models[i];
+    }
+    if (!create) return NULL;
+    struct cost_model *m = free_slot ? free_slot : &g_models[0];
+    memset(m, 0, sizeof(*m));
+    m->ctx = ctx;
+    m->tokens_per_s = DL_TOKENS_PER_SEC;
+    return m;
+}
+
+static float ema(float old, float sample) {
+    return old > 0.0f ? old + DL_EMA * (sample - old) : sample;
+}
+
+void deadline_observe(struct whisper_context *ctx, int n_samples, int audio_ctx, bool truncated) {
+    if (!ctx || n_samples <= 0) return;
+    struct whisper_timings t;
+    if (!whisper_timings_read(ctx, &t)) return;
+    const float enc_ms = t.encode_ms, dec_ms = t.decode_ms;
+
+    const int full = whisper_n_audio_ctx(ctx);
+    const whisper_token eot = whisper_token_eot(ctx);
+    int tokens = 0;
+    for (int s = 0; s < whisper_full_n_segments(ctx); ++s) {
+        for (int i = 0; i < whisper_full_n_tokens(ctx, s); ++i) {
+            if (whisper_full_get_token_id(ctx, s, i) < eot) tokens++;
+        }
+    }
+
+    pthread_mutex_lock(&g_lock);
+    struct cost_model *m = find(ctx, true);
+    if (enc_ms > 0.0f) {
+        m->enc_full_ms = ema(m->enc_full_ms, enc_ms * (float)full / (float)(audio_ctx > 0 ? audio_ctx : full));
+    }
+    if (dec_ms > 0.0f) m->dec_ms = ema(m->dec_ms, dec_ms);
+    // A cut run says nothing about how much there was to say.
+    if (!truncated && n_samples >= WHISPER_SAMPLE_RATE) {
+        m->tokens_per_s = ema(m->tokens_per_s, (float)tokens * WHISPER_SAMPLE_RATE / (float)n_samples);
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+static bool on_encoder_begin(struct whisper_context *ctx, struct whisper_state *state, void *user_data) {
+    struct deadline_run *r = (struct deadline_run *)user_data;
+    const double now = now_ms();
+    // The first window always runs; later ones only if their encoder pass fits.
+    if (r->windows_started > 0 && now + r->enc_est_ms > r->deadline_ms) {
+        if (!r->truncated) LOGI("deadline: no time for window %d, stopping", r->windows_started + 1);
+        r->truncated = true;
+        return false;
+    }
+    r->windows_started++;
+    const int left = r->windows_est - r->windows_started + 1;
+    r->window_end_ms = now + (r->deadline_ms - now) / (left > 1 ? left : 1);
+
+    return r->prev_encoder_begin ? r->prev_encoder_begin(ctx, state, r->prev_encoder_begin_data) : true;
+}
+
+static void on_logits(struct whisper_context *ctx, struct whisper_state *state,
+                      const whisper_token_data *tokens, int n_tokens, float *logits, void *user_data) {
+    struct deadline_run *r = (struct deadline_run *)user_data;
+    if (r->prev_filter) r->prev_filter(ctx, state, tokens, n_tokens, logits, r->prev_filter_data);
+
+    if (n_tokens > 0 && now_ms() >= r->window_end_ms) {
+        if (loop_guard_close_window(ctx, tokens, n_tokens, logits) && !r->truncated) {
+            LOGI("deadline: window %d out of time after %d tokens", r->windows_started, n_tokens);
+        }
+        r->truncated = true;
+    }
+}
+
+static bool on_abort(void *user_data) {
+    struct deadline_run *r = (struct deadline_run *)user_data;
+    if (r->prev_abort && r->prev_abort(r->prev_abort_data)) return true;
+    if (now_ms() < r->hard_ms) return false;
+    r->truncated = true;
+    return true;
+}
+
+void deadline_begin(struct deadline_run *r, struct whisper_context *ctx, struct whisper_full_params *p,
+                    int n_samples, int budget_ms) {
+    memset(r, 0, sizeof(*r));
+    r->ctx = ctx;
+    r->start_ms = now_ms();
+    r->deadline_ms = r->start_ms + budget_ms;
+    r->hard_ms = r->deadline_ms + fmax(200.0, budget_ms * 0.25);
+    r->windows_est = (n_samples + DL_WINDOW_SAMPLES - 1) / DL_WINDOW_SAMPLES;
+    if (r->windows_est < 1) r->windows_est = 1;
+
+    // A fallback re-decodes the whole window at a higher temperature: the
+    // single largest source of latency spikes.
+    p->temperature_inc = 0.0f;
+
+    pthread_mutex_lock(&g_lock);
+    const struct cost_model *found = find(ctx, false);
+    const struct cost_model m = found ? *found : (struct cost_model){ 0 };
+    pthread_mutex_unlock(&g_lock);
+
+    const int full = whisper_n_audio_ctx(ctx);
+    int audio_ctx = full;
+    if (m.enc_full_ms > 0.0f && m.dec_ms > 0.0f) {
+        const float per_window = (float)budget_ms / (float)r->windows_est;
+        const float window_s = fminf(30.0f, (float)n_samples / WHISPER_SAMPLE_RATE);
+        float tokens = fminf((float)whisper_n_text_ctx(ctx) / 2, m.tokens_per_s * window_s * 1.25f + 8.0f);
+        float enc = m.enc_full_ms;
+
+        // A clip shorter than a window does not need the encoder to attend
+        // over the padding.
+        if (enc + tokens * m.dec_ms > per_window && r->windows_est == 1) {
+            const int clip_ctx = clip_pack_audio_ctx(ctx, n_samples);
+            if (clip_ctx > 0) {
+                audio_ctx = clip_ctx;
+                enc = m.enc_full_ms * (float)clip_ctx / (float)full;
+            }
+        }
+        if (enc + tokens * m.dec_ms > per_window) {
+            const int cap = (int)((per_window - enc) / m.dec_ms);
+            r->max_tokens = cap > DL_MIN_TOKENS ? cap : DL_MIN_TOKENS;
+        }
+        r->enc_est_ms = enc;
+        LOGI("deadline: %d ms for %d window(s): enc %.0f ms, %.1f ms/token, ~%.0f tokens/window",
+             budget_ms, r->windows_est, enc, m.dec_ms, tokens);
+    }
+    r->audio_ctx = audio_ctx < full ? audio_ctx : 0;
+    p->audio_ctx = r->audio_ctx;
+    p->max_tokens = r->max_tokens;
+    LOGI("deadline: plan audio_ctx=%d max_tokens=%d", r->audio_ctx, r->max_tokens);
+
+    r->prev_encoder_begin = p->encoder_begin_callback;
+    r->prev_encoder_begin_data = p->encoder_begin_callback_user_data;
+    r->prev_filter = p->logits_filter_callback;
+    r->prev_filter_data = p->logits_filter_callback_user_data;
+    r->prev_abort = p->abort_callback;
+    r->prev_abort_data = p->abort_callback_user_data;
+    p->encoder_begin_callback = on_encoder_begin;
+    p->encoder_begin_callback_user_data = r;
+    p->logits_filter_callback = on_logits;
+    p->logits_filter_callback_user_data = r;
+    p->abort_callback = on_abort;
+    p->abort_callback_user_data = r;
+}
+
+void deadline_end(struct deadline_run *r) {
+    const struct deadline_report rep = {
+        .budget_ms  = (float)(r->deadline_ms - r->start_ms),
+        .elapsed_ms = (float)(now_ms() - r->start_ms),
+        .audio_ctx  = r->audio_ctx,
+        .max_tokens = r->max_tokens,
+        .truncated  = r->truncated,
+    };
+    LOGI("deadline: %.0f / %.0f ms%s", rep.elapsed_ms, rep.budget_ms, rep.truncated ? " (partial result)" : "");
+
+    pthread_mutex_lock(&g_lock);
+    struct cost_model *m = find(r->ctx, true);
+    m->report = rep;
+    m->has_report = true;
+    pthread_mutex_unlock(&g_lock);
+}
+
+bool deadline_last_report(const struct whisper_context *ctx, struct deadline_report *out) {
+    pthread_mutex_lock(&g_lock);
+    const struct cost_model *m = find(ctx, false);
+    const bool ok = m && m->has_report;
+    if (ok && out) *out = m->report;
+    pthread_mutex_unlock(&g_lock);
+    return ok;
+}
+
+void deadline_forget(const struct whisper_context *ctx) {
+    pthread_mutex_lock(&g_lock);
+    struct cost_model *m = find(ctx, false);
+    if (m) memset(m, 0, sizeof(*m));
+    pthread_mutex_unlock(&g_lock);
+}
@@ -0,0 +1,80 @@
+//
+// deadline.h — fit a whisper_full run into a latency budget
+//
+// Every run feeds a per-context cost model: encoder time per window (scaled
+// to the full audio context), decoder time per token and tokens per second of
+// audio. A run with a budget is planned from that model before it starts:
+//   - temperature fallback is off (a fallback re-decodes the whole window);
+//   - if the estimate does not fit, a short clip gets a smaller audio_ctx;
+//   - if it still does not fit, tokens per segment are capped.
+// While it runs the plan is enforced: each window gets its share of the time
+// left and is closed when that is used up, no new window starts once its
+// encoder pass cannot finish in time, and a run that overshoots anyway is
+// aborted. Segments finished by then are the (partial) result.
+//
+
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <stdbool.h>
+
+#include "whisper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// What the last budgeted run of a context did.
+struct deadline_report {
+    float budget_ms;
+    float elapsed_ms;
+    int   audio_ctx;    // 0 = the model's full context
+    int   max_tokens;   // tokens per segment, 0 = uncapped
+    bool  truncated;    // time ran out: windows were cut or skipped
+};
+
+struct deadline_run {
+    struct whisper_context *ctx;
+    double start_ms;
+    double deadline_ms;       // absolute, CLOCK_MONOTONIC
+    double hard_ms;           // abort past this
+    double window_end_ms;     // the current window's share ends here
+    float  enc_est_ms;        // encoder pass at the planned audio_ctx (0 = unknown)
+    int    windows_est;
+    int    windows_started;
+    int    audio_ctx;
+    int    max_tokens;
+    bool   truncated;
+    whisper_encoder_begin_callback prev_encoder_begin;
+    void  *prev_encoder_begin_data;
+    whisper_logits_filter_callback prev_filter;
+    void  *prev_filter_data;
+    ggml_abort_callback prev_abort;
+    void  *prev_abort_data;
+};
+
+// Plan a run of n_samples (16 kHz) within budget_ms and hook the enforcement
+// into p (chaining p's existing encoder-begin, logits and abort callbacks, so
+// a caller's own abort keeps working under a deadline). r must stay alive
+// until deadline_end.
+void deadline_begin(struct deadline_run *r, struct whisper_context *ctx, struct whisper_full_params *p,
+                    int n_samples, int budget_ms);
+
+// After whisper_full (whatever it returned): store the report.
+void deadline_end(struct deadline_run *r);
+
+// Update the cost model from the timings of a finished run of n_samples at
+// audio_ctx (0 = full). Call after every run, budgeted or not.
+void deadline_observe(struct whisper_context *ctx, int n_samples, int audio_ctx, bool truncated);
+
+// Report of the context's last budgeted run; false if there was none.
+bool deadline_last_report(const struct whisper_context *ctx, struct deadline_report *out);
+
+// Drop the context's model and report (the context is being freed).
+void deadline_forget(const struct whisper_context *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DEADLINE_H
@@ -0,0 +1,85 @@
+//
+// decoder.c — greedy decoder over an existing encoder output (see decoder.h)
+//
+
+#include "decoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "loop_guard.h"
+#include "native_log.h"
+
+int greedy_decode(struct whisper_context *ctx, int lang_id, bool translate, int n_threads,
+                  whisper_token *out, int max_tokens) {
+    if (!ctx || !out || max_tokens <= 0 || lang_id < 0) return -1;
+
+    const whisper_token eot = whisper_token_eot(ctx);
+    const int n_vocab = whisper_n_vocab(ctx);
+
+    whisper_token prompt[4] = {
+        whisper_token_sot(ctx),
+        whisper_token_lang(ctx, lang_id),
+        translate ? whisper_token_translate(ctx) : whisper_token_transcribe(ctx),
+        whisper_token_not(ctx),
+    };
+    const whisper_token *feed = prompt;
+    int n_feed = 4;
+    int n_past = 0;
+    int n_out = 0;
+
+    // Prompt plus generated tokens must fit the text context.
+    const int limit = whisper_n_text_ctx(ctx) - n_feed;
+    if (max_tokens > limit) max_tokens = limit;
+
+    while (n_out < max_tokens) {
+        if (whisper_decode(ctx, feed, n_feed, n_past, n_threads) != 0) {
+            LOGW("greedy_decode: whisper_decode failed at token %d", n_out);
+            return -1;
+        }
+        n_past += n_feed;
+
+        // Logits of the last fed token. Only text tokens and EOT are eligible:
+        // everything above EOT is a special or timestamp token.
+        const float *logits = whisper_get_logits(ctx) + (size_t)(n_feed - 1) * n_vocab;
+        whisper_token best = 0;
+        for (whisper_token id = 1; id <= eot; ++id) {
+            if (id == eot && n_out == 0) continue;  // no blank output
+            if (logits[id] > logits[best]) best = id;
+        }
+        if (best == eot) break;
+
+        out[n_out] = best;
+        feed = &out[n_out];
+        n_feed = 1;
+        ++n_out;
+
+        // A repetition loop would only run on until the token limit: cut it to
+        // one occurrence and stop.
+        int keep = n_out;
+        const enum loop_kind loop = loop_guard_check(out, n_out, eot, whisper_token_beg(ctx), &keep);
+        if (loop != LOOP_NONE) {
+            loop_guard_count(loop);
+            n_out = keep;
+            break;
+        }
+    }
+    return n_out;
+}
+
+char *decoder_tokens_to_text(struct whisper_context *ctx, const whisper_token *tokens, int n) {
+    size_t len = 0;
+    for (int i = 0; i < n; ++i) len += strlen(whisper_token_to_str(ctx, tokens[i]));
+
+    char *text = (char *)malloc(len + 1);
+    if (!text) return NULL;
+    char *p = text;
+    for (int i = 0; i < n; ++i) {
+        const char *s = whisper_token_to_str(ctx, tokens[i]);
+        const size_t l = strlen(s);
+        memcpy(p, s, l);
+        p += l;
+    }
+    *p = '\0';
+    return text;
+}
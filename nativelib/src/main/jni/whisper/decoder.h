@@ -0,0 +1,38 @@
+//
+// decoder.h — small greedy decoder over an existing encoder output
+//
+// whisper_full always encodes before it decodes. These helpers decode a window
+// whose encoder output is already held by the context's default state (after
+// whisper_encode, or after a whisper_full that encoded a single window), so a
+// second decoder pass — another task or language — costs no encoder time.
+//
+// Output is plain text tokens without timestamps. A repetition loop (see
+// loop_guard.h) ends the decode, with the repeats cut. Call from the thread
+// that owns the context.
+//
+
+#ifndef DECODER_H
+#define DECODER_H
+
+#include <stdbool.h>
+
+#include "whisper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Decode with prompt [SOT, language, transcribe|translate, no-timestamps].
+// Writes up to max_tokens text tokens to out and returns their number, or -1
+// if the decoder failed.
+int greedy_decode(struct whisper_context *ctx, int lang_id, bool translate, int n_threads,
+                  whisper_token *out, int max_tokens);
+
+// Concatenated text of tokens (malloc'd, caller frees); NULL on allocation failure.
+char *decoder_tokens_to_text(struct whisper_context *ctx, const whisper_token *tokens, int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DECODER_H
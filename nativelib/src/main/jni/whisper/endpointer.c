@@ -0,0 +1,150 @@
+//
+// endpointer.c — energy/noise-floor endpointer (see endpointer.h)
+//
+
+#include "endpointer.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#define EP_FRAME_MS        10
+#define EP_MIN_ENERGY_DB   30.0f   // absolute floor (int16 scale); below is always silence
+#define EP_FLOOR_RISE      0.02f   // noise floor adapts slowly upwards...
+#define EP_FLOOR_INIT_DB   40.0f   // quiet room; the floor starts here
+#define EP_CALIB_FRAMES    50      // floor is re-checked against the quietest of these
+
+struct endpointer {
+    struct endpoint_config cfg;
+    size_t   frame_len;        // samples per frame
+    size_t   frame_fill;
+    double   frame_sum_sq;
+
+    float    floor_db;
+    float    calib_min_db;     // quietest frame of the first EP_CALIB_FRAMES
+    int      calib_frames;
+    int      speech_ms;        // speech heard in the current candidate utterance
+    int      silence_ms;       // current run of silence
+    int      utterance_ms;     // time since the first speech frame
+    bool     started;          // any speech frame seen
+    bool     in_speech;        // min_speech_ms reached
+    bool     fired;
+
+    uint64_t samples_seen;
+    uint64_t speech_end;
+};
+
+void endpoint_config_default(struct endpoint_config *cfg) {
+    cfg->trailing_silence_ms = 800;
+    cfg->min_speech_ms       = 300;
+    cfg->max_utterance_ms    = 0;
+    cfg->threshold_db        = 12.0f;
+}
+
+struct endpointer *endpointer_create(const struct endpoint_config *cfg, int sample_rate) {
+    if (!cfg || sample_rate <= 0) return NULL;
+    struct endpointer *ep = (struct endpointer *)calloc(1, sizeof(*ep));
+    if (!ep) return NULL;
+    ep->cfg = *cfg;
+    ep->frame_len = (size_t)sample_rate * EP_FRAME_MS / 1000;
+    if (ep->frame_len == 0) ep->frame_len = 1;
+    endpointer_reset(ep);
+    return ep;
+}
+
+void endpointer_free(struct endpointer *ep) {
+    free(ep);
+}
+
+void endpointer_rearm(struct endpointer *ep) {
+    if (!ep) return;
+    ep->frame_fill = 0;
+    ep->frame_sum_sq = 0.0;
+    ep->speech_ms = ep->silence_ms = ep->utterance_ms = 0;
+    ep->started = ep->in_speech = ep->fired = false;
+    ep->samples_seen = 0;
+    ep->speech_end = 0;
+}
+
+void endpointer_reset(struct endpointer *ep) {
+    if (!ep) return;
+    endpointer_rearm(ep);
+    ep->floor_db = EP_FLOOR_INIT_DB;
+    ep->calib_min_db = INFINITY;
+    ep->calib_frames = 0;
+}
+
+// One complete frame; returns true when the endpoint fires.
+static bool process_frame(struct endpointer *ep, float energy_db) {
+    // The floor starts at a quiet-room level, so speech from the first frame on is not
+    // taken for noise. If even the quietest of the first frames is louder than that, the
+    // room is noisy: raise the floor to it and re-judge from there.
+    if (ep->calib_frames < EP_CALIB_FRAMES) {
+        if (energy_db < ep->calib_min_db) ep->calib_min_db = energy_db;
+        if (++ep->calib_frames == EP_CALIB_FRAMES && ep->calib_min_db > ep->floor_db) {
+            ep->floor_db = ep->calib_min_db;
+            ep->started = ep->in_speech = false;
+            ep->speech_ms = ep->utterance_ms = ep->silence_ms = 0;
+        }
+    }
+
+    const bool speech = energy_db > EP_MIN_ENERGY_DB && energy_db > ep->floor_db + ep->cfg.threshold_db;
+
+    if (!speech) {
+        // Track the floor down immediately, up slowly (ignores speech tails).
+        if (energy_db < ep->floor_db) ep->floor_db = energy_db;
+        else ep->floor_db += (energy_db - ep->floor_db) * EP_FLOOR_RISE;
+    }
+
+    if (ep->started) ep->utterance_ms += EP_FRAME_MS;
+
+    if (speech) {
+        ep->started = true;
+        ep->speech_ms += EP_FRAME_MS;
+        ep->silence_ms = 0;
+        if (ep->speech_ms >= ep->cfg.min_speech_ms) ep->in_speech = true;
+    } else if (ep->started) {
+        if (ep->silence_ms == 0) ep->speech_end = ep->samples_seen;
+        ep->silence_ms += EP_FRAME_MS;
+        if (!ep->in_speech && ep->silence_ms >= ep->cfg.trailing_silence_ms) {
+            // A click or cough, not an utterance: start over.
+            ep->started = false;
+            ep->speech_ms = ep->utterance_ms = ep->silence_ms = 0;
+        }
+    }
+
+    if (ep->in_speech && ep->silence_ms >= ep->cfg.trailing_silence_ms) return true;
+    if (ep->in_speech && ep->cfg.max_utterance_ms > 0 && ep->utterance_ms >= ep->cfg.max_utterance_ms) {
+        if (ep->silence_ms == 0) ep->speech_end = ep->samples_seen;
+        return true;
+    }
+    return false;
+}
+
+bool endpointer_feed(struct endpointer *ep, const int16_t *samples, size_t n) {
+    if (!ep || ep->fired) return false;
+    for (size_t i = 0; i < n; i++) {
+        const double s = samples[i];
+        ep->frame_sum_sq += s * s;
+        if (++ep->frame_fill < ep->frame_len) continue;
+
+        const double mean_sq = ep->frame_sum_sq / (double)ep->frame_len;
+        const float energy_db = (float)(10.0 * log10(mean_sq + 1.0));
+        ep->samples_seen += ep->frame_len;
+        ep->frame_fill = 0;
+        ep->frame_sum_sq = 0.0;
+
+        if (process_frame(ep, energy_db)) {
+            ep->fired = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool endpointer_in_speech(const struct endpointer *ep) {
+    return ep && ep->in_speech;
+}
+
+uint64_t endpointer_speech_end(const struct endpointer *ep) {
+    return ep ? ep->speech_end : 0;
+}
@@ -0,0 +1,51 @@
+//
+// endpointer.h — end-of-utterance detection on the live capture stream
+//
+// Energy-based: 10 ms frames are compared with an adaptive noise floor. An
+// endpoint fires once at least min_speech_ms of speech has been heard and is
+// followed by trailing_silence_ms of silence (or when the utterance reaches
+// max_utterance_ms). Cheap enough to run on the capture drain thread for
+// every sample.
+//
+
+#ifndef ENDPOINTER_H
+#define ENDPOINTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct endpoint_config {
+    int   trailing_silence_ms;  // silence after speech that ends the utterance
+    int   min_speech_ms;        // speech required before an endpoint may fire
+    int   max_utterance_ms;     // force an endpoint this long after speech starts (0 = off)
+    float threshold_db;         // frame counts as speech this far above the noise floor
+};
+
+struct endpointer;
+
+void endpoint_config_default(struct endpoint_config *cfg);
+
+struct endpointer *endpointer_create(const struct endpoint_config *cfg, int sample_rate);
+void endpointer_free(struct endpointer *ep);
+void endpointer_reset(struct endpointer *ep);
+// Start on the next utterance of the same stream: like reset, but the noise
+// floor learned so far is kept. Sample positions restart at 0.
+void endpointer_rearm(struct endpointer *ep);
+
+// Feed captured samples. Returns true exactly once, when the endpoint is reached.
+bool endpointer_feed(struct endpointer *ep, const int16_t *samples, size_t n);
+
+bool endpointer_in_speech(const struct endpointer *ep);
+// Sample index (since create/reset) where trailing silence began; valid after the endpoint.
+uint64_t endpointer_speech_end(const struct endpointer *ep);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ENDPOINTER_H
@@ -0,0 +1,253 @@
+//
+// hugepages.c — huge pages and mlock for new anonymous mappings (see hugepages.h)
+//
+
+#include "hugepages.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "native_log.h"
+
+#ifndef MADV_HUGEPAGE
+#define MADV_HUGEPAGE 14
+#endif
+#ifndef MADV_COLLAPSE
+#define MADV_COLLAPSE 25
+#endif
+
+#define HUGE_PAGE      ((uintptr_t)2 * 1024 * 1024)
+#define MIN_REGION     ((uintptr_t)1024 * 1024)
+
+struct region {
+    uintptr_t start;
+    uintptr_t end;
+};
+
+struct mem_snapshot {
+    struct region *r;
+    int            n;
+};
+
+// Ranges locked for one owner, released with it.
+struct lock_set {
+    const void      *owner;
+    struct region   *r;
+    int              n;
+    struct lock_set *next;
+};
+
+static pthread_mutex_t  g_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct lock_set *g_locked;
+
+// Writable private anonymous mappings malloc can hand ggml: no file, the heap,
+// or the regions the native allocators name ("[anon:scudo:*]",
+// "[anon:libc_malloc]"). Other named regions ("[anon:dalvik-*]" of the Java
+// heap, thread stacks) are never ggml's.
+static bool is_anon(const char *perms, unsigned long inode, const char *path) {
+    if (perms[0] != 'r' || perms[1] != 'w' || perms[3] != 'p' || inode != 0) return false;
+    return path[0] == '\0' || !strcmp(path, "[heap]") || !strncmp(path, "[anon:scudo:", 12) ||
+           !strcmp(path, "[anon:libc_malloc]");
+}
+
+struct mem_snapshot *mem_snapshot_take(void) {
+    FILE *f = fopen("/proc/self/maps", "r");
+    if (!f) return NULL;
+    struct mem_snapshot *s = calloc(1, sizeof(*s));
+    int cap = 0;
+    char line[512];
+    while (s && fgets(line, sizeof(line), f)) {
+        unsigned long start, end, inode;
+        char perms[8] = "", path[256] = "";
+        if (sscanf(line, "%lx-%lx %7s %*s %*s %lu %255[^\n]", &start, &end, perms, &inode, path) < 4) continue;
+        if (!is_anon(perms, inode, path)) continue;
+        if (s->n == cap) {
+            cap = cap ? cap * 2 : 256;
+            struct region *grown = realloc(s->r, (size_t)cap * sizeof(*grown));
+            if (!grown) {
+                mem_snapshot_free(s);
+                s = NULL;
+                break;
+            }
+            s->r = grown;
+        }
+        s->r[s->n].start = start;
+        s->r[s->n].end = end;
+        s->n++;
+    }
+    fclose(f);
+    return s;
+}
+
+void mem_snapshot_free(struct mem_snapshot *s) {
+    if (!s) return;
+    free(s->r);
+    free(s);
+}
+
+// Wholly new: overlaps and touches nothing of before. A region sharing a
+// boundary with an old one may be that one grown, or merged into by the kernel.
+static bool is_new(const struct mem_snapshot *before, const struct region *r) {
+    for (int i = 0; i < before->n; ++i) {
+        if (r->start <= before->r[i].end && before->r[i].start <= r->end) return false;
+    }
+    return true;
+}
+
+static enum thp_mode thp_mode(void) {
+    FILE *f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (!f) return THP_UNAVAILABLE;
+    char buf[128] = "";
+    if (!fgets(buf, sizeof(buf), f)) buf[0] = '\0';
+    fclose(f);
+    if (strstr(buf, "[always]")) return THP_ALWAYS;
+    if (strstr(buf, "[madvise]")) return THP_MADVISE;
+    return THP_UNAVAILABLE;
+}
+
+// Sum AnonHugePages of the smaps entries that are among the new regions.
+static int64_t huge_bytes(const struct mem_snapshot *now, const bool *fresh) {
+    FILE *f = fopen("/proc/self/smaps", "r");
+    if (!f) return 0;
+    int64_t total = 0;
+    bool counting = false;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long start, end, kb;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            counting = false;
+            for (int i = 0; i < now->n; ++i) {
+                if (fresh[i] && now->r[i].start == start && now->r[i].end == end) {
+                    counting = true;
+                    break;
+                }
+            }
+        } else if (counting && sscanf(line, "AnonHugePages: %lu kB", &kb) == 1) {
+            total += (int64_t)kb * 1024;
+        }
+    }
+    fclose(f);
+    return total;
+}
+
+static void record_locks(const void *owner, const struct region *r, int n) {
+    struct lock_set *set = calloc(1, sizeof(*set));
+    struct region *copy = malloc((size_t)n * sizeof(*copy));
+    if (!set || !copy) {
+        // Can't keep them, so don't leave them locked.
+        for (int i = 0; i < n; ++i) munlock((void *)r[i].start, r[i].end - r[i].start);
+        LOGW("hugepages: out of memory, %d regions unlocked again", n);
+        free(set);
+        free(copy);
+        return;
+    }
+    memcpy(copy, r, (size_t)n * sizeof(*copy));
+    set->owner = owner;
+    set->r = copy;
+    set->n = n;
+    pthread_mutex_lock(&g_lock);
+    set->next = g_locked;
+    g_locked = set;
+    pthread_mutex_unlock(&g_lock);
+}
+
+// Still mapped exactly as recorded. A range freed since may have been reused
+// by another allocation (another context's, say), which must not be unlocked.
+static bool still_mapped(const struct mem_snapshot *now, const struct region *r) {
+    for (int i = 0; i < now->n; ++i) {
+        if (now->r[i].start == r->start && now->r[i].end == r->end) return true;
+    }
+    return false;
+}
+
+void hugepages_release(const void *owner) {
+    struct mem_snapshot *now = mem_snapshot_take();
+    if (!now) LOGW("hugepages: can't read the mappings, leaving ranges locked");
+    int skipped = 0;
+    pthread_mutex_lock(&g_lock);
+    struct lock_set **link = &g_locked;
+    while (*link) {
+        struct lock_set *set = *link;
+        if (set->owner != owner) {
+            link = &set->next;
+            continue;
+        }
+        *link = set->next;
+        for (int i = 0; now && i < set->n; ++i) {
+            if (still_mapped(now, &set->r[i])) {
+                munlock((void *)set->r[i].start, set->r[i].end - set->r[i].start);
+            } else {
+                skipped++;
+            }
+        }
+        free(set->r);
+        free(set);
+    }
+    pthread_mutex_unlock(&g_lock);
+    mem_snapshot_free(now);
+    if (skipped > 0) LOGI("hugepages: %d locked ranges changed since, left alone", skipped);
+}
+
+bool hugepages_apply(const struct mem_snapshot *before, const void *owner, bool huge, bool lock,
+                     struct hugepage_report *out) {
+    memset(out, 0, sizeof(*out));
+    out->thp = thp_mode();
+    struct mem_snapshot *now = mem_snapshot_take();
+    if (!before || !now) {
+        mem_snapshot_free(now);
+        return false;
+    }
+    bool *fresh = calloc((size_t)(now->n > 0 ? now->n : 1), sizeof(bool));
+    struct region *locked = malloc((size_t)(now->n > 0 ? now->n : 1) * sizeof(*locked));
+    int n_locked = 0;
+    if (!fresh || !locked) {
+        free(fresh);
+        free(locked);
+        mem_snapshot_free(now);
+        return false;
+    }
+
+    bool warned_lock = false;
+    for (int i = 0; i < now->n; ++i) {
+        const struct region *r = &now->r[i];
+        if (r->end - r->start < MIN_REGION || !is_new(before, r)) continue;
+        fresh[i] = true;
+        out->regions++;
+        out->bytes += (int64_t)(r->end - r->start);
+
+        if (huge && out->thp != THP_UNAVAILABLE) {
+            const uintptr_t a = (r->start + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+            const uintptr_t b = r->end & ~(HUGE_PAGE - 1);
+            if (b > a) {
+                madvise((void *)a, b - a, MADV_HUGEPAGE);
+                // Already populated: collapse now rather than wait for khugepaged.
+                if (madvise((void *)a, b - a, MADV_COLLAPSE) != 0 && errno != EINVAL) {
+                    LOGW("hugepages: MADV_COLLAPSE failed (errno %d)", errno);
+                }
+            }
+        }
+        if (lock) {
+            if (mlock((void *)r->start, r->end - r->start) == 0) {
+                out->locked_bytes += (int64_t)(r->end - r->start);
+                locked[n_locked++] = *r;
+            } else if (!warned_lock) {
+                LOGW("hugepages: mlock failed (errno %d, RLIMIT_MEMLOCK?)", errno);
+                warned_lock = true;
+            }
+        }
+    }
+    out->huge_bytes = huge_bytes(now, fresh);
+    if (n_locked > 0) record_locks(owner, locked, n_locked);
+
+    LOGI("hugepages: %d regions, %lld MB, %lld MB huge (THP %d), %lld MB locked", out->regions,
+         (long long)(out->bytes >> 20), (long long)(out->huge_bytes >> 20), (int)out->thp,
+         (long long)(out->locked_bytes >> 20));
+    free(locked);
+    free(fresh);
+    mem_snapshot_free(now);
+    return true;
+}
@@ -0,0 +1,71 @@
+//
+// hugepages.h — transparent huge pages and mlock for a context's memory
+//
+// Hundreds of MB of weights in 4 KB pages keep the TLB thrashing through
+// every encoder matmul, and pages still to be faulted in add jitter to the
+// first pass. ggml allocates the weights and the compute buffers itself, so
+// instead of allocating them we find them: the anonymous mappings that
+// appeared while the context was created (a /proc/self/maps snapshot before,
+// compared after) are advised MADV_HUGEPAGE, collapsed right away where the
+// kernel supports MADV_COLLAPSE (6.1+; otherwise khugepaged gets to them over
+// time) and optionally mlock'ed. The report says how much of them actually
+// sits in huge pages (AnonHugePages in /proc/self/smaps).
+//
+// Only mappings ggml can have made count: malloc-backed (unnamed, [heap],
+// scudo or libc_malloc; never the Java heap's [anon:dalvik-*]), at least
+// 1 MB, and wholly new: a region that overlaps or touches one of the
+// snapshot was grown or merged by the kernel and is left alone. A large
+// malloc of another thread during the load (a PCM copy of a transcription,
+// say) still qualifies: it is advised and locked too, and the report counts
+// it, so the report can include regions that are not the context's. Loads
+// should not overlap other heavy allocation. The ranges locked are kept per
+// owner and unlocked by hugepages_release(), before the context is freed:
+// ranges ggml frees are unmapped (and so unlocked) anyway, the rest is not
+// left locked behind it. A recorded range may have been freed and reused by
+// then, so only ranges still mapped exactly as recorded are unlocked. With
+// THP set to "never" (most Android kernels) no huge pages are obtained and
+// the report says so.
+//
+
+#ifndef HUGEPAGES_H
+#define HUGEPAGES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct mem_snapshot;
+
+// Anonymous mappings of the process now. NULL on failure.
+struct mem_snapshot *mem_snapshot_take(void);
+void mem_snapshot_free(struct mem_snapshot *s);
+
+enum thp_mode { THP_UNAVAILABLE = 0, THP_MADVISE = 1, THP_ALWAYS = 2 };
+
+struct hugepage_report {
+    int64_t       bytes;         // new mappings found (may include other threads')
+    int64_t       huge_bytes;    // of those, backed by huge pages
+    int64_t       locked_bytes;  // of those, mlock'ed
+    int           regions;
+    enum thp_mode thp;           // system setting
+};
+
+// Advise (huge) and/or lock the mappings that appeared since before. Locked
+// ranges are recorded under owner (the context). False if the mappings can't
+// be read.
+bool hugepages_apply(const struct mem_snapshot *before, const void *owner, bool huge, bool lock,
+                     struct hugepage_report *out);
+
+// munlock the ranges hugepages_apply locked for owner that /proc/self/maps
+// still shows exactly as recorded, and forget them all. Call before the owner
+// is freed; no-op if nothing was locked.
+void hugepages_release(const void *owner);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HUGEPAGES_H
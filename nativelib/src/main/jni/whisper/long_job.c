@@ -0,0 +1,356 @@
+//
+// long_job.c — checkpointed long-file transcription (see long_job.h)
+//
+
+// 64-bit file offsets on 32-bit ABIs too: journals of long jobs grow.
+#define _FILE_OFFSET_BITS 64
+
+#include "long_job.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "native_log.h"
+#include "pcm_buffer.h"
+#include "wav_reader.h"
+
+#define JOB_SLICE_MS      (10 * 60 * 1000)  // audio per whisper_full (~38 MB as float)
+#define JOB_TAIL_MS       5000              // segments ending this close to a slice end are redone
+#define JOB_PROMPT_BYTES  224               // text restored as prompt on resume
+#define JOB_LINE_MAX      16384
+
+struct long_job {
+    char        *wav_path;
+    char        *journal_path;
+    atomic_bool  cancel;
+    atomic_llong committed_ms;
+    atomic_llong total_ms;
+    atomic_int   segments;
+    atomic_int   resumes;
+};
+
+// One whisper_full over [offset_ms, offset_ms + len_ms) of the file.
+struct slice {
+    struct long_job *job;
+    FILE            *f;
+    int64_t          offset_ms;
+    int64_t          len_ms;
+    bool             last;          // reaches the end of the file
+    bool             held;          // segments were left for the next slice
+    int64_t          held_from_ms;  // start of the first of them
+    int64_t          committed_ms;
+    bool             failed;        // journal write failed
+    bool             paused;        // the caller's encoder_begin callback stopped the run
+    char            *tail;          // committed text, for the prompt
+
+    whisper_encoder_begin_callback prev_encoder_begin;
+    void                          *prev_encoder_begin_data;
+};
+
+struct long_job *long_job_create(const char *wav_path, const char *journal_path) {
+    if (!wav_path || !journal_path) return NULL;
+    struct long_job *job = calloc(1, sizeof(*job));
+    if (!job) return NULL;
+    job->wav_path = strdup(wav_path);
+    job->journal_path = strdup(journal_path);
+    if (!job->wav_path || !job->journal_path) {
+        long_job_free(job);
+        return NULL;
+    }
+    return job;
+}
+
+void long_job_free(struct long_job *job) {
+    if (!job) return;
+    free(job->wav_path);
+    free(job->journal_path);
+    free(job);
+}
+
+void long_job_cancel(struct long_job *job) {
+    if (job) atomic_store(&job->cancel, true);
+}
+
+void long_job_get_progress(struct long_job *job, struct long_job_progress *out) {
+    out->committed_ms = atomic_load(&job->committed_ms);
+    out->total_ms = atomic_load(&job->total_ms);
+    out->segments = atomic_load(&job->segments);
+    out->resumes = atomic_load(&job->resumes);
+}
+
+/* ============================================================
+ * Journal
+ * ============================================================ */
+
+// Keep the last JOB_PROMPT_BYTES of tail + text, cut at a UTF-8 character start.
+static void tail_append(char *tail, const char *text) {
+    const size_t n = strlen(text);
+    if (n >= JOB_PROMPT_BYTES) {
+        tail[0] = '\0';
+        text += n - JOB_PROMPT_BYTES;
+    }
+    char buf[2 * JOB_PROMPT_BYTES + 1];
+    snprintf(buf, sizeof(buf), "%s%s", tail, text);
+    const char *s = buf;
+    const size_t len = strlen(buf);
+    if (len > JOB_PROMPT_BYTES) s += len - JOB_PROMPT_BYTES;
+    while ((*s & 0xC0) == 0x80) s++;
+    memmove(tail, s, strlen(s) + 1);
+}
+
+static void put_escaped(FILE *f, const char *s) {
+    for (; *s; ++s) {
+        switch (*s) {
+            case '\t': fputs("\\t", f); break;
+            case '\n': fputs("\\n", f); break;
+            case '\\': fputs("\\\\", f); break;
+            default: fputc(*s, f);
+        }
+    }
+}
+
+static void unescape(char *s) {
+    char *out = s;
+    for (; *s; ++s) {
+        if (*s == '\\' && s[1]) {
+            ++s;
+            *out++ = *s == 't' ? '\t' : *s == 'n' ? '\n' : *s;
+        } else {
+            *out++ = *s;
+        }
+    }
+    *out = '\0';
+}
+
+// Make the checkpoint durable: a kill after this loses nothing before it.
+static bool checkpoint(FILE *f, int64_t ms) {
+    fprintf(f, "C\t%lld\n", (long long)ms);
+    return fflush(f) == 0 && fsync(fileno(f)) == 0;
+}
+
+// Continue the journal after its last checkpoint if it belongs to this
+// recording, otherwise start a new one. *resume_ms receives where decoding
+// continues, *done whether the job already finished, tail the text before.
+static FILE *journal_open(struct long_job *job, const struct wav_info *info, int64_t *resume_ms,
+                          bool *done, char *tail) {
+    *resume_ms = 0;
+    *done = false;
+    tail[0] = '\0';
+
+    FILE *f = fopen(job->journal_path, "r+");
+    if (f) {
+        char line[JOB_LINE_MAX];
+        char pending_tail[JOB_PROMPT_BYTES + 1] = "";
+        bool header = false;
+        int segments = 0, pending = 0;
+        long keep = 0;
+
+        while (fgets(line, sizeof(line), f)) {
+            size_t len = strlen(line);
+            if (len == 0 || line[len - 1] != '\n') break;  // torn write
+            line[--len] = '\0';
+
+            if (!header) {
+                unsigned long long frames = 0;
+                int rate = 0;
+                if (sscanf(line, "WJ1\t%llu\t%d", &frames, &rate) != 2 ||
+                    frames != info->frames || rate != info->sample_rate) break;
+                header = true;
+                keep = ftell(f);
+            } else if (line[0] == 'S' && line[1] == '\t') {
+                char *text = strchr(line + 2, '\t');
+                text = text ? strchr(text + 1, '\t') : NULL;
+                if (!text) break;
+                unescape(++text);
+                tail_append(pending_tail, text);
+                pending++;
+            } else if (line[0] == 'C' && line[1] == '\t') {
+                *resume_ms = strtoll(line + 2, NULL, 10);
+                segments += pending;
+                pending = 0;
+                memcpy(tail, pending_tail, sizeof(pending_tail));
+                keep = ftell(f);
+            } else if (strcmp(line, "D") == 0) {
+                *done = true;
+                keep = ftell(f);
+                break;
+            } else {
+                break;
+            }
+        }
+
+        if (header && fflush(f) == 0 && ftruncate(fileno(f), keep) == 0 && fseek(f, keep, SEEK_SET) == 0) {
+            atomic_store(&job->segments, segments);
+            if (*resume_ms > 0 && !*done) atomic_fetch_add(&job->resumes, 1);
+            return f;
+        }
+        fclose(f);
+        *resume_ms = 0;
+        *done = false;
+        tail[0] = '\0';
+        LOGW("long_job: journal %s is for another recording, starting over", job->journal_path);
+    }
+
+    f = fopen(job->journal_path, "w");
+    if (!f) {
+        LOGW("long_job: can't create journal %s", job->journal_path);
+        return NULL;
+    }
+    fprintf(f, "WJ1\t%llu\t%d\n", (unsigned long long)info->frames, info->sample_rate);
+    if (fflush(f) != 0 || fsync(fileno(f)) != 0) {
+        fclose(f);
+        return NULL;
+    }
+    atomic_store(&job->segments, 0);
+    return f;
+}
+
+/* ============================================================
+ * Run
+ * ============================================================ */
+
+// After each window: commit its finished segments and a checkpoint.
+static void on_new_segment(struct whisper_context *ctx, struct whisper_state *state, int n_new, void *user_data) {
+    (void)ctx;
+    struct slice *s = (struct slice *)user_data;
+    if (s->failed || s->held) return;
+
+    const int n = whisper_full_n_segments_from_state(state);
+    int committed = 0;
+    for (int i = n - n_new; i < n; ++i) {
+        const int64_t t0 = whisper_full_get_segment_t0_from_state(state, i) * 10;
+        const int64_t t1 = whisper_full_get_segment_t1_from_state(state, i) * 10;
+        if (!s->last && t1 > s->len_ms - JOB_TAIL_MS) {
+            s->held = true;
+            s->held_from_ms = s->offset_ms + t0;
+            break;
+        }
+        const char *text = whisper_full_get_segment_text_from_state(state, i);
+        fprintf(s->f, "S\t%lld\t%lld\t", (long long)(s->offset_ms + t0), (long long)(s->offset_ms + t1));
+        put_escaped(s->f, text);
+        fputc('\n', s->f);
+        tail_append(s->tail, text);
+        s->committed_ms = s->offset_ms + t1;
+        committed++;
+    }
+    if (committed == 0) return;
+
+    if (!checkpoint(s->f, s->committed_ms)) {
+        LOGW("long_job: journal write failed");
+        s->failed = true;
+        return;
+    }
+    atomic_fetch_add(&s->job->segments, committed);
+    atomic_store(&s->job->committed_ms, s->committed_ms);
+}
+
+static bool on_encoder_begin(struct whisper_context *ctx, struct whisper_state *state, void *user_data) {
+    struct slice *s = (struct slice *)user_data;
+    if (s->failed || atomic_load(&s->job->cancel)) return false;
+    // A stop from the caller's callback (e.g. preemption) is a pause like a cancel.
+    if (s->prev_encoder_begin && !s->prev_encoder_begin(ctx, state, s->prev_encoder_begin_data)) {
+        s->paused = true;
+        return false;
+    }
+    return true;
+}
+
+enum long_job_status long_job_run(struct long_job *job, struct whisper_context *ctx,
+                                  struct whisper_full_params params, bool restore_prompt) {
+    atomic_store(&job->cancel, false);
+    struct wav_info info;
+    if (!wav_reader_probe(job->wav_path, &info)) {
+        LOGW("long_job: can't read %s", job->wav_path);
+        return LONG_JOB_FAILED;
+    }
+    const int64_t total_ms = (int64_t)(info.frames * 1000 / (uint64_t)info.sample_rate);
+    atomic_store(&job->total_ms, total_ms);
+
+    char tail[JOB_PROMPT_BYTES + 1];
+    int64_t seek_ms = 0;
+    bool done = false;
+    FILE *f = journal_open(job, &info, &seek_ms, &done, tail);
+    if (!f) return LONG_JOB_FAILED;
+    atomic_store(&job->committed_ms, done ? total_ms : seek_ms);
+    if (done) {
+        fclose(f);
+        return LONG_JOB_DONE;
+    }
+    if (seek_ms > 0) LOGI("long_job: resuming at %lld of %lld ms", (long long)seek_ms, (long long)total_ms);
+
+    const whisper_encoder_begin_callback prev_encoder_begin = params.encoder_begin_callback;
+    void *prev_encoder_begin_data = params.encoder_begin_callback_user_data;
+
+    enum long_job_status status = LONG_JOB_DONE;
+    while (seek_ms < total_ms) {
+        if (atomic_load(&job->cancel)) {
+            status = LONG_JOB_CANCELLED;
+            break;
+        }
+        struct pcm_buffer *buf = wav_reader_load_range(job->wav_path, seek_ms, seek_ms + JOB_SLICE_MS, NULL);
+        int n = 0;
+        float *pcm = buf ? pcm_buffer_to_f32(buf, 0, &n) : NULL;
+        pcm_buffer_free(buf);
+        if (!pcm) {
+            status = LONG_JOB_FAILED;
+            break;
+        }
+
+        struct slice s = {
+            .job = job,
+            .f = f,
+            .offset_ms = seek_ms,
+            .len_ms = (int64_t)n * 1000 / WHISPER_SAMPLE_RATE,
+            .last = seek_ms + JOB_SLICE_MS >= total_ms,
+            .committed_ms = seek_ms,
+            .tail = tail,
+            .prev_encoder_begin = prev_encoder_begin,
+            .prev_encoder_begin_data = prev_encoder_begin_data,
+        };
+        params.initial_prompt = restore_prompt && tail[0] ? tail : NULL;
+        params.new_segment_callback = on_new_segment;
+        params.new_segment_callback_user_data = &s;
+        params.encoder_begin_callback = on_encoder_begin;
+        params.encoder_begin_callback_user_data = &s;
+
+        const int rc = whisper_full(ctx, params, pcm, n);
+        free(pcm);
+        if (rc != 0 || s.failed) {
+            status = LONG_JOB_FAILED;
+            break;
+        }
+        if (s.paused || atomic_load(&job->cancel)) {
+            status = LONG_JOB_CANCELLED;
+            break;
+        }
+
+        // Next slice: at the segments held back, else past this one (minus
+        // the tail, where speech may have been cut off without a segment).
+        int64_t next = s.last ? total_ms
+                     : s.held ? s.held_from_ms
+                     : s.offset_ms + s.len_ms - JOB_TAIL_MS;
+        if (!s.last && next < s.committed_ms) next = s.committed_ms;
+        if (next <= seek_ms) next = s.offset_ms + s.len_ms - JOB_TAIL_MS;
+        if (next != s.committed_ms) {
+            if (!checkpoint(f, next)) {
+                status = LONG_JOB_FAILED;
+                break;
+            }
+            atomic_store(&job->committed_ms, next);
+        }
+        seek_ms = next;
+    }
+
+    if (status == LONG_JOB_DONE) {
+        fputs("D\n", f);
+        if (fflush(f) != 0 || fsync(fileno(f)) != 0) status = LONG_JOB_FAILED;
+    }
+    fclose(f);
+    LOGI("long_job: %s at %lld of %lld ms, %d segments",
+         status == LONG_JOB_DONE ? "done" : status == LONG_JOB_CANCELLED ? "paused" : "failed",
+         (long long)atomic_load(&job->committed_ms), (long long)total_ms, atomic_load(&job->segments));
+    return status;
+}
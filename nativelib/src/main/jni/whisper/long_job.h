@@ -0,0 +1,71 @@
+//
+// long_job.h — checkpointed, resumable transcription of long WAV files
+//
+// A two-hour file is one whisper_full run, and a process killed halfway loses
+// all of it. A job instead runs the file in slices (read straight from the
+// WAV, see wav_reader.h) and, after every decoded window, appends the finished
+// segments and a checkpoint to a journal and syncs it. Run again after a
+// crash, a kill or a cancel, the job continues at the last checkpoint; with
+// restore_prompt the text before it is given as the prompt, as if the run had
+// never stopped.
+//
+// Segments that end near a slice end are not committed: the next slice starts
+// at the last checkpoint and decodes them again with the audio after them.
+//
+// Journal (UTF-8 text, one record per line, fields tab-separated; \t, \n and
+// \\ escaped in text):
+//   WJ1 <frames> <sample rate>   the recording the journal belongs to
+//   S <t0 ms> <t1 ms> <text>     a segment (absolute times)
+//   C <ms>                       checkpoint: the S lines above are final,
+//                                decoding resumes at <ms>
+//   D                            the whole file is done
+// Lines after the last C are dropped on resume (a torn write).
+//
+
+#ifndef LONG_JOB_H
+#define LONG_JOB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "whisper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum long_job_status {
+    LONG_JOB_FAILED    = -1,
+    LONG_JOB_CANCELLED = 0,   // stopped at a checkpoint; run again to resume
+    LONG_JOB_DONE      = 1,
+};
+
+struct long_job;
+
+struct long_job_progress {
+    int64_t committed_ms;   // audio covered by the journal
+    int64_t total_ms;       // 0 until the file was opened
+    int     segments;       // committed segments
+    int     resumes;        // runs that continued an existing journal
+};
+
+struct long_job *long_job_create(const char *wav_path, const char *journal_path);
+void long_job_free(struct long_job *job);
+
+// Run (or resume) the job with the given base params (language, threads,
+// task). Blocks until the file is done, the job is cancelled or it fails.
+// An encoder_begin callback in params is chained; if it stops the run, the
+// job pauses at that window as if cancelled (see preempt.h).
+enum long_job_status long_job_run(struct long_job *job, struct whisper_context *ctx,
+                                  struct whisper_full_params params, bool restore_prompt);
+
+// Stop a running job at the next window (any thread).
+void long_job_cancel(struct long_job *job);
+
+void long_job_get_progress(struct long_job *job, struct long_job_progress *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LONG_JOB_H
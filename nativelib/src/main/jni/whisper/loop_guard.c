@@ -0,0 +1,138 @@
+//
+// loop_guard.c — decoder repetition loop detection (see loop_guard.h)
+//
+
+#include "loop_guard.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "native_log.h"
+
+#define LG_MAX_NGRAM     16
+#define LG_VARIETY_SPAN  48   // newest text tokens checked for variety
+#define LG_MIN_DISTINCT  12   // fewer distinct tokens than this in the span is a loop
+#define LG_STALL_STAMPS  6    // this many equal timestamps in a row (3 empty-time segments)
+#define LG_TAIL          (LG_MAX_NGRAM * 12)
+
+static atomic_int g_hits[3];
+
+// Back-to-back repeats an n-gram needs to count as a loop: a word said twice
+// is speech, a short token said twelve times is not.
+static int repeats_needed(int len) {
+    return len == 1 ? 12 : len == 2 ? 6 : len == 3 ? 4 : 3;
+}
+
+enum loop_kind loop_guard_check(const whisper_token *tokens, int n, whisper_token eot,
+                                whisper_token beg, int *keep) {
+    if (keep) *keep = n;
+
+    // Newest text tokens, newest first, with their positions.
+    whisper_token text[LG_TAIL];
+    int pos[LG_TAIL];
+    int m = 0;
+    int stamps = 0, stamp = -1;
+    bool stalled = false;
+    for (int i = n - 1; i >= 0 && m < LG_TAIL; --i) {
+        if (tokens[i] < eot) {
+            text[m] = tokens[i];
+            pos[m++] = i;
+        } else if (tokens[i] >= beg && !stalled && stamps < LG_STALL_STAMPS) {
+            if (stamps == 0 || tokens[i] == stamp) {
+                stamp = tokens[i];
+                stalled = ++stamps == LG_STALL_STAMPS;
+            } else {
+                stamps = LG_STALL_STAMPS;  // time moved: no stall
+            }
+        }
+    }
+    if (m == 0) return LOOP_NONE;
+
+    for (int len = 1; len <= LG_MAX_NGRAM && 2 * len <= m; ++len) {
+        int reps = 1;
+        while ((reps + 1) * len <= m) {
+            bool same = true;
+            for (int j = 0; j < len && same; ++j) same = text[j] == text[reps * len + j];
+            if (!same) break;
+            reps++;
+        }
+        if (reps >= repeats_needed(len)) {
+            // Keep through the newest token of the oldest occurrence.
+            if (keep) *keep = pos[(reps - 1) * len] + 1;
+            return LOOP_REPEAT;
+        }
+    }
+
+    if (stalled) return LOOP_STALL;
+
+    if (m >= LG_VARIETY_SPAN) {
+        int distinct = 0;
+        for (int i = 0; i < LG_VARIETY_SPAN && distinct < LG_MIN_DISTINCT; ++i) {
+            bool seen = false;
+            for (int j = 0; j < i && !seen; ++j) seen = text[j] == text[i];
+            if (!seen) distinct++;
+        }
+        if (distinct < LG_MIN_DISTINCT) return LOOP_LOW_VARIETY;
+    }
+    return LOOP_NONE;
+}
+
+void loop_guard_count(enum loop_kind kind) {
+    if (kind != LOOP_NONE) atomic_fetch_add(&g_hits[kind - 1], 1);
+}
+
+void loop_guard_filter(struct whisper_context *ctx, struct whisper_state *state,
+                       const whisper_token_data *tokens, int n_tokens, float *logits, void *user_data) {
+    (void)state; (void)user_data;
+    if (n_tokens < 2) return;
+
+    const whisper_token eot = whisper_token_eot(ctx);
+    const whisper_token beg = whisper_token_beg(ctx);
+    const whisper_token window_end = beg + 1500;  // <|30.00|>, see loop_guard_close_window
+
+    whisper_token ids[LG_TAIL];
+    const int n = n_tokens < LG_TAIL ? n_tokens : LG_TAIL;
+    for (int i = 0; i < n; ++i) ids[i] = tokens[n_tokens - n + i].id;
+
+    const enum loop_kind kind = loop_guard_check(ids, n, eot, beg, NULL);
+    if (kind == LOOP_NONE) return;
+
+    if (ids[n - 1] != window_end) {
+        loop_guard_count(kind);
+        LOGI("loop_guard: %s after %d tokens, closing the window",
+             kind == LOOP_REPEAT ? "repeat" : kind == LOOP_STALL ? "timestamp stall" : "low variety", n_tokens);
+    }
+    loop_guard_close_window(ctx, tokens, n_tokens, logits);
+}
+
+bool loop_guard_close_window(struct whisper_context *ctx, const whisper_token_data *tokens, int n_tokens,
+                             float *logits) {
+    const whisper_token eot = whisper_token_eot(ctx);
+    const whisper_token beg = whisper_token_beg(ctx);
+    const whisper_token window_end = beg + 1500;  // <|30.00|>
+    const whisper_token last = n_tokens > 0 ? tokens[n_tokens - 1].id : eot;
+
+    // In timestamp mode the window starts with a timestamp: close the segment
+    // at the window end so whisper seeks past the rest, then end the window.
+    const bool timestamps = n_tokens > 0 && tokens[0].id >= beg;
+    const whisper_token forced = timestamps && last < eot ? window_end : eot;
+
+    const int n_vocab = whisper_n_vocab(ctx);
+    for (int i = 0; i < n_vocab; ++i) {
+        if (i != forced) logits[i] = -INFINITY;
+    }
+    return last != window_end;
+}
+
+void loop_guard_apply(struct whisper_full_params *p) {
+    p->logits_filter_callback = loop_guard_filter;
+    p->logits_filter_callback_user_data = NULL;
+}
+
+void loop_guard_totals(struct loop_guard_stats *out) {
+    if (!out) return;
+    out->repeats = atomic_load(&g_hits[LOOP_REPEAT - 1]);
+    out->stalls = atomic_load(&g_hits[LOOP_STALL - 1]);
+    out->low_variety = atomic_load(&g_hits[LOOP_LOW_VARIETY - 1]);
+}
@@ -0,0 +1,72 @@
+//
+// loop_guard.h — detect decoder repetition loops and end them early
+//
+// On silence or noise whisper tends to emit the same phrase again and again
+// until the text context is full; every repeat costs a decoder call and the
+// result is garbage. The guard watches the token stream of the current window
+// and reports:
+//   - repeats:  the newest n-gram repeated back to back (more repeats needed
+//               for shorter n-grams);
+//   - stalls:   several segments in a row whose timestamps do not advance;
+//   - low variety: few distinct tokens among the newest ones, the token-level
+//               equivalent of whisper's compression-ratio check.
+//
+// loop_guard_apply hooks it into whisper_full through the logits filter: on a
+// hit the window is closed at once (with a final timestamp at the window end
+// in timestamp mode, so the seek moves past the loop) and the hit is counted.
+//
+
+#ifndef LOOP_GUARD_H
+#define LOOP_GUARD_H
+
+#include <stdbool.h>
+
+#include "whisper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum loop_kind {
+    LOOP_NONE = 0,
+    LOOP_REPEAT,
+    LOOP_STALL,
+    LOOP_LOW_VARIETY,
+};
+
+struct loop_guard_stats {
+    int repeats;
+    int stalls;
+    int low_variety;
+};
+
+// Check the newest tokens of a window (text tokens are < eot, timestamps >=
+// beg). On a repeat, *keep (if not NULL) receives how many tokens to keep so
+// that one occurrence remains; otherwise n.
+enum loop_kind loop_guard_check(const whisper_token *tokens, int n, whisper_token eot,
+                                whisper_token beg, int *keep);
+
+// Install the guard as p's logits filter (replaces any other).
+void loop_guard_apply(struct whisper_full_params *p);
+
+// The filter itself (user_data unused), for filters that chain to it.
+void loop_guard_filter(struct whisper_context *ctx, struct whisper_state *state,
+                       const whisper_token_data *tokens, int n_tokens, float *logits, void *user_data);
+
+// Leave only the token that ends the current window: EOT, or in timestamp mode
+// first a closing <|30.00|> so whisper seeks past the rest of the window.
+// Returns false if the window end was already forced (this is the EOT after it).
+bool loop_guard_close_window(struct whisper_context *ctx, const whisper_token_data *tokens, int n_tokens,
+                             float *logits);
+
+// Count a hit found outside whisper_full (e.g. by a greedy decoder).
+void loop_guard_count(enum loop_kind kind);
+
+// Hits since the library was loaded.
+void loop_guard_totals(struct loop_guard_stats *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOOP_GUARD_H
@@ -0,0 +1,107 @@
+//
+// model_load.c — progress and cancellation for model loaders (see model_load.h)
+//
+
+#include "model_load.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "native_log.h"
+
+struct model_load *model_load_create(void) {
+    struct model_load *l = calloc(1, sizeof(*l));
+    if (!l) return NULL;
+    atomic_init(&l->read, 0);
+    atomic_init(&l->total, 0);
+    atomic_init(&l->cancelled, false);
+    return l;
+}
+
+void model_load_free(struct model_load *l) {
+    free(l);
+}
+
+void model_load_cancel(struct model_load *l) {
+    if (l) atomic_store(&l->cancelled, true);
+}
+
+/* ---- counting wrapper ---- */
+
+struct wrapped {
+    struct model_load          *load;
+    struct whisper_model_loader inner;
+};
+
+static size_t wrapped_read(void *ctx, void *output, size_t read_size) {
+    struct wrapped *w = (struct wrapped *)ctx;
+    if (atomic_load(&w->load->cancelled)) {
+        // whisper.cpp doesn't check read counts; hand it zeros until it sees eof.
+        memset(output, 0, read_size);
+        return 0;
+    }
+    const size_t n = w->inner.read(w->inner.context, output, read_size);
+    atomic_fetch_add(&w->load->read, (long long)n);
+    return n;
+}
+
+static bool wrapped_eof(void *ctx) {
+    struct wrapped *w = (struct wrapped *)ctx;
+    return atomic_load(&w->load->cancelled) || w->inner.eof(w->inner.context);
+}
+
+static void wrapped_close(void *ctx) {
+    struct wrapped *w = (struct wrapped *)ctx;
+    if (atomic_load(&w->load->cancelled)) LOGI("model_load: cancelled after %lld bytes",
+                                               (long long)atomic_load(&w->load->read));
+    w->inner.close(w->inner.context);
+    free(w);
+}
+
+bool model_load_wrap(struct model_load *l, struct whisper_model_loader inner, int64_t total,
+                     struct whisper_model_loader *out) {
+    struct wrapped *w = malloc(sizeof(*w));
+    if (!w) return false;
+    w->load = l;
+    w->inner = inner;
+    atomic_store(&l->read, 0);
+    atomic_store(&l->total, total > 0 ? total : 0);
+    out->context = w;
+    out->read = wrapped_read;
+    out->eof = wrapped_eof;
+    out->close = wrapped_close;
+    return true;
+}
+
+/* ---- file loader ---- */
+
+static size_t file_read(void *ctx, void *output, size_t read_size) {
+    return fread(output, 1, read_size, (FILE *)ctx);
+}
+
+static bool file_eof(void *ctx) {
+    return feof((FILE *)ctx) != 0;
+}
+
+static void file_close(void *ctx) {
+    fclose((FILE *)ctx);
+}
+
+bool model_load_file_loader(const char *path, struct whisper_model_loader *out, int64_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        LOGE("model_load: can't open '%s'", path);
+        return false;
+    }
+    *size = 0;
+    if (fseeko(f, 0, SEEK_END) == 0) {
+        *size = (int64_t)ftello(f);
+        fseeko(f, 0, SEEK_SET);
+    }
+    out->context = f;
+    out->read = file_read;
+    out->eof = file_eof;
+    out->close = file_close;
+    return true;
+}
@@ -0,0 +1,54 @@
+//
+// model_load.h — observable, cancellable model loads
+//
+// Loading a model reads hundreds of MB through a whisper_model_loader and
+// takes seconds, with nothing to show for it and no way to stop it. A
+// model_load wraps any loader: every read adds to a byte counter another
+// thread can poll against the source's total size, and a cancel makes the
+// wrapped loader report end of file. whisper.cpp then stops at the next
+// tensor and fails the load ("not all tensors loaded"), freeing what it has
+// allocated, so the init call returns NULL soon after the cancel.
+//
+// One model_load serves one load; it outlives the init call it was used for.
+//
+
+#ifndef MODEL_LOAD_H
+#define MODEL_LOAD_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "whisper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct model_load {
+    atomic_llong read;       // bytes read so far
+    atomic_llong total;      // source size, 0 if unknown
+    atomic_bool  cancelled;
+};
+
+struct model_load *model_load_create(void);
+void model_load_free(struct model_load *l);
+
+// Any thread.
+void model_load_cancel(struct model_load *l);
+
+// A loader that reads through inner, counting into l (total = inner's size,
+// 0 if unknown). Closing it closes inner. False if it can't be allocated
+// (inner is then left open).
+bool model_load_wrap(struct model_load *l, struct whisper_model_loader inner, int64_t total,
+                     struct whisper_model_loader *out);
+
+// A loader reading the file at path; false if it can't be opened. *size is
+// set to the file's size.
+bool model_load_file_loader(const char *path, struct whisper_model_loader *out, int64_t *size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODEL_LOAD_H
@@ -0,0 +1,26 @@
+//
+// native_log.h — logging shared by the JNI layer and the host tools
+//
+// On Android this goes to logcat under "JNI-Whisper"; host builds (see
+// tools/) print to stderr so the same modules can run on Linux.
+//
+
+#ifndef NATIVE_LOG_H
+#define NATIVE_LOG_H
+
+#define TAG "JNI-Whisper"
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN,  TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#else
+#include <stdio.h>
+#define LOG_HOST_(lvl, ...) (fprintf(stderr, lvl "/" TAG ": " __VA_ARGS__), fputc('\n', stderr))
+#define LOGI(...) LOG_HOST_("I", __VA_ARGS__)
+#define LOGW(...) LOG_HOST_("W", __VA_ARGS__)
+#define LOGE(...) LOG_HOST_("E", __VA_ARGS__)
+#endif
+
+#endif // NATIVE_LOG_H
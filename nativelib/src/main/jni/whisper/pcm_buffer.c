@@ -0,0 +1,174 @@
+//
+// pcm_buffer.c — chunked PCM store shared by the recorder and the transcriber
+//
+
+#include "pcm_buffer.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "native_log.h"
+#include "whisper.h"
+
+// 64K samples per chunk (~4 s at 16 kHz, ~1.4 s at 48 kHz).
+#define PCM_CHUNK_SHIFT   16
+#define PCM_CHUNK_SAMPLES ((size_t)1 << PCM_CHUNK_SHIFT)
+#define PCM_CHUNK_MASK    (PCM_CHUNK_SAMPLES - 1)
+
+struct pcm_buffer {
+    pthread_mutex_t lock;
+    int16_t **chunks;     // chunk table; chunk contents never move
+    size_t    n_chunks;
+    size_t    cap_chunks;
+    size_t    n_samples;
+    int       sample_rate;
+};
+
+/* ============================================================
+ * Lifecycle / append
+ * ============================================================ */
+
+struct pcm_buffer *pcm_buffer_create(int sample_rate) {
+    if (sample_rate <= 0) return NULL;
+    struct pcm_buffer *b = (struct pcm_buffer *)calloc(1, sizeof(*b));
+    if (!b) return NULL;
+    pthread_mutex_init(&b->lock, NULL);
+    b->sample_rate = sample_rate;
+    return b;
+}
+
+void pcm_buffer_free(struct pcm_buffer *b) {
+    if (!b) return;
+    for (size_t i = 0; i < b->n_chunks; ++i) free(b->chunks[i]);
+    free(b->chunks);
+    pthread_mutex_destroy(&b->lock);
+    free(b);
+}
+
+static bool add_chunk_locked(struct pcm_buffer *b) {
+    if (b->n_chunks == b->cap_chunks) {
+        size_t cap = b->cap_chunks ? b->cap_chunks * 2 : 16;
+        int16_t **tbl = (int16_t **)realloc(b->chunks, cap * sizeof(*tbl));
+        if (!tbl) return false;
+        b->chunks = tbl;
+        b->cap_chunks = cap;
+    }
+    int16_t *c = (int16_t *)malloc(PCM_CHUNK_SAMPLES * sizeof(int16_t));
+    if (!c) return false;
+    b->chunks[b->n_chunks++] = c;
+    return true;
+}
+
+bool pcm_buffer_append(struct pcm_buffer *b, const int16_t *samples, size_t n) {
+    if (!b || (!samples && n)) return false;
+    pthread_mutex_lock(&b->lock);
+    bool ok = true;
+    while (n > 0) {
+        size_t off = b->n_samples & PCM_CHUNK_MASK;
+        if (off == 0 && (b->n_samples >> PCM_CHUNK_SHIFT) == b->n_chunks) {
+            if (!add_chunk_locked(b)) { LOGE("pcm_buffer: out of memory"); ok = false; break; }
+        }
+        size_t take = PCM_CHUNK_SAMPLES - off;
+        if (take > n) take = n;
+        memcpy(b->chunks[b->n_samples >> PCM_CHUNK_SHIFT] + off, samples, take * sizeof(int16_t));
+        b->n_samples += take;
+        samples += take;
+        n -= take;
+    }
+    pthread_mutex_unlock(&b->lock);
+    return ok;
+}
+
+size_t pcm_buffer_samples(struct pcm_buffer *b) {
+    if (!b) return 0;
+    pthread_mutex_lock(&b->lock);
+    size_t n = b->n_samples;
+    pthread_mutex_unlock(&b->lock);
+    return n;
+}
+
+int pcm_buffer_sample_rate(const struct pcm_buffer *b) {
+    return b ? b->sample_rate : 0;
+}
+
+/* ============================================================
+ * Readers
+ *
+ * Readers copy the chunk pointers under the lock and then read without it:
+ * samples below the snapshot count are immutable, so a concurrent append only
+ * ever touches memory past what the reader looks at.
+ * ============================================================ */
+
+static int16_t **snapshot(struct pcm_buffer *b, size_t max_samples, size_t *n_out) {
+    pthread_mutex_lock(&b->lock);
+    size_t n = b->n_samples;
+    if (max_samples > 0 && max_samples < n) n = max_samples;
+    size_t nc = (n + PCM_CHUNK_SAMPLES - 1) >> PCM_CHUNK_SHIFT;
+    int16_t **tbl = nc ? (int16_t **)malloc(nc * sizeof(*tbl)) : NULL;
+    if (tbl) memcpy(tbl, b->chunks, nc * sizeof(*tbl));
+    pthread_mutex_unlock(&b->lock);
+    *n_out = tbl ? n : 0;
+    return tbl;
+}
+
+#define SAMPLE_AT(tbl, i) ((tbl)[(i) >> PCM_CHUNK_SHIFT][(i) & PCM_CHUNK_MASK])
+
+struct pcm_buffer *pcm_buffer_copy(struct pcm_buffer *b, size_t max_samples) {
+    if (!b) return NULL;
+    size_t n = 0;
+    int16_t **tbl = snapshot(b, max_samples, &n);
+    if (!tbl) return NULL;
+
+    struct pcm_buffer *dst = pcm_buffer_create(b->sample_rate);
+    for (size_t done = 0; dst && done < n; done += PCM_CHUNK_SAMPLES) {
+        const size_t take = (n - done < PCM_CHUNK_SAMPLES) ? n - done : PCM_CHUNK_SAMPLES;
+        if (!pcm_buffer_append(dst, tbl[done >> PCM_CHUNK_SHIFT], take)) {
+            pcm_buffer_free(dst);
+            dst = NULL;
+        }
+    }
+    free(tbl);
+    return dst;
+}
+
+float *pcm_buffer_to_f32(struct pcm_buffer *b, size_t max_samples, int *n_out) {
+    return pcm_buffer_range_to_f32(b, 0, max_samples, n_out);
+}
+
+float *pcm_buffer_range_to_f32(struct pcm_buffer *b, size_t start, size_t max_samples, int *n_out) {
+    if (n_out) *n_out = 0;
+    if (!b || !n_out) return NULL;
+
+    size_t n = 0;
+    int16_t **tbl = snapshot(b, max_samples ? start + max_samples : 0, &n);
+    if (!tbl) return NULL;
+    if (n <= start) { free(tbl); return NULL; }
+    const size_t n_src = n - start;
+
+    const int rate = b->sample_rate;
+    size_t n_dst = (rate == WHISPER_SAMPLE_RATE)
+            ? n_src : (size_t)((double)n_src * WHISPER_SAMPLE_RATE / rate);
+    float *dst = n_dst ? (float *)malloc(n_dst * sizeof(float)) : NULL;
+    if (!dst) { free(tbl); return NULL; }
+
+    if (rate == WHISPER_SAMPLE_RATE) {
+        for (size_t i = 0; i < n_src; ++i) dst[i] = (float)SAMPLE_AT(tbl, start + i) / 32768.0f;
+    } else {
+        // Linear interpolation is enough here: whisper's mel front end
+        // discards everything above 8 kHz anyway.
+        const double step = (double)rate / WHISPER_SAMPLE_RATE;
+        for (size_t i = 0; i < n_dst; ++i) {
+            double pos = (double)i * step;
+            size_t i0 = (size_t)pos;
+            size_t i1 = (i0 + 1 < n_src) ? i0 + 1 : i0;
+            float frac = (float)(pos - (double)i0);
+            float s0 = (float)SAMPLE_AT(tbl, start + i0), s1 = (float)SAMPLE_AT(tbl, start + i1);
+            dst[i] = (s0 + (s1 - s0) * frac) / 32768.0f;
+        }
+    }
+
+    free(tbl);
+    *n_out = (int)n_dst;
+    return dst;
+}
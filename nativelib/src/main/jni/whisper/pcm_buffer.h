@@ -0,0 +1,53 @@
+//
+// pcm_buffer.h — native-owned growable PCM store used to hand recordings to whisper
+//
+// The recorder appends 16-bit mono samples at the device capture rate while it
+// records; at stop the same memory is converted once to 16 kHz float for
+// whisper_full, so the stop path never goes back to disk. (The WAV file is
+// streamed separately by the recorder.)
+//
+// - Storage is a list of fixed-size chunks: appends never move existing samples.
+// - Appends and reads may run on different threads (internally locked).
+//
+
+#ifndef PCM_BUFFER_H
+#define PCM_BUFFER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct pcm_buffer;
+
+struct pcm_buffer *pcm_buffer_create(int sample_rate);
+void pcm_buffer_free(struct pcm_buffer *b);
+
+// Append n little-endian 16-bit mono samples. Returns false on OOM.
+bool pcm_buffer_append(struct pcm_buffer *b, const int16_t *samples, size_t n);
+
+// Number of samples captured so far (at the capture rate).
+size_t pcm_buffer_samples(struct pcm_buffer *b);
+int pcm_buffer_sample_rate(const struct pcm_buffer *b);
+
+// Copy of the first max_samples captured samples (0 = all), e.g. to analyze the
+// start of a recording that is still growing. NULL if empty or on OOM.
+struct pcm_buffer *pcm_buffer_copy(struct pcm_buffer *b, size_t max_samples);
+
+// Convert the first max_samples captured samples (0 = all) to float mono at
+// WHISPER_SAMPLE_RATE, resampling linearly if needed. Returns a malloc'd array
+// (caller frees) and stores its length in *n_out; NULL on failure/empty.
+float *pcm_buffer_to_f32(struct pcm_buffer *b, size_t max_samples, int *n_out);
+
+// As pcm_buffer_to_f32, for max_samples (0 = all) captured samples from start
+// on (both at the capture rate). NULL if start is at or past the end.
+float *pcm_buffer_range_to_f32(struct pcm_buffer *b, size_t start, size_t max_samples, int *n_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCM_BUFFER_H
@@ -0,0 +1,54 @@
+//
+// preempt.c — window-boundary preemption of whisper_full runs (see preempt.h)
+//
+
+#include "preempt.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "native_log.h"
+
+struct preempt_token *preempt_token_create(void) {
+    struct preempt_token *t = calloc(1, sizeof(*t));
+    if (t) atomic_init(&t->requested, false);
+    return t;
+}
+
+void preempt_token_free(struct preempt_token *t) {
+    free(t);
+}
+
+void preempt_request(struct preempt_token *t) {
+    if (t) atomic_store(&t->requested, true);
+}
+
+void preempt_reset(struct preempt_token *t) {
+    if (t) atomic_store(&t->requested, false);
+}
+
+static bool on_encoder_begin(struct whisper_context *ctx, struct whisper_state *state, void *user_data) {
+    struct preempt_run *r = (struct preempt_run *)user_data;
+    if (atomic_exchange(&r->token->requested, false)) {
+        // Segments so far are final; the next window starts where the last
+        // one ended (t1 is in 10 ms units).
+        const int n = whisper_full_n_segments_from_state(state);
+        r->resume_ms = n > 0 ? whisper_full_get_segment_t1_from_state(state, n - 1) * 10 : r->offset_ms;
+        if (r->resume_ms < r->offset_ms) r->resume_ms = r->offset_ms;
+        r->stopped = true;
+        LOGI("preempt: stopping at %lld ms", (long long)r->resume_ms);
+        return false;
+    }
+    return r->prev_encoder_begin ? r->prev_encoder_begin(ctx, state, r->prev_encoder_begin_data) : true;
+}
+
+void preempt_begin(struct preempt_run *r, struct preempt_token *t, struct whisper_full_params *p) {
+    memset(r, 0, sizeof(*r));
+    r->token = t;
+    r->offset_ms = p->offset_ms;
+    r->resume_ms = -1;
+    r->prev_encoder_begin = p->encoder_begin_callback;
+    r->prev_encoder_begin_data = p->encoder_begin_callback_user_data;
+    p->encoder_begin_callback = on_encoder_begin;
+    p->encoder_begin_callback_user_data = r;
+}
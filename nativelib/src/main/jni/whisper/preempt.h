@@ -0,0 +1,58 @@
+//
+// preempt.h — stop a whisper_full run at the next window boundary
+//
+// Background work (batch re-transcription, long-file jobs) holds the context
+// for minutes, and a recording made meanwhile would wait for all of it. The
+// request queue on the Kotlin side signals a token when interactive work
+// arrives; a run holding that token stops before its next encoder pass, with
+// every window decoded so far kept, and reports where to resume. The run is
+// then queued again behind the interactive request.
+//
+// Stopping at a window boundary (the encoder_begin callback) loses nothing;
+// abort_callback would stop sooner but throw away the window in progress.
+//
+
+#ifndef PREEMPT_H
+#define PREEMPT_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "whisper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct preempt_token {
+    atomic_bool requested;
+};
+
+struct preempt_token *preempt_token_create(void);
+void preempt_token_free(struct preempt_token *t);
+
+// Any thread. The run holding t stops at its next window boundary.
+void preempt_request(struct preempt_token *t);
+// Clear a request (before the run that should honour new ones starts).
+void preempt_reset(struct preempt_token *t);
+
+struct preempt_run {
+    struct preempt_token *token;
+    bool     stopped;        // the run was preempted
+    int64_t  resume_ms;      // where to continue (valid when stopped)
+    int64_t  offset_ms;      // p->offset_ms at begin
+
+    whisper_encoder_begin_callback prev_encoder_begin;
+    void                          *prev_encoder_begin_data;
+};
+
+// Hook t into p (chains any encoder_begin callback already set). r must
+// outlive the whisper_full call.
+void preempt_begin(struct preempt_run *r, struct preempt_token *t, struct whisper_full_params *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PREEMPT_H
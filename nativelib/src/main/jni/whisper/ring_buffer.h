@@ -0,0 +1,85 @@
+//
+// ring_buffer.h — single-producer / single-consumer lock-free PCM ring
+//
+// The producer is an audio callback (AAudio) or a reader thread (file
+// backend); the consumer is the capture session drain thread. Neither side
+// takes a lock or allocates, so the producer is safe to call from a
+// real-time audio thread.
+//
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct ring_buffer {
+    int16_t        *data;
+    size_t          mask;   // capacity - 1 (capacity is a power of two)
+    atomic_size_t   head;   // total samples written (producer-owned)
+    atomic_size_t   tail;   // total samples read    (consumer-owned)
+};
+
+static inline bool ring_init(struct ring_buffer *r, size_t min_capacity) {
+    size_t cap = 1024;
+    while (cap < min_capacity) cap <<= 1;
+    r->data = (int16_t *)calloc(cap, sizeof(int16_t));
+    if (!r->data) return false;
+    r->mask = cap - 1;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    return true;
+}
+
+static inline void ring_free(struct ring_buffer *r) {
+    free(r->data);
+    r->data = NULL;
+}
+
+static inline size_t ring_capacity(const struct ring_buffer *r) { return r->mask + 1; }
+
+// Consumer side: samples ready to read.
+static inline size_t ring_available(struct ring_buffer *r) {
+    return atomic_load_explicit(&r->head, memory_order_acquire)
+         - atomic_load_explicit(&r->tail, memory_order_relaxed);
+}
+
+// Producer side: copies up to n samples, returns how many fit.
+static inline size_t ring_write(struct ring_buffer *r, const int16_t *src, size_t n) {
+    const size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    const size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    const size_t space = ring_capacity(r) - (head - tail);
+    if (n > space) n = space;
+    if (n == 0) return 0;
+
+    const size_t pos = head & r->mask;
+    const size_t first = (n < ring_capacity(r) - pos) ? n : ring_capacity(r) - pos;
+    memcpy(r->data + pos, src, first * sizeof(int16_t));
+    if (n > first) memcpy(r->data, src + first, (n - first) * sizeof(int16_t));
+
+    atomic_store_explicit(&r->head, head + n, memory_order_release);
+    return n;
+}
+
+// Consumer side: copies up to max samples, returns how many were read.
+static inline size_t ring_read(struct ring_buffer *r, int16_t *dst, size_t max) {
+    const size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    const size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    size_t n = head - tail;
+    if (n > max) n = max;
+    if (n == 0) return 0;
+
+    const size_t pos = tail & r->mask;
+    const size_t first = (n < ring_capacity(r) - pos) ? n : ring_capacity(r) - pos;
+    memcpy(dst, r->data + pos, first * sizeof(int16_t));
+    if (n > first) memcpy(dst + first, r->data, (n - first) * sizeof(int16_t));
+
+    atomic_store_explicit(&r->tail, tail + n, memory_order_release);
+    return n;
+}
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,103 @@
+//
+// session.c — decoder context carryover (see session.h)
+//
+
+#include "session.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "native_log.h"
+#include "timings.h"
+
+struct transcribe_session {
+    whisper_token *tokens;     // [initial prompt | carried tokens], max_tokens long
+    int            max_tokens;
+    int            n_initial;
+    int            n_carried;
+
+    int            last_prompt_tokens;
+    float          last_prefill_ms;
+};
+
+struct transcribe_session *transcribe_session_create(struct whisper_context *ctx,
+                                                     const char *initial_prompt,
+                                                     int max_prompt_tokens) {
+    if (!ctx || max_prompt_tokens <= 0) return NULL;
+    const int limit = whisper_n_text_ctx(ctx) / 2;
+    if (max_prompt_tokens > limit) max_prompt_tokens = limit;
+
+    struct transcribe_session *s = (struct transcribe_session *)calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    s->tokens = (whisper_token *)malloc((size_t)max_prompt_tokens * sizeof(whisper_token));
+    if (!s->tokens) { free(s); return NULL; }
+    s->max_tokens = max_prompt_tokens;
+
+    if (initial_prompt && initial_prompt[0] != '\0') {
+        const int n = whisper_tokenize(ctx, initial_prompt, s->tokens, s->max_tokens);
+        if (n < 0) {
+            // Too long for the cap: keep it out rather than cut a phrase in half.
+            LOGW("session: initial prompt needs %d tokens, cap is %d; ignored", -n, s->max_tokens);
+        } else {
+            s->n_initial = n;
+        }
+    }
+    return s;
+}
+
+void transcribe_session_free(struct transcribe_session *s) {
+    if (!s) return;
+    free(s->tokens);
+    free(s);
+}
+
+void transcribe_session_reset(struct transcribe_session *s) {
+    if (!s) return;
+    s->n_carried = 0;
+}
+
+void transcribe_session_apply(const struct transcribe_session *s, struct whisper_full_params *p) {
+    if (!s || !p) return;
+    const int n = s->n_initial + s->n_carried;
+    p->prompt_tokens   = n > 0 ? s->tokens : NULL;
+    p->prompt_n_tokens = n;
+}
+
+void transcribe_session_commit(struct transcribe_session *s, struct whisper_context *ctx) {
+    if (!s || !ctx) return;
+
+    struct whisper_timings t;
+    whisper_timings_read(ctx, &t);
+    s->last_prompt_tokens = s->n_initial + s->n_carried;
+    s->last_prefill_ms = t.prompt_ms;
+
+    const int room = s->max_tokens - s->n_initial;
+    if (room <= 0) return;
+    whisper_token *carry = s->tokens + s->n_initial;
+
+    // Text tokens only: everything from EOT up is special (SOT, language, timestamps...).
+    const whisper_token eot = whisper_token_eot(ctx);
+    const int n_segments = whisper_full_n_segments(ctx);
+    for (int i = 0; i < n_segments; ++i) {
+        const int n_tokens = whisper_full_n_tokens(ctx, i);
+        for (int j = 0; j < n_tokens; ++j) {
+            const whisper_token id = whisper_full_get_token_id(ctx, i, j);
+            if (id >= eot) continue;
+            if (s->n_carried == room) {
+                // Window full: drop the oldest token.
+                memmove(carry, carry + 1, (size_t)(room - 1) * sizeof(whisper_token));
+                s->n_carried--;
+            }
+            carry[s->n_carried++] = id;
+        }
+    }
+}
+
+void transcribe_session_stats(const struct transcribe_session *s, struct transcribe_session_stats *out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!s) return;
+    out->prompt_tokens  = s->last_prompt_tokens;
+    out->prefill_ms     = s->last_prefill_ms;
+    out->carried_tokens = s->n_carried;
+}
@@ -0,0 +1,55 @@
+//
+// session.h — decoder context carried across consecutive transcriptions
+//
+// A session keeps a short rolling window of the text tokens of previous
+// results (plus an optional initial prompt, tokenized once) and hands them to
+// the next whisper_full as prompt tokens. Consecutive recordings then decode
+// with their predecessor's vocabulary in context instead of starting cold.
+//
+// Not thread-safe: use a session from one thread at a time, together with the
+// whisper_context it was created for.
+//
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "whisper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct transcribe_session;
+
+// Decoder prompt cost of the last run (see transcribe_session_commit).
+struct transcribe_session_stats {
+    int   prompt_tokens;   // prompt tokens fed to the decoder
+    float prefill_ms;      // decoder time spent on the prompt (KV prefill)
+    int   carried_tokens;  // tokens currently carried into the next run
+};
+
+// max_prompt_tokens caps initial prompt + carried tokens (clamped to half the
+// text context, whisper's own limit). initial_prompt may be NULL.
+struct transcribe_session *transcribe_session_create(struct whisper_context *ctx,
+                                                     const char *initial_prompt,
+                                                     int max_prompt_tokens);
+void transcribe_session_free(struct transcribe_session *s);
+
+// Forget carried tokens; the initial prompt stays.
+void transcribe_session_reset(struct transcribe_session *s);
+
+// Point p->prompt_tokens at the cached prompt. p->no_context should stay true:
+// the session, not whisper's internal history, decides what is carried.
+void transcribe_session_apply(const struct transcribe_session *s, struct whisper_full_params *p);
+
+// After a successful whisper_full: append the result's text tokens to the
+// carried window and record the prompt prefill timing of that run.
+void transcribe_session_commit(struct transcribe_session *s, struct whisper_context *ctx);
+
+void transcribe_session_stats(const struct transcribe_session *s, struct transcribe_session_stats *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SESSION_H
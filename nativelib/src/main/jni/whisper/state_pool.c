@@ -0,0 +1,117 @@
+//
+// state_pool.c — several whisper_states of one context (see state_pool.h)
+//
+
+#include "state_pool.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "native_log.h"
+
+struct state_pool {
+    struct whisper_context *ctx;
+    struct whisper_state  **states;
+    int                     n_states;
+};
+
+struct pool_run {
+    struct state_pool *pool;
+    state_pool_job     job;
+    void              *user;
+    int                n_jobs;
+    int                n_threads;  // per worker
+    atomic_int         next;
+};
+
+struct pool_worker {
+    struct pool_run      *run;
+    struct whisper_state *state;
+    pthread_t             thread;
+};
+
+struct state_pool *state_pool_create(struct whisper_context *ctx, int n_states) {
+    if (!ctx || n_states <= 0) return NULL;
+    struct state_pool *pool = (struct state_pool *)calloc(1, sizeof(*pool));
+    if (!pool) return NULL;
+    pool->ctx = ctx;
+    pool->states = (struct whisper_state **)calloc((size_t)n_states, sizeof(*pool->states));
+    if (!pool->states) { free(pool); return NULL; }
+
+    for (int i = 0; i < n_states; ++i) {
+        pool->states[i] = whisper_init_state(ctx);
+        if (!pool->states[i]) {
+            // Keep what fits: fewer states still work.
+            LOGW("state_pool: only %d of %d states allocated", i, n_states);
+            break;
+        }
+        pool->n_states++;
+    }
+    if (pool->n_states == 0) {
+        state_pool_free(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void state_pool_free(struct state_pool *pool) {
+    if (!pool) return;
+    for (int i = 0; i < pool->n_states; ++i) whisper_free_state(pool->states[i]);
+    free(pool->states);
+    free(pool);
+}
+
+int state_pool_size(const struct state_pool *pool) {
+    return pool ? pool->n_states : 0;
+}
+
+struct whisper_context *state_pool_context(const struct state_pool *pool) {
+    return pool ? pool->ctx : NULL;
+}
+
+static void *worker_main(void *arg) {
+    struct pool_worker *w = (struct pool_worker *)arg;
+    struct pool_run *run = w->run;
+    for (;;) {
+        const int i = atomic_fetch_add(&run->next, 1);
+        if (i >= run->n_jobs) break;
+        run->job(run->user, w->state, i, run->n_threads);
+    }
+    return NULL;
+}
+
+void state_pool_run(struct state_pool *pool, int n_jobs, int n_threads, state_pool_job job, void *user) {
+    if (!pool || !job || n_jobs <= 0) return;
+
+    const int n_workers = pool->n_states < n_jobs ? pool->n_states : n_jobs;
+    struct pool_run run = {
+        .pool = pool, .job = job, .user = user, .n_jobs = n_jobs,
+        .n_threads = n_threads / n_workers > 0 ? n_threads / n_workers : 1,
+    };
+    atomic_init(&run.next, 0);
+
+    struct pool_worker *workers = (struct pool_worker *)calloc((size_t)n_workers, sizeof(*workers));
+    if (!workers) {
+        // No memory for worker bookkeeping: run everything here on state 0.
+        struct pool_worker self = { .run = &run, .state = pool->states[0] };
+        run.n_threads = n_threads > 0 ? n_threads : 1;
+        worker_main(&self);
+        return;
+    }
+    int started = 1;  // worker 0 runs on the calling thread
+    for (int i = 0; i < n_workers; ++i) {
+        workers[i].run = &run;
+        workers[i].state = pool->states[i];
+    }
+    for (int i = 1; i < n_workers; ++i) {
+        if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+            LOGW("state_pool: pthread_create failed, running %d workers", started);
+            break;
+        }
+        started++;
+    }
+    worker_main(&workers[0]);
+    for (int i = 1; i < started; ++i) pthread_join(workers[i].thread, NULL);
+    free(workers);
+}
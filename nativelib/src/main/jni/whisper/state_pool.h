@@ -0,0 +1,42 @@
+//
+// state_pool.h — several whisper_states of one context, run side by side
+//
+// One encoder pass is a single ggml graph; its small per-window matmuls leave
+// cores idle on a phone. A pool runs independent windows (packed clip
+// batches, other streams) on separate states at the same time, splitting the
+// thread budget between them, so more windows are in flight per second.
+//
+// Every state carries its own KV caches and compute buffers; size the pool to
+// the memory budget (2 is a good default on phones).
+//
+
+#ifndef STATE_POOL_H
+#define STATE_POOL_H
+
+#include <stdbool.h>
+
+#include "whisper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct state_pool;
+
+struct state_pool *state_pool_create(struct whisper_context *ctx, int n_states);
+void state_pool_free(struct state_pool *pool);
+
+int state_pool_size(const struct state_pool *pool);
+struct whisper_context *state_pool_context(const struct state_pool *pool);
+
+// Runs job(user, state, index, n_threads) for index 0..n_jobs-1. One worker
+// per state pulls indices in order; n_threads is the caller's thread budget
+// divided between the workers that run. Returns once every job has finished.
+typedef void (*state_pool_job)(void *user, struct whisper_state *state, int index, int n_threads);
+void state_pool_run(struct state_pool *pool, int n_jobs, int n_threads, state_pool_job job, void *user);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STATE_POOL_H
@@ -0,0 +1,18 @@
+//
+// timings.cpp — C-callable copy of whisper_get_timings() (see timings.h)
+//
+
+#include "timings.h"
+
+#include <cstring>
+
+bool whisper_timings_read(struct whisper_context *ctx, struct whisper_timings *out) {
+    if (!out) return false;
+    std::memset(out, 0, sizeof(*out));
+    if (!ctx) return false;
+    whisper_timings *t = whisper_get_timings(ctx);
+    if (!t) return false;
+    *out = *t;
+    delete t;
+    return true;
+}
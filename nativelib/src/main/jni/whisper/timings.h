@@ -0,0 +1,28 @@
+//
+// timings.h — whisper_get_timings() without the ownership problem
+//
+// whisper_get_timings() returns a struct allocated with C++ new, which C code
+// can't release correctly (free() on it is undefined behaviour). This shim
+// copies the figures out and deletes the original on the C++ side.
+//
+
+#ifndef TIMINGS_H
+#define TIMINGS_H
+
+#include <stdbool.h>
+
+#include "whisper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Copies the timings of ctx's last run into *out. False (and *out zeroed) if
+// whisper.cpp has none, e.g. no state yet.
+bool whisper_timings_read(struct whisper_context *ctx, struct whisper_timings *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TIMINGS_H
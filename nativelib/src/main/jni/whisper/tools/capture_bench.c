@@ -0,0 +1,134 @@
+//
+// capture_bench.c — host driver for the capture -> transcription pipeline
+//
+// Runs the same capture session the app uses (file/stdin backend instead of
+// AAudio), then transcribes the captured pcm_buffer and reports:
+//   - stop -> text latency (what the user waits for after pressing stop)
+//   - real-time factor of the transcription
+//   - ring drops / high-water mark
+//   - decoder loops cut by the loop guard
+//
+// --endpoint stops at the detected end of speech instead of end of input,
+// which is what hands-free dictation does (use with --realtime).
+//
+// Usage:
+//   capture_bench -m model.bin -f input.wav [--realtime] [--endpoint] [-t 4] [-l ja] [-o out.wav]
+//   arecord -f S16_LE -r 16000 -c 1 -t raw | capture_bench -m model.bin -f - -r 16000 --realtime
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "capture.h"
+#include "loop_guard.h"
+#include "native_log.h"
+#include "pcm_buffer.h"
+#include "whisper.h"
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s -m MODEL -f FILE|- [-r RAW_RATE] [--realtime] [--endpoint] [-t THREADS] [-l LANG] [-o OUT.wav]\n",
+            argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *model = NULL, *input = NULL, *lang = "auto", *wav_out = NULL;
+    int raw_rate = 16000, threads = 4;
+    bool realtime = false, endpoint = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const bool has_val = i + 1 < argc;
+        if      (!strcmp(a, "-m") && has_val) model = argv[++i];
+        else if (!strcmp(a, "-f") && has_val) input = argv[++i];
+        else if (!strcmp(a, "-r") && has_val) raw_rate = atoi(argv[++i]);
+        else if (!strcmp(a, "-t") && has_val) threads = atoi(argv[++i]);
+        else if (!strcmp(a, "-l") && has_val) lang = argv[++i];
+        else if (!strcmp(a, "-o") && has_val) wav_out = argv[++i];
+        else if (!strcmp(a, "--realtime"))    realtime = true;
+        else if (!strcmp(a, "--endpoint"))    endpoint = true;
+        else { usage(argv[0]); return 2; }
+    }
+    if (!model || !input) { usage(argv[0]); return 2; }
+
+    struct whisper_context *ctx =
+            whisper_init_from_file_with_params(model, whisper_context_default_params());
+    if (!ctx) { LOGE("failed to load model %s", model); return 1; }
+
+    struct capture_engine *engine = capture_open_file(input, raw_rate, realtime, 2000);
+    if (!engine) { whisper_free(ctx); return 1; }
+    const int rate = capture_sample_rate(engine);
+
+    const double t_capture = now_ms();
+    struct endpoint_config ep_cfg;
+    endpoint_config_default(&ep_cfg);
+    struct capture_session *session = capture_session_start(engine, wav_out, 0, endpoint ? &ep_cfg : NULL);
+    if (!session) { whisper_free(ctx); return 1; }
+
+    const bool endpoint_hit = endpoint && capture_session_wait_endpoint(session, -1);
+    if (!endpoint_hit) capture_session_wait_source(session);
+
+    // "Stop" — everything from here is latency the user sees.
+    const double t_stop = now_ms();
+    bool wav_ok = false;
+    struct capture_stats st;
+    struct pcm_buffer *pcm = capture_session_stop(session, &wav_ok);
+    capture_session_stats(session, &st);
+    capture_session_free(session);
+    const double t_drained = now_ms();
+
+    int n = 0;
+    float *samples = pcm ? pcm_buffer_to_f32(pcm, 0, &n) : NULL;
+    pcm_buffer_free(pcm);
+    if (!samples) { LOGE("no audio captured"); whisper_free(ctx); return 1; }
+    const double t_converted = now_ms();
+
+    struct whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.n_threads        = threads;
+    params.language         = lang;
+    params.detect_language  = false;   // "auto" detects and transcribes; true would stop after detection
+    params.no_context       = true;
+    params.print_progress   = false;
+    params.print_realtime   = false;
+    params.print_timestamps = false;
+    loop_guard_apply(&params);           // as in the app
+
+    const int rc = whisper_full(ctx, params, samples, n);
+    const double t_text = now_ms();
+    free(samples);
+    if (rc != 0) { LOGE("whisper_full failed (%d)", rc); whisper_free(ctx); return 1; }
+
+    for (int i = 0; i < whisper_full_n_segments(ctx); i++) {
+        printf("%s", whisper_full_get_segment_text(ctx, i));
+    }
+    printf("\n");
+
+    const double audio_ms = (double)n * 1000.0 / WHISPER_SAMPLE_RATE;
+    fprintf(stderr, "\n");
+    fprintf(stderr, "input        : %s (%d Hz%s)\n", input, rate, realtime ? ", realtime" : "");
+    fprintf(stderr, "audio        : %.0f ms captured in %.0f ms%s\n", audio_ms, t_stop - t_capture,
+            endpoint_hit ? " (stopped by endpoint)" : "");
+    fprintf(stderr, "ring         : produced=%llu dropped=%llu peak=%zu/%d ms\n",
+            (unsigned long long)st.produced, (unsigned long long)st.dropped,
+            st.ring_peak, (int)((double)st.ring_peak * 1000.0 / rate));
+    fprintf(stderr, "wav          : %s\n", wav_out ? (wav_ok ? wav_out : "FAILED") : "(none)");
+    fprintf(stderr, "stop->drain  : %8.2f ms\n", t_drained - t_stop);
+    fprintf(stderr, "to_f32       : %8.2f ms\n", t_converted - t_drained);
+    fprintf(stderr, "whisper_full : %8.2f ms (RTF %.3f)\n", t_text - t_converted,
+            audio_ms > 0 ? (t_text - t_converted) / audio_ms : 0.0);
+    fprintf(stderr, "stop->text   : %8.2f ms\n", t_text - t_stop);
+    struct loop_guard_stats lg;
+    loop_guard_totals(&lg);
+    fprintf(stderr, "loop guard   : %d repeats, %d stalls, %d low variety\n", lg.repeats, lg.stalls, lg.low_variety);
+
+    whisper_free(ctx);
+    return 0;
+}
@@ -0,0 +1,147 @@
+//
+// encode_bench.c — encoder throughput: B windows side by side vs one at a time
+//
+// Encodes N synthetic 30 s windows (encoder cost does not depend on content)
+//   - sequentially on one state with all T threads, and
+//   - on a pool of B states, B windows in flight with T/B threads each,
+// and reports windows per second for both. Run on x86_64 and arm64 hosts to
+// pick the pool size for a CPU class.
+//
+// With -H, the sequential run is repeated after the model's mappings were
+// moved to huge pages (see hugepages.h; -L also mlocks them). The first runs
+// then have THP switched off for the process (Linux), so the two sequential
+// lines compare 4 KB pages against what huge pages the kernel gave.
+//
+// Usage:
+//   encode_bench -m model.bin [-b 2] [-t 4] [-n 8] [-H [-L]]
+//
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#include "hugepages.h"
+#include "native_log.h"
+#include "state_pool.h"
+#include "whisper.h"
+
+#define WINDOW_SAMPLES (WHISPER_SAMPLE_RATE * 30)
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+struct bench {
+    struct whisper_context *ctx;
+    const float *audio;
+    atomic_int failures;
+};
+
+static void encode_window(void *user, struct whisper_state *state, int index, int n_threads) {
+    (void)index;
+    struct bench *b = (struct bench *)user;
+    if (whisper_pcm_to_mel_with_state(b->ctx, state, b->audio, WINDOW_SAMPLES, n_threads) != 0 ||
+        whisper_encode_with_state(b->ctx, state, 0, n_threads) != 0) {
+        atomic_fetch_add(&b->failures, 1);
+    }
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s -m MODEL [-b STATES] [-t THREADS] [-n WINDOWS] [-H [-L]]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *model = NULL;
+    int states = 2, threads = 4, windows = 8;
+    bool huge = false, lock = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        const bool has_val = i + 1 < argc;
+        if      (!strcmp(a, "-m") && has_val) model = argv[++i];
+        else if (!strcmp(a, "-b") && has_val) states = atoi(argv[++i]);
+        else if (!strcmp(a, "-t") && has_val) threads = atoi(argv[++i]);
+        else if (!strcmp(a, "-n") && has_val) windows = atoi(argv[++i]);
+        else if (!strcmp(a, "-H")) huge = true;
+        else if (!strcmp(a, "-L")) lock = true;
+        else { usage(argv[0]); return 2; }
+    }
+    if (!model || states < 1 || threads < 1 || windows < 1) { usage(argv[0]); return 2; }
+
+    struct mem_snapshot *before = NULL;
+    if (huge) {
+#ifdef __linux__
+        prctl(PR_SET_THP_DISABLE, 1, 0, 0, 0);  // baseline in 4 KB pages
+#endif
+        before = mem_snapshot_take();
+    }
+
+    struct whisper_context *ctx =
+            whisper_init_from_file_with_params_no_state(model, whisper_context_default_params());
+    if (!ctx) { LOGE("failed to load model %s", model); return 1; }
+
+    float *audio = (float *)malloc(WINDOW_SAMPLES * sizeof(float));
+    struct state_pool *single = state_pool_create(ctx, 1);
+    struct state_pool *pool = state_pool_create(ctx, states);
+    if (!audio || !single || !pool) { LOGE("out of memory"); return 1; }
+    srand(1);
+    for (int i = 0; i < WINDOW_SAMPLES; i++) audio[i] = ((float)rand() / (float)RAND_MAX - 0.5f) * 0.1f;
+
+    struct bench b = { .ctx = ctx, .audio = audio };
+    atomic_init(&b.failures, 0);
+
+    // Warm-up: first graph allocation and page faults are not throughput.
+    state_pool_run(pool, state_pool_size(pool), threads, encode_window, &b);
+
+    double t0 = now_ms();
+    state_pool_run(single, windows, threads, encode_window, &b);
+    const double seq_ms = now_ms() - t0;
+
+    t0 = now_ms();
+    state_pool_run(pool, windows, threads, encode_window, &b);
+    const double par_ms = now_ms() - t0;
+
+    double huge_ms = 0.0;
+    struct hugepage_report rep = { 0 };
+    if (huge) {
+#ifdef __linux__
+        prctl(PR_SET_THP_DISABLE, 0, 0, 0, 0);
+#endif
+        if (!hugepages_apply(before, ctx, true, lock, &rep)) LOGW("can't read the process mappings");
+        state_pool_run(single, 1, threads, encode_window, &b);  // settle after the collapse
+        t0 = now_ms();
+        state_pool_run(single, windows, threads, encode_window, &b);
+        huge_ms = now_ms() - t0;
+        mem_snapshot_free(before);
+    }
+
+    if (atomic_load(&b.failures)) LOGW("%d encoder runs failed", atomic_load(&b.failures));
+
+    const int got = state_pool_size(pool);
+    printf("system       : %s\n", whisper_print_system_info());
+    printf("windows      : %d x 30 s, %d threads\n", windows, threads);
+    printf("sequential   : %8.1f ms  %6.2f windows/s\n", seq_ms, windows * 1000.0 / seq_ms);
+    printf("pool (B=%d)   : %8.1f ms  %6.2f windows/s  (%d threads each, x%.2f)\n",
+           got, par_ms, windows * 1000.0 / par_ms, threads / got > 0 ? threads / got : 1, seq_ms / par_ms);
+    if (huge) {
+        printf("huge pages   : %8.1f ms  %6.2f windows/s  (x%.2f; %lld of %lld MB huge, %lld MB locked, THP %s)\n",
+               huge_ms, windows * 1000.0 / huge_ms, seq_ms / huge_ms, (long long)(rep.huge_bytes >> 20),
+               (long long)(rep.bytes >> 20), (long long)(rep.locked_bytes >> 20),
+               rep.thp == THP_ALWAYS ? "always" : rep.thp == THP_MADVISE ? "madvise" : "off");
+    }
+
+    hugepages_release(ctx);
+    state_pool_free(pool);
+    state_pool_free(single);
+    free(audio);
+    whisper_free(ctx);
+    return 0;
+}
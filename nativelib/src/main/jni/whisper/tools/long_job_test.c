@@ -0,0 +1,271 @@
+//
+// long_job_test.c — host test for the long-job journal (see long_job.h)
+//
+// Replays truncated and corrupted journals through the journal code of
+// long_job.c and checks what a resume would make of them:
+//   - torn writes (a last line without its newline) are cut back to the last
+//     checkpoint, and the file is truncated there
+//   - segment text with tabs, newlines and backslashes survives the escaping
+//   - the prompt tail is cut at a UTF-8 character start
+//   - a journal of another recording, or with a broken header, starts over
+//
+// The journal functions are static, so the test includes long_job.c itself.
+//
+// Usage:
+//   long_job_test [DIR]    (journals are written to DIR, default /tmp)
+//
+
+#include "../long_job.c"
+
+#include <stdarg.h>
+
+static int failures;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); failures++; } \
+    } while (0)
+
+static const struct wav_info k_info = { .sample_rate = 16000, .channels = 1, .data_offset = 80, .frames = 1600000 };
+
+static char g_journal[512];
+
+static void write_journal(const char *fmt, ...) {
+    FILE *f = fopen(g_journal, "w");
+    if (!f) { perror(g_journal); exit(1); }
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(f, fmt, ap);
+    va_end(ap);
+    fclose(f);
+}
+
+// Whole journal as a string (malloc'd).
+static char *read_journal(void) {
+    FILE *f = fopen(g_journal, "r");
+    if (!f) return strdup("");
+    char *buf = calloc(1, 1 << 16);
+    fread(buf, 1, (1 << 16) - 1, f);
+    fclose(f);
+    return buf;
+}
+
+struct opened {
+    int64_t resume_ms;
+    bool    done;
+    int     segments;
+    int     resumes;
+    char    tail[JOB_PROMPT_BYTES + 1];
+    char   *file;   // journal contents after journal_open closed
+};
+
+// journal_open on the current journal, then append marker (if any) where a
+// resumed run would continue writing.
+static bool open_journal(struct opened *o, const char *marker) {
+    memset(o, 0, sizeof(*o));
+    struct long_job *job = long_job_create("unused.wav", g_journal);
+    FILE *f = journal_open(job, &k_info, &o->resume_ms, &o->done, o->tail);
+    if (f) {
+        if (marker) fputs(marker, f);
+        fclose(f);
+    }
+    o->segments = atomic_load(&job->segments);
+    o->resumes = atomic_load(&job->resumes);
+    long_job_free(job);
+    o->file = read_journal();
+    return f != NULL;
+}
+
+#define HEADER "WJ1\t1600000\t16000\n"
+
+static void test_escaping(void) {
+    const char *text = "tab\there, line\nbreak, back\\slash, \\t literal";
+    char path[600];
+    snprintf(path, sizeof(path), "%s.esc", g_journal);
+    FILE *f = fopen(path, "w+");
+    CHECK(f != NULL);
+    if (!f) return;
+    put_escaped(f, text);
+    fputc('\n', f);
+    rewind(f);
+    char line[256] = "";
+    CHECK(fgets(line, sizeof(line), f) != NULL);
+    fclose(f);
+    remove(path);
+
+    // One line, no raw tab: the record stays parseable.
+    CHECK(strchr(line, '\t') == NULL);
+    CHECK(strchr(line, '\n') == line + strlen(line) - 1);
+    line[strlen(line) - 1] = '\0';
+    unescape(line);
+    CHECK(strcmp(line, text) == 0);
+
+    // A lone backslash at the end (a cut line) is kept as is.
+    char cut[] = "end\\";
+    unescape(cut);
+    CHECK(strcmp(cut, "end\\") == 0);
+}
+
+static bool utf8_start(const char *s) {
+    return (*s & 0xC0) != 0x80;
+}
+
+static void test_tail(void) {
+    char tail[JOB_PROMPT_BYTES + 1] = "";
+    tail_append(tail, "Hello ");
+    tail_append(tail, "world.");
+    CHECK(strcmp(tail, "Hello world.") == 0);
+
+    // "あ" is 3 bytes: 100 of them (300 bytes) can't end on the limit evenly.
+    char big[301] = "";
+    for (int i = 0; i < 100; ++i) strcat(big, "\xe3\x81\x82");
+    tail[0] = '\0';
+    tail_append(tail, "x");
+    tail_append(tail, big);
+    CHECK(strlen(tail) <= JOB_PROMPT_BYTES);
+    CHECK(strlen(tail) % 3 == 0);
+    CHECK(utf8_start(tail));
+    CHECK(strcmp(tail, big + strlen(big) - strlen(tail)) == 0);
+
+    // Cut in the old tail, not the new text.
+    tail[0] = '\0';
+    tail_append(tail, big);
+    tail_append(tail, "abc");
+    CHECK(utf8_start(tail));
+    CHECK(strlen(tail) <= JOB_PROMPT_BYTES);
+    CHECK(strcmp(tail + strlen(tail) - 3, "abc") == 0);
+}
+
+static void test_new_journal(void) {
+    remove(g_journal);
+    struct opened o;
+    CHECK(open_journal(&o, NULL));
+    CHECK(o.resume_ms == 0 && !o.done && o.segments == 0 && o.resumes == 0);
+    CHECK(strcmp(o.file, HEADER) == 0);
+    free(o.file);
+}
+
+static void test_torn_write(void) {
+    // Two checkpoints, a segment after them and a torn segment line.
+    write_journal(HEADER
+                  "S\t0\t1000\tOne.\n"
+                  "C\t30000\n"
+                  "S\t30000\t31000\tTwo.\n"
+                  "C\t60000\n"
+                  "S\t60000\t61000\tPending.\n"
+                  "S\t61000\t62");
+    struct opened o;
+    CHECK(open_journal(&o, "M\n"));
+    CHECK(o.resume_ms == 60000);
+    CHECK(!o.done);
+    CHECK(o.segments == 2);
+    CHECK(o.resumes == 1);
+    CHECK(strcmp(o.tail, "One.Two.") == 0);
+    // Everything after the last checkpoint is gone; writing continues there.
+    CHECK(strcmp(o.file, HEADER "S\t0\t1000\tOne.\nC\t30000\nS\t30000\t31000\tTwo.\nC\t60000\nM\n") == 0);
+    free(o.file);
+
+    // Torn in the middle of a checkpoint line: the one before counts.
+    write_journal(HEADER "S\t0\t1000\tOne.\nC\t30000\nS\t30000\t31000\tTwo.\nC\t600");
+    CHECK(open_journal(&o, NULL));
+    CHECK(o.resume_ms == 30000 && o.segments == 1);
+    CHECK(strcmp(o.tail, "One.") == 0);
+    CHECK(strcmp(o.file, HEADER "S\t0\t1000\tOne.\nC\t30000\n") == 0);
+    free(o.file);
+
+    // Nothing checkpointed yet: back to the header, no resume counted.
+    write_journal(HEADER "S\t0\t1000\tOne.\nS\t1000\t2");
+    CHECK(open_journal(&o, NULL));
+    CHECK(o.resume_ms == 0 && o.segments == 0 && o.resumes == 0 && o.tail[0] == '\0');
+    CHECK(strcmp(o.file, HEADER) == 0);
+    free(o.file);
+}
+
+static void test_corrupted(void) {
+    // An unknown record and a segment without text end the journal at the
+    // checkpoint before them, like a torn write.
+    write_journal(HEADER "S\t0\t1000\tOne.\nC\t30000\nX garbage\nS\t30000\t31000\tTwo.\nC\t60000\n");
+    struct opened o;
+    CHECK(open_journal(&o, NULL));
+    CHECK(o.resume_ms == 30000 && o.segments == 1);
+    CHECK(strcmp(o.file, HEADER "S\t0\t1000\tOne.\nC\t30000\n") == 0);
+    free(o.file);
+
+    write_journal(HEADER "S\t0\t1000\tOne.\nC\t30000\nS\t30000\nC\t60000\n");
+    CHECK(open_journal(&o, NULL));
+    CHECK(o.resume_ms == 30000 && o.segments == 1);
+    free(o.file);
+
+    // A finished job stays finished.
+    write_journal(HEADER "S\t0\t1000\tOne.\nC\t30000\nD\n");
+    CHECK(open_journal(&o, NULL));
+    CHECK(o.done && o.resume_ms == 30000 && o.resumes == 0);
+    CHECK(strcmp(o.file, HEADER "S\t0\t1000\tOne.\nC\t30000\nD\n") == 0);
+    free(o.file);
+}
+
+static void test_escaped_segments(void) {
+    write_journal(HEADER "S\t0\t1000\ta\\tb\\nc\\\\d\nC\t30000\n");
+    struct opened o;
+    CHECK(open_journal(&o, NULL));
+    CHECK(o.resume_ms == 30000);
+    CHECK(strcmp(o.tail, "a\tb\nc\\d") == 0);
+    free(o.file);
+}
+
+static void test_utf8_tail_on_resume(void) {
+    // Committed text longer than the prompt tail, in 3-byte characters.
+    char text[301] = "";
+    for (int i = 0; i < 100; ++i) strcat(text, "\xe3\x81\x82");
+    write_journal(HEADER "S\t0\t1000\t%s\nS\t1000\t2000\t%s\nC\t30000\n", text, text);
+    struct opened o;
+    CHECK(open_journal(&o, NULL));
+    CHECK(o.resume_ms == 30000 && o.segments == 2);
+    CHECK(strlen(o.tail) > 0 && strlen(o.tail) <= JOB_PROMPT_BYTES);
+    CHECK(strlen(o.tail) % 3 == 0);
+    CHECK(utf8_start(o.tail));
+    free(o.file);
+}
+
+static void test_other_recording(void) {
+    // Another frame count: the journal belongs to a different file.
+    write_journal("WJ1\t999\t16000\nS\t0\t1000\tOne.\nC\t30000\n");
+    struct opened o;
+    CHECK(open_journal(&o, NULL));
+    CHECK(o.resume_ms == 0 && o.segments == 0 && o.tail[0] == '\0');
+    CHECK(strcmp(o.file, HEADER) == 0);
+    free(o.file);
+
+    // Torn header.
+    write_journal("WJ1\t1600");
+    CHECK(open_journal(&o, NULL));
+    CHECK(o.resume_ms == 0 && strcmp(o.file, HEADER) == 0);
+    free(o.file);
+
+    // Empty file.
+    write_journal("%s", "");
+    CHECK(open_journal(&o, NULL));
+    CHECK(strcmp(o.file, HEADER) == 0);
+    free(o.file);
+}
+
+int main(int argc, char **argv) {
+    snprintf(g_journal, sizeof(g_journal), "%s/long_job_test.%d.journal", argc > 1 ? argv[1] : "/tmp",
+             (int)getpid());
+
+    test_escaping();
+    test_tail();
+    test_new_journal();
+    test_torn_write();
+    test_corrupted();
+    test_escaped_segments();
+    test_utf8_tail_on_resume();
+    test_other_recording();
+
+    remove(g_journal);
+    if (failures) {
+        fprintf(stderr, "long_job_test: %d checks failed\n", failures);
+        return 1;
+    }
+    printf("long_job_test: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,88 @@
+//
+// warmup.c — synthetic warm-up passes over a new context (see warmup.h)
+//
+
+#include "warmup.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "clip_pack.h"
+#include "native_log.h"
+
+#define WARMUP_RATE     16000
+#define WARMUP_MAX_MS   30000
+
+static const int k_default_clips[] = { 2000, 10000, WARMUP_MAX_MS };
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+// One encode at the clip's bucket and a single decoder step; -1 on failure.
+static double pass(struct whisper_context *ctx, int n_threads, const float *pcm, int clip_ms) {
+    if (clip_ms <= 0) clip_ms = 1000;
+    if (clip_ms > WARMUP_MAX_MS) clip_ms = WARMUP_MAX_MS;
+    const int n = clip_ms * (WARMUP_RATE / 1000);
+
+    struct whisper_full_params p = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    p.n_threads = n_threads > 0 ? n_threads : 1;
+    p.language = "en";            // no language detection pass
+    p.no_context = true;
+    p.no_timestamps = true;
+    p.single_segment = true;
+    p.max_tokens = 1;
+    p.temperature_inc = 0.0f;     // no fallback re-decodes on silence
+    p.print_realtime = false;
+    p.print_progress = false;
+    p.print_timestamps = false;
+    p.print_special = false;
+    p.audio_ctx = clip_pack_audio_ctx(ctx, n);
+
+    const double t0 = now_ms();
+    if (whisper_full(ctx, p, pcm, n) != 0) {
+        LOGW("warmup: pass at %d ms failed", clip_ms);
+        return -1.0;
+    }
+    return now_ms() - t0;
+}
+
+bool warmup_run(struct whisper_context *ctx, int n_threads, const int *clip_ms, int n_clips,
+                struct warmup_report *out) {
+    out->cold_ms = out->warm_ms = out->total_ms = 0.0f;
+    out->passes = 0;
+    if (!ctx) return false;
+    if (!clip_ms || n_clips <= 0) {
+        clip_ms = k_default_clips;
+        n_clips = (int)(sizeof(k_default_clips) / sizeof(k_default_clips[0]));
+    }
+
+    float *pcm = calloc((size_t)WARMUP_MAX_MS * (WARMUP_RATE / 1000), sizeof(float));  // silence
+    if (!pcm) return false;
+
+    const double start = now_ms();
+    bool ok = true;
+    for (int i = 0; i < n_clips; ++i) {
+        const double ms = pass(ctx, n_threads, pcm, clip_ms[i]);
+        if (ms < 0) {
+            ok = false;
+            continue;
+        }
+        if (out->passes++ == 0) out->cold_ms = (float)ms;
+    }
+    const double warm = pass(ctx, n_threads, pcm, clip_ms[0]);
+    if (warm >= 0) {
+        out->warm_ms = (float)warm;
+        out->passes++;
+    } else {
+        ok = false;
+    }
+    out->total_ms = (float)(now_ms() - start);
+    free(pcm);
+
+    LOGI("warmup: %d passes in %.0f ms, first request %.0f ms cold -> %.0f ms warm", out->passes,
+         out->total_ms, out->cold_ms, out->warm_ms);
+    return ok;
+}
@@ -0,0 +1,49 @@
+//
+// warmup.h — bring a fresh context to steady-state latency
+//
+// The first run on a new context is much slower than the ones after it: the
+// weights are still untouched pages (faulted in as the first matmuls read
+// them), ggml builds each graph and its thread pool for the first time, and
+// the caches are cold. A warm-up runs a tiny synthetic transcription of
+// silence for each audio_ctx bucket the app will use (short clips run with a
+// shrunken encoder context, see clip_pack_audio_ctx), with the real thread
+// count, so that the first real request doesn't pay for any of that.
+//
+// whisper.cpp has no way to touch the weight buffers directly; a pass at the
+// model's full context reads every encoder weight, and one decoder step reads
+// every decoder weight (the token embedding included, as the output
+// projection), which prefaults them all.
+//
+// The report compares the first pass (what the first request would have
+// cost) with the same pass repeated once everything is warm.
+//
+
+#ifndef WARMUP_H
+#define WARMUP_H
+
+#include <stdbool.h>
+
+#include "whisper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct warmup_report {
+    float cold_ms;    // first pass
+    float warm_ms;    // the same pass, repeated at the end
+    float total_ms;   // the whole warm-up
+    int   passes;
+};
+
+// Clip lengths (ms, at most 30000) whose buckets to run, first one measured;
+// NULL or n_clips <= 0 runs 2 s, 10 s and a full window. False if a pass
+// failed (the context is still usable).
+bool warmup_run(struct whisper_context *ctx, int n_threads, const int *clip_ms, int n_clips,
+                struct warmup_report *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WARMUP_H
@@ -0,0 +1,154 @@
+//
+// wav_reader.c — mmapped range reads from WAV/RF64 files (see wav_reader.h)
+//
+
+// 64-bit file offsets on 32-bit ABIs too: recordings may pass 2/4 GB.
+#define _FILE_OFFSET_BITS 64
+
+#include "wav_reader.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "native_log.h"
+
+#define WAV_MAX_CHUNKS   64        // header chunks scanned before giving up
+#define WAV_APPEND_BATCH 16384     // mono samples converted per pcm_buffer_append
+
+static uint16_t get_le16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+static uint32_t get_le32(const uint8_t *p) { return (uint32_t)get_le16(p) | (uint32_t)get_le16(p + 2) << 16; }
+static uint64_t get_le64(const uint8_t *p) { return (uint64_t)get_le32(p) | (uint64_t)get_le32(p + 4) << 32; }
+
+static bool read_at(int fd, void *buf, size_t n, off_t at) {
+    uint8_t *p = (uint8_t *)buf;
+    while (n > 0) {
+        ssize_t r = pread(fd, p, n, at);
+        if (r <= 0) return false;
+        p += r; n -= (size_t)r; at += r;
+    }
+    return true;
+}
+
+static bool probe_fd(int fd, struct wav_info *out) {
+    struct stat st;
+    uint8_t h[12];
+    if (fstat(fd, &st) != 0 || !read_at(fd, h, sizeof(h), 0)) return false;
+    const bool rf64 = memcmp(h, "RF64", 4) == 0;
+    if ((!rf64 && memcmp(h, "RIFF", 4) != 0) || memcmp(h + 8, "WAVE", 4) != 0) return false;
+
+    uint64_t ds64_data = 0;
+    bool have_fmt = false;
+    int format = 0, bits = 0;
+    memset(out, 0, sizeof(*out));
+
+    off_t at = 12;
+    for (int i = 0; i < WAV_MAX_CHUNKS && at + 8 <= st.st_size; ++i) {
+        uint8_t c[8];
+        if (!read_at(fd, c, sizeof(c), at)) return false;
+        const uint32_t size = get_le32(c + 4);
+        const off_t body = at + 8;
+
+        if (memcmp(c, "ds64", 4) == 0 && size >= 24) {
+            uint8_t d[24];
+            if (!read_at(fd, d, sizeof(d), body)) return false;
+            ds64_data = get_le64(d + 8);
+        } else if (memcmp(c, "fmt ", 4) == 0 && size >= 16) {
+            uint8_t f[16];
+            if (!read_at(fd, f, sizeof(f), body)) return false;
+            format = get_le16(f);
+            out->channels = get_le16(f + 2);
+            out->sample_rate = (int)get_le32(f + 4);
+            bits = get_le16(f + 14);
+            have_fmt = true;
+        } else if (memcmp(c, "data", 4) == 0) {
+            if (!have_fmt) return false;
+            if (format != 1 || bits != 16 || out->channels < 1 || out->channels > 2 || out->sample_rate <= 0) {
+                LOGW("wav_reader: unsupported format %d, %d bits, %d channels", format, bits, out->channels);
+                return false;
+            }
+            // Sizes may be stale (interrupted recording) or placeholders
+            // (RF64): what is on disk is what can be read.
+            uint64_t bytes = rf64 && size == 0xFFFFFFFFu ? ds64_data : size;
+            const uint64_t on_disk = (uint64_t)st.st_size - (uint64_t)body;
+            if (bytes == 0 || bytes > on_disk) bytes = on_disk;
+            out->data_offset = (uint64_t)body;
+            out->frames = bytes / (uint64_t)(2 * out->channels);
+            return true;
+        }
+        at = body + size + (size & 1);
+    }
+    return false;
+}
+
+bool wav_reader_probe(const char *path, struct wav_info *out) {
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    const bool ok = probe_fd(fd, out);
+    close(fd);
+    return ok;
+}
+
+struct pcm_buffer *wav_reader_load_range(const char *path, int64_t start_ms, int64_t end_ms,
+                                         uint64_t *start_frame) {
+    if (!path || start_ms < 0 || end_ms <= start_ms) return NULL;
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { LOGW("wav_reader: can't open %s", path); return NULL; }
+
+    struct wav_info info;
+    if (!probe_fd(fd, &info)) {
+        LOGW("wav_reader: not a 16-bit PCM WAV: %s", path);
+        close(fd);
+        return NULL;
+    }
+
+    const uint64_t first = (uint64_t)start_ms * (uint64_t)info.sample_rate / 1000;
+    uint64_t last = (uint64_t)end_ms * (uint64_t)info.sample_rate / 1000;
+    if (last > info.frames) last = info.frames;
+    if (first >= last) {
+        close(fd);
+        return NULL;
+    }
+
+    // Map only the span (from the page holding its first byte).
+    const size_t frame_bytes = (size_t)(2 * info.channels);
+    const uint64_t from = info.data_offset + first * frame_bytes;
+    const uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    const uint64_t map_at = from - from % page;
+    const size_t map_len = (size_t)(from - map_at + (last - first) * frame_bytes);
+    uint8_t *map = mmap(NULL, map_len, PROT_READ, MAP_PRIVATE, fd, (off_t)map_at);
+    close(fd);
+    if (map == MAP_FAILED) { LOGW("wav_reader: mmap of %zu bytes failed", map_len); return NULL; }
+    madvise(map, map_len, MADV_SEQUENTIAL);
+
+    struct pcm_buffer *buf = pcm_buffer_create(info.sample_rate);
+    const int16_t *src = (const int16_t *)(const void *)(map + (from - map_at));
+    int16_t batch[WAV_APPEND_BATCH];
+    for (uint64_t done = 0, n = last - first; buf && done < n;) {
+        const size_t k = n - done < WAV_APPEND_BATCH ? (size_t)(n - done) : WAV_APPEND_BATCH;
+        bool ok;
+        if (info.channels == 1) {
+            ok = pcm_buffer_append(buf, src + done, k);
+        } else {
+            for (size_t i = 0; i < k; ++i) {
+                batch[i] = (int16_t)(((int)src[2 * (done + i)] + src[2 * (done + i) + 1]) / 2);
+            }
+            ok = pcm_buffer_append(buf, batch, k);
+        }
+        if (!ok) {
+            pcm_buffer_free(buf);
+            buf = NULL;
+        }
+        done += k;
+    }
+    munmap(map, map_len);
+
+    if (!buf) { LOGW("wav_reader: out of memory"); return NULL; }
+    if (start_frame) *start_frame = first;
+    LOGI("wav_reader: %llu frames from %lld ms at %d Hz (%d ch)", (unsigned long long)(last - first),
+         (long long)start_ms, info.sample_rate, info.channels);
+    return buf;
+}
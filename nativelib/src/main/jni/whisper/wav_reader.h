@@ -0,0 +1,43 @@
+//
+// wav_reader.h — random access into 16-bit PCM WAV/RF64 recordings
+//
+// Reading minute 42 of a long recording should not decode the 41 minutes
+// before it. A PCM WAV is its own sample index: the header gives the data
+// offset and frame size, so any span is one mmap of that span. The header is
+// parsed chunk by chunk (RIFF or RF64 with ds64, extra chunks skipped), and
+// a file cut short by an interrupted recording is read up to its real end.
+//
+
+#ifndef WAV_READER_H
+#define WAV_READER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pcm_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct wav_info {
+    int      sample_rate;
+    int      channels;      // 1 or 2
+    uint64_t data_offset;   // bytes from the start of the file
+    uint64_t frames;        // available, clamped to the file size
+};
+
+// Parse the header of path. False if it is not a 16-bit PCM mono/stereo WAV.
+bool wav_reader_probe(const char *path, struct wav_info *out);
+
+// Load frames [start_ms, end_ms) of path (end clamped to the file) into a new
+// buffer at the file's rate, downmixed to mono. *start_frame (if not NULL)
+// receives the first frame loaded. NULL if the span is empty or on failure.
+struct pcm_buffer *wav_reader_load_range(const char *path, int64_t start_ms, int64_t end_ms,
+                                         uint64_t *start_frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WAV_READER_H
@@ -0,0 +1,138 @@
+//
+// wav_writer.c — streaming WAV/RF64 writer (see wav_writer.h)
+//
+
+// 64-bit file offsets on 32-bit ABIs too: recordings may pass 2/4 GB.
+#define _FILE_OFFSET_BITS 64
+
+#include "wav_writer.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "native_log.h"
+
+#define WAV_STAGING_BYTES (256 * 1024)
+#define DS64_BYTES        28
+
+struct wav_writer {
+    int      fd;
+    int      sample_rate;
+    uint64_t data_bytes;   // includes staged bytes
+    size_t   staged;
+    bool     failed;
+    uint8_t  staging[WAV_STAGING_BYTES];
+};
+
+static void put_le16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put_le32(uint8_t *p, uint32_t v) { put_le16(p, (uint16_t)v); put_le16(p + 2, (uint16_t)(v >> 16)); }
+static void put_le64(uint8_t *p, uint64_t v) { put_le32(p, (uint32_t)v); put_le32(p + 4, (uint32_t)(v >> 32)); }
+
+static bool needs_rf64(const struct wav_writer *w) {
+    return w->data_bytes + WAV_WRITER_HEADER_BYTES - 8 > 0xFFFFFFFFull;
+}
+
+static bool write_all(int fd, const void *buf, size_t n, off_t at) {
+    const uint8_t *p = (const uint8_t *)buf;
+    while (n > 0) {
+        ssize_t r = (at >= 0) ? pwrite(fd, p, n, at) : write(fd, p, n);
+        if (r <= 0) return false;
+        p += r; n -= (size_t)r;
+        if (at >= 0) at += r;
+    }
+    return true;
+}
+
+// Positional rewrite of the whole header; the append offset is untouched.
+static bool write_header(struct wav_writer *w, bool rf64) {
+    uint8_t h[WAV_WRITER_HEADER_BYTES];
+    memset(h, 0, sizeof(h));
+    const uint64_t riff_size = w->data_bytes + WAV_WRITER_HEADER_BYTES - 8;
+
+    memcpy(h, rf64 ? "RF64" : "RIFF", 4);
+    put_le32(h + 4, rf64 ? 0xFFFFFFFFu : (uint32_t)riff_size);
+    memcpy(h + 8, "WAVE", 4);
+
+    memcpy(h + 12, rf64 ? "ds64" : "JUNK", 4);
+    put_le32(h + 16, DS64_BYTES);
+    if (rf64) {
+        put_le64(h + 20, riff_size);
+        put_le64(h + 28, w->data_bytes);
+        put_le64(h + 36, w->data_bytes / 2);      // sample count (mono, 16-bit)
+        put_le32(h + 44, 0);                      // no chunk size table
+    }
+
+    memcpy(h + 48, "fmt ", 4);
+    put_le32(h + 52, 16);
+    put_le16(h + 56, 1);                          // PCM
+    put_le16(h + 58, 1);                          // mono
+    put_le32(h + 60, (uint32_t)w->sample_rate);
+    put_le32(h + 64, (uint32_t)w->sample_rate * 2);
+    put_le16(h + 68, 2);                          // block align
+    put_le16(h + 70, 16);                         // bits per sample
+
+    memcpy(h + 72, "data", 4);
+    put_le32(h + 76, rf64 ? 0xFFFFFFFFu : (uint32_t)w->data_bytes);
+
+    return write_all(w->fd, h, sizeof(h), 0);
+}
+
+static bool flush_staging(struct wav_writer *w) {
+    if (w->staged > 0) {
+        if (!write_all(w->fd, w->staging, w->staged, -1)) w->failed = true;
+        w->staged = 0;
+    }
+    if (!w->failed && !needs_rf64(w) && !write_header(w, false)) w->failed = true;
+    return !w->failed;
+}
+
+struct wav_writer *wav_writer_open(const char *path, int sample_rate) {
+    if (!path || sample_rate <= 0) return NULL;
+    struct wav_writer *w = (struct wav_writer *)calloc(1, sizeof(*w));
+    if (!w) return NULL;
+
+    w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (w->fd < 0) { LOGE("wav_writer: cannot open %s", path); free(w); return NULL; }
+    w->sample_rate = sample_rate;
+
+    if (!write_header(w, false) || lseek(w->fd, WAV_WRITER_HEADER_BYTES, SEEK_SET) < 0) {
+        LOGE("wav_writer: header write failed for %s", path);
+        close(w->fd);
+        free(w);
+        return NULL;
+    }
+    return w;
+}
+
+bool wav_writer_write(struct wav_writer *w, const int16_t *samples, size_t n) {
+    if (!w || w->failed) return false;
+    const uint8_t *src = (const uint8_t *)samples;
+    size_t bytes = n * sizeof(int16_t);
+    while (bytes > 0) {
+        if (w->staged == WAV_STAGING_BYTES && !flush_staging(w)) return false;
+        size_t take = WAV_STAGING_BYTES - w->staged;
+        if (take > bytes) take = bytes;
+        memcpy(w->staging + w->staged, src, take);
+        w->staged += take;
+        w->data_bytes += take;
+        src += take;
+        bytes -= take;
+    }
+    return true;
+}
+
+uint64_t wav_writer_data_bytes(const struct wav_writer *w) {
+    return w ? w->data_bytes : 0;
+}
+
+bool wav_writer_close(struct wav_writer *w) {
+    if (!w) return false;
+    bool ok = flush_staging(w) && write_header(w, needs_rf64(w));
+    if (fsync(w->fd) != 0) ok = false;
+    if (close(w->fd) != 0) ok = false;
+    if (!ok) LOGW("wav_writer: failed to finalize (%llu data bytes)", (unsigned long long)w->data_bytes);
+    free(w);
+    return ok;
+}
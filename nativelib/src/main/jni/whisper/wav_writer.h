@@ -0,0 +1,44 @@
+//
+// wav_writer.h — single-pass 16-bit mono WAV writer with in-place RF64 promotion
+//
+// The only WAV writer: native capture uses it directly, the AudioRecord
+// path through WavWriter (JNI). 80-byte header: a reserved JUNK chunk is
+// turned into ds64 when the file passes the 4 GB RIFF limit, and header
+// sizes are patched on every flush so an interrupted file stays readable.
+//
+//   0  RIFF/RF64  size32
+//   12 JUNK/ds64  (riffSize64, dataSize64, sampleCount64, tableLength)
+//   48 fmt        (16 bytes, PCM)
+//   72 data       size32
+//   80 samples...
+//
+// Not thread-safe: write from the capture thread only.
+//
+
+#ifndef WAV_WRITER_H
+#define WAV_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WAV_WRITER_HEADER_BYTES 80
+
+struct wav_writer;
+
+struct wav_writer *wav_writer_open(const char *path, int sample_rate);
+bool wav_writer_write(struct wav_writer *w, const int16_t *samples, size_t n);
+uint64_t wav_writer_data_bytes(const struct wav_writer *w);
+
+// Flush, write the final header and close. Returns false if any write failed.
+bool wav_writer_close(struct wav_writer *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WAV_WRITER_H